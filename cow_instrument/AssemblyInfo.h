@@ -1,12 +1,23 @@
 #ifndef ASSEMBLYINFO_H
 #define ASSEMBLYINFO_H
 
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 #include <memory>
 #include "cow_ptr.h"
+#include "Span.h"
 #include "Eigen/Core"
+#include "Eigen/Geometry"
 /**
  * Provides a component assembly
+ *
+ * Besides a position and rotation, each assembly keeps a bounding box and the
+ * centroid of the detectors and path components below it, so that queries can
+ * cull whole banks. The box is held in the frame of the assembly, and so is
+ * carried along unchanged when the assembly is moved or rotated with its
+ * sub-tree. Only the ancestors of an edited component need updating, see
+ * updateAncestors.
  */
 template <typename InstTree> class AssemblyInfo {
 public:
@@ -14,20 +25,69 @@ public:
   explicit AssemblyInfo(const InstTree &instrumentTree);
   Eigen::Quaterniond rotation(size_t assemblyIndex) const;
   Eigen::Vector3d position(size_t assemblyIndex) const;
+  Span<Eigen::Quaterniond> rotations() const;
+  Span<Eigen::Vector3d> positions() const;
+  Eigen::AlignedBox3d boundingBox(size_t assemblyIndex) const;
+  Eigen::Vector3d centroid(size_t assemblyIndex) const;
   void moveAssemblyComponents(const std::vector<size_t> &assemblyIndexes,
                               const Eigen::Vector3d &offset);
   void rotateAssemblyComponents(const std::vector<size_t> &assemblyIndexes,
                                 const Eigen::Vector3d &axis,
                                 const double &theta,
                                 const Eigen::Vector3d &center);
+  void moveAssemblyRange(size_t begin, size_t end,
+                         const Eigen::Vector3d &offset);
+  void rotateAssemblyRange(size_t begin, size_t end,
+                           const Eigen::Vector3d &axis, const double &theta,
+                           const Eigen::Vector3d &center);
+
+  /// Corners of the bounds of a component, and the sum of the positions of
+  /// the leaves below it, in world coordinates
+  struct Footprint {
+    Eigen::Vector3d corners[8];
+    /// 1 for a leaf, 0 for an assembly without leaves
+    int cornerCount;
+    Eigen::Vector3d leafSum;
+  };
+  Footprint footprint(size_t assemblyIndex) const;
+  static Footprint leafFootprint(const Eigen::Vector3d &position);
+  template <typename LeafPosition>
+  void updateAncestors(size_t componentIndex, Footprint before,
+                       Footprint after, const LeafPosition &leafPosition);
 
 private:
-  /// Inverted map to get branch node indexes from component indexes
-  std::vector<int64_t> m_componentToBranchNodeIndex;
+  /// Where an assembly sits in the tree
+  struct Node {
+    /// Component index of the assembly
+    size_t component;
+    /// One past the last component index of the sub-tree
+    size_t componentEnd;
+    /// One past the last assembly index of the sub-tree
+    size_t assemblyEnd;
+    /// Parent assembly index, -1 for the root
+    int64_t parent;
+    /// Number of detectors and path components in the sub-tree
+    size_t leafCount;
+  };
+  int64_t innermostAncestor(size_t componentIndex) const;
+  Eigen::AlignedBox3d localBox(size_t assemblyIndex,
+                               const Footprint &footprint) const;
+  static bool mayShrink(const Eigen::AlignedBox3d &box,
+                        const Eigen::AlignedBox3d &before,
+                        const Eigen::AlignedBox3d &after);
+  template <typename LeafPosition>
+  void refit(size_t assemblyIndex, const LeafPosition &leafPosition);
+
+  /// Assembly indexed tree structure. Shared between copies.
+  std::shared_ptr<const std::vector<Node>> m_nodes;
   /// Locally (branch node) indexed positions
   CowPtr<std::vector<Eigen::Vector3d>> m_positions;
   /// Locally (branch node) indexed rotations
   CowPtr<std::vector<Eigen::Quaterniond>> m_rotations;
+  /// Locally (branch node) indexed bounds, in the frame of the assembly
+  CowPtr<std::vector<Eigen::AlignedBox3d>> m_localBoxes;
+  /// Locally (branch node) indexed centroids of the leaves below
+  CowPtr<std::vector<Eigen::Vector3d>> m_centroids;
 };
 
 template <typename InstTree>
@@ -35,26 +95,49 @@ AssemblyInfo<InstTree>::AssemblyInfo(const InstTree &instrumentTree)
     : m_positions(std::make_shared<std::vector<Eigen::Vector3d>>(
           instrumentTree.nBranchNodeComponents())),
       m_rotations(std::make_shared<std::vector<Eigen::Quaterniond>>(
+          instrumentTree.nBranchNodeComponents())),
+      m_localBoxes(std::make_shared<std::vector<Eigen::AlignedBox3d>>(
+          instrumentTree.nBranchNodeComponents())),
+      m_centroids(std::make_shared<std::vector<Eigen::Vector3d>>(
           instrumentTree.nBranchNodeComponents())) {
-  /*
-   * We should fix that so that temporary copies of the rotation and
-   * position vectors are not required. i.e. make them return by const ref.
-   * However I'm not doing that at the moment because the Mocking
-   * layer has grown significantly and these changes will make it quite a lot
-   * more complicated
-   */
-  std::vector<Eigen::Vector3d> allComponentPositions =
-      instrumentTree.startPositions();
-  std::vector<Eigen::Quaterniond> allComponentRotations =
-      instrumentTree.startRotations();
+  const auto &allComponentPositions = instrumentTree.startPositions();
+  const auto &allComponentRotations = instrumentTree.startRotations();
 
   size_t i = 0;
-  auto assemblyComponentIndexes = instrumentTree.branchNodeComponentIndexes();
+  const auto &assemblyComponentIndexes =
+      instrumentTree.branchNodeComponentIndexes();
   for (auto &compIndex : assemblyComponentIndexes) {
     (*m_positions)[i] = allComponentPositions[compIndex];
     (*m_rotations)[i] = allComponentRotations[compIndex];
     ++i;
   }
+
+  // Assemblies are in depth-first order, so the innermost open assembly on
+  // the stack is the parent of the next.
+  std::vector<Node> nodes;
+  nodes.reserve(assemblyComponentIndexes.size());
+  std::vector<size_t> open;
+  for (auto &compIndex : assemblyComponentIndexes) {
+    const auto subTree = instrumentTree.subTree(compIndex);
+    while (!open.empty() && nodes[open.back()].componentEnd <= compIndex) {
+      open.pop_back();
+    }
+    const int64_t parent = open.empty() ? -1 : int64_t(open.back());
+    open.push_back(nodes.size());
+    nodes.push_back(Node{compIndex, subTree.components.end,
+                         subTree.branchNodes.end, parent,
+                         subTree.components.size() -
+                             subTree.branchNodes.size()});
+  }
+  m_nodes = std::make_shared<const std::vector<Node>>(std::move(nodes));
+
+  // Children before parents
+  auto startPosition = [&allComponentPositions](size_t componentIndex) {
+    return allComponentPositions[componentIndex];
+  };
+  for (size_t assemblyIndex = m_nodes->size(); assemblyIndex-- > 0;) {
+    refit(assemblyIndex, startPosition);
+  }
 }
 
 template <typename InstTree>
@@ -68,6 +151,50 @@ AssemblyInfo<InstTree>::rotation(size_t assemblyIndex) const {
   return (*m_rotations)[assemblyIndex];
 }
 
+/// All rotations, assembly (branch node) indexed
+template <typename InstTree>
+Span<Eigen::Quaterniond> AssemblyInfo<InstTree>::rotations() const {
+  return m_rotations.const_ref();
+}
+
+/// All positions, assembly (branch node) indexed
+template <typename InstTree>
+Span<Eigen::Vector3d> AssemblyInfo<InstTree>::positions() const {
+  return m_positions.const_ref();
+}
+
+/**
+ * Axis-aligned bounding box of the detector and path component positions below
+ * an assembly. Empty if there are none.
+ */
+template <typename InstTree>
+Eigen::AlignedBox3d
+AssemblyInfo<InstTree>::boundingBox(size_t assemblyIndex) const {
+  const auto &local = m_localBoxes.const_ref()[assemblyIndex];
+  Eigen::AlignedBox3d box;
+  if (local.isEmpty()) {
+    return box;
+  }
+  const auto &position = m_positions.const_ref()[assemblyIndex];
+  const auto &rotation = m_rotations.const_ref()[assemblyIndex];
+  for (int corner = 0; corner < 8; ++corner) {
+    box.extend(position +
+               rotation * local.corner(
+                              static_cast<Eigen::AlignedBox3d::CornerType>(
+                                  corner)));
+  }
+  return box;
+}
+
+/**
+ * Mean position of the detectors and path components below an assembly. Unlike
+ * position, this is not an average of averages over the sub-assemblies.
+ */
+template <typename InstTree>
+Eigen::Vector3d AssemblyInfo<InstTree>::centroid(size_t assemblyIndex) const {
+  return m_centroids.const_ref()[assemblyIndex];
+}
+
 template <typename InstTree>
 void AssemblyInfo<InstTree>::moveAssemblyComponents(
     const std::vector<size_t> &assemblyIndexes, const Eigen::Vector3d &offset) {
@@ -80,6 +207,7 @@ void AssemblyInfo<InstTree>::moveAssemblyComponents(
    */
   for (auto &assemblyIndex : assemblyIndexes) {
     (*m_positions)[assemblyIndex] += offset;
+    (*m_centroids)[assemblyIndex] += offset;
   }
 }
 template <typename InstTree>
@@ -101,7 +229,237 @@ void AssemblyInfo<InstTree>::rotateAssemblyComponents(
 
     (*m_positions)[assemblyIndex] = transform * (*m_positions)[assemblyIndex];
     (*m_rotations)[assemblyIndex] = rotation * (*m_rotations)[assemblyIndex];
+    (*m_centroids)[assemblyIndex] = transform * (*m_centroids)[assemblyIndex];
+  }
+}
+
+/// Move assemblies [begin, end). As above, sub-components are not moved.
+template <typename InstTree>
+void AssemblyInfo<InstTree>::moveAssemblyRange(size_t begin, size_t end,
+                                               const Eigen::Vector3d &offset) {
+  if (begin == end) {
+    return;
+  }
+  auto &positions = *m_positions;
+  auto &centroids = *m_centroids;
+  for (size_t assemblyIndex = begin; assemblyIndex < end; ++assemblyIndex) {
+    positions[assemblyIndex] += offset;
+    centroids[assemblyIndex] += offset;
   }
 }
-#
+
+/// Rotate assemblies [begin, end). As above, sub-components are not rotated.
+template <typename InstTree>
+void AssemblyInfo<InstTree>::rotateAssemblyRange(
+    size_t begin, size_t end, const Eigen::Vector3d &axis, const double &theta,
+    const Eigen::Vector3d &center) {
+  if (begin == end) {
+    return;
+  }
+
+  using namespace Eigen;
+  const auto transform =
+      Translation3d(center) * AngleAxisd(theta, axis) * Translation3d(-center);
+  const Quaterniond rotation(transform.rotation());
+  auto &positions = *m_positions;
+  auto &rotations = *m_rotations;
+  auto &centroids = *m_centroids;
+  for (size_t assemblyIndex = begin; assemblyIndex < end; ++assemblyIndex) {
+    positions[assemblyIndex] = transform * positions[assemblyIndex];
+    rotations[assemblyIndex] = rotation * rotations[assemblyIndex];
+    centroids[assemblyIndex] = transform * centroids[assemblyIndex];
+  }
+}
+
+/// Footprint of an assembly, from its bounds and centroid
+template <typename InstTree>
+typename AssemblyInfo<InstTree>::Footprint
+AssemblyInfo<InstTree>::footprint(size_t assemblyIndex) const {
+  Footprint footprint;
+  footprint.cornerCount = 0;
+  footprint.leafSum = double((*m_nodes)[assemblyIndex].leafCount) *
+                      m_centroids.const_ref()[assemblyIndex];
+  const auto &local = m_localBoxes.const_ref()[assemblyIndex];
+  if (local.isEmpty()) {
+    return footprint;
+  }
+  const auto &position = m_positions.const_ref()[assemblyIndex];
+  const auto &rotation = m_rotations.const_ref()[assemblyIndex];
+  for (int corner = 0; corner < 8; ++corner) {
+    footprint.corners[corner] =
+        position +
+        rotation *
+            local.corner(static_cast<Eigen::AlignedBox3d::CornerType>(corner));
+  }
+  footprint.cornerCount = 8;
+  return footprint;
+}
+
+/// Footprint of a detector or path component
+template <typename InstTree>
+typename AssemblyInfo<InstTree>::Footprint
+AssemblyInfo<InstTree>::leafFootprint(const Eigen::Vector3d &position) {
+  Footprint footprint;
+  footprint.corners[0] = position;
+  footprint.cornerCount = 1;
+  footprint.leafSum = position;
+  return footprint;
+}
+
+/**
+ * Update the bounds and centroid of every assembly containing componentIndex,
+ * innermost first, after that component (and its sub-tree) has been edited.
+ * Assemblies inside the edited sub-tree moved rigidly and need no update.
+ *
+ * before and after are the footprints of the edited component either side of
+ * the edit. Each centroid is shifted by the change in the leaf sum, and each
+ * box is extended to cover the new footprint. That is exact unless the old
+ * footprint reached a face of the box that the new one does not, so only in
+ * that case is the assembly refitted from its direct children. Moving one
+ * pixel of a bank therefore costs O(depth) unless it leaves the edge of the
+ * bank.
+ *
+ * leafPosition(componentIndex) must give the current position of a detector
+ * or path component.
+ */
+template <typename InstTree>
+template <typename LeafPosition>
+void AssemblyInfo<InstTree>::updateAncestors(size_t componentIndex,
+                                             Footprint before, Footprint after,
+                                             const LeafPosition &leafPosition) {
+  const auto &nodes = *m_nodes;
+  const Eigen::Vector3d shift = after.leafSum - before.leafSum;
+  for (int64_t assemblyIndex = innermostAncestor(componentIndex);
+       assemblyIndex >= 0; assemblyIndex = nodes[assemblyIndex].parent) {
+    const Footprint ancestorBefore = footprint(assemblyIndex);
+    const auto afterBox = localBox(assemblyIndex, after);
+    if (mayShrink(m_localBoxes.const_ref()[assemblyIndex],
+                  localBox(assemblyIndex, before), afterBox)) {
+      refit(assemblyIndex, leafPosition);
+    } else {
+      (*m_localBoxes)[assemblyIndex].extend(afterBox);
+      if (nodes[assemblyIndex].leafCount > 0) {
+        (*m_centroids)[assemblyIndex] +=
+            shift / double(nodes[assemblyIndex].leafCount);
+      }
+    }
+    before = ancestorBefore;
+    after = footprint(assemblyIndex);
+  }
+}
+
+/// Innermost assembly containing componentIndex, excluding the component
+/// itself. -1 if there is none.
+template <typename InstTree>
+int64_t AssemblyInfo<InstTree>::innermostAncestor(size_t componentIndex) const {
+  const auto &nodes = *m_nodes;
+  // Last assembly before componentIndex in depth-first order. Its ancestors,
+  // or itself, contain componentIndex, if anything does.
+  auto it = std::lower_bound(nodes.begin(), nodes.end(), componentIndex,
+                             [](const Node &node, size_t index) {
+                               return node.component < index;
+                             });
+  int64_t assemblyIndex = int64_t(it - nodes.begin()) - 1;
+  while (assemblyIndex >= 0 &&
+         nodes[assemblyIndex].componentEnd <= componentIndex) {
+    assemblyIndex = nodes[assemblyIndex].parent;
+  }
+  return assemblyIndex;
+}
+
+/// Bounds of a footprint in the frame of an assembly
+template <typename InstTree>
+Eigen::AlignedBox3d
+AssemblyInfo<InstTree>::localBox(size_t assemblyIndex,
+                                 const Footprint &footprint) const {
+  const auto &origin = m_positions.const_ref()[assemblyIndex];
+  const Eigen::Quaterniond toLocal =
+      m_rotations.const_ref()[assemblyIndex].conjugate();
+  Eigen::AlignedBox3d box;
+  for (int corner = 0; corner < footprint.cornerCount; ++corner) {
+    box.extend(toLocal * (footprint.corners[corner] - origin));
+  }
+  return box;
+}
+
+/**
+ * True if box may shrink when a child with bounds before moves to after: a
+ * face of box that before reached is no longer reached. Errs towards true,
+ * which only costs a refit.
+ */
+template <typename InstTree>
+bool AssemblyInfo<InstTree>::mayShrink(const Eigen::AlignedBox3d &box,
+                                       const Eigen::AlignedBox3d &before,
+                                       const Eigen::AlignedBox3d &after) {
+  if (before.isEmpty()) {
+    return false;
+  }
+  if (box.isEmpty() || after.isEmpty()) {
+    return true;
+  }
+  const double tolerance = 1e-9 * (1.0 + box.diagonal().norm());
+  for (int axis = 0; axis < 3; ++axis) {
+    if ((before.min()[axis] <= box.min()[axis] + tolerance &&
+         after.min()[axis] > box.min()[axis]) ||
+        (before.max()[axis] >= box.max()[axis] - tolerance &&
+         after.max()[axis] < box.max()[axis])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Recompute the bounds and centroid of one assembly from its direct children:
+ * the bounds of sub-assemblies, and the positions of leaves. Costs
+ * O(children).
+ */
+template <typename InstTree>
+template <typename LeafPosition>
+void AssemblyInfo<InstTree>::refit(size_t assemblyIndex,
+                                   const LeafPosition &leafPosition) {
+  const auto &nodes = *m_nodes;
+  const auto &node = nodes[assemblyIndex];
+  const auto &origin = m_positions.const_ref()[assemblyIndex];
+  const Eigen::Quaterniond toLocal =
+      m_rotations.const_ref()[assemblyIndex].conjugate();
+
+  Eigen::AlignedBox3d box;
+  Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+  size_t childAssembly = assemblyIndex + 1;
+  for (size_t child = node.component + 1; child < node.componentEnd;) {
+    if (childAssembly < nodes.size() &&
+        nodes[childAssembly].component == child) {
+      const auto &childNode = nodes[childAssembly];
+      const auto &childBox = m_localBoxes.const_ref()[childAssembly];
+      if (!childBox.isEmpty()) {
+        const auto &childPosition = m_positions.const_ref()[childAssembly];
+        const auto &childRotation = m_rotations.const_ref()[childAssembly];
+        for (int corner = 0; corner < 8; ++corner) {
+          box.extend(toLocal *
+                     (childPosition +
+                      childRotation *
+                          childBox.corner(
+                              static_cast<Eigen::AlignedBox3d::CornerType>(
+                                  corner)) -
+                      origin));
+        }
+      }
+      sum += double(childNode.leafCount) *
+             m_centroids.const_ref()[childAssembly];
+      child = childNode.componentEnd;
+      childAssembly = childNode.assemblyEnd;
+    } else {
+      const Eigen::Vector3d position = leafPosition(child);
+      box.extend(toLocal * (position - origin));
+      sum += position;
+      ++child;
+    }
+  }
+  (*m_localBoxes)[assemblyIndex] = box;
+  (*m_centroids)[assemblyIndex] =
+      node.leafCount > 0 ? Eigen::Vector3d(sum / double(node.leafCount))
+                         : origin;
+}
+
 #endif
@@ -0,0 +1,163 @@
+#ifndef BIT_FLAGS_H
+#define BIT_FLAGS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+/// Number of bits set in word, without compiler intrinsics
+inline size_t popCountPortable(uint64_t word) {
+  // Sum adjacent bits, then pairs, then nibbles; add the bytes by multiply.
+  word -= (word >> 1) & 0x5555555555555555ULL;
+  word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+  word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return static_cast<size_t>((word * 0x0101010101010101ULL) >> 56);
+}
+
+/// Number of bits set in word, using the compiler builtin where available
+inline size_t popCount(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<size_t>(__builtin_popcountll(word));
+#else
+  return popCountPortable(word);
+#endif
+}
+
+/**
+ BitFlags is a CRTP type holding a fixed number of flags, packed one bit per
+ flag into 64-bit words. Bulk operations work a word at a time, so loops over
+ words are simple enough for the compiler to vectorize.
+
+ Bits beyond size() in the last word are always zero.
+
+ T is the derived class
+ */
+template <class T> class BitFlags {
+public:
+  using Word = uint64_t;
+  static constexpr size_t wordBits = 64;
+
+  BitFlags() = default;
+  explicit BitFlags(size_t count, bool value = false)
+      : m_size(count), m_words((count + wordBits - 1) / wordBits,
+                               value ? ~Word(0) : Word(0)) {
+    clearTail();
+  }
+
+  size_t size() const { return m_size; }
+
+  bool operator[](size_t pos) const {
+    return (m_words[pos / wordBits] >> (pos % wordBits)) & 1;
+  }
+
+  void set(size_t pos, bool value = true) {
+    const Word bit = Word(1) << (pos % wordBits);
+    if (value) {
+      m_words[pos / wordBits] |= bit;
+    } else {
+      m_words[pos / wordBits] &= ~bit;
+    }
+  }
+
+  void reset(size_t pos) { set(pos, false); }
+
+  /// Set every flag at the given positions
+  void set(const std::vector<size_t> &positions) {
+    for (auto pos : positions) {
+      checkPosition(pos);
+    }
+    for (auto pos : positions) {
+      m_words[pos / wordBits] |= Word(1) << (pos % wordBits);
+    }
+  }
+
+  /// Set all flags in [begin, end). Whole words are filled directly.
+  void setRange(size_t begin, size_t end) {
+    if (begin > end || end > m_size) {
+      throw std::out_of_range("BitFlags::setRange: range out of bounds");
+    }
+    if (begin == end) {
+      return;
+    }
+    const size_t first = begin / wordBits;
+    const size_t last = (end - 1) / wordBits;
+    const Word firstMask = ~Word(0) << (begin % wordBits);
+    const Word lastMask = ~Word(0) >> (wordBits - 1 - (end - 1) % wordBits);
+    if (first == last) {
+      m_words[first] |= firstMask & lastMask;
+      return;
+    }
+    m_words[first] |= firstMask;
+    for (size_t i = first + 1; i < last; ++i) {
+      m_words[i] = ~Word(0);
+    }
+    m_words[last] |= lastMask;
+  }
+
+  /// Union with other
+  T &operator|=(const BitFlags &other) {
+    checkSize(other);
+    for (size_t i = 0; i < m_words.size(); ++i) {
+      m_words[i] |= other.m_words[i];
+    }
+    return static_cast<T &>(*this);
+  }
+
+  /// Intersection with other
+  T &operator&=(const BitFlags &other) {
+    checkSize(other);
+    for (size_t i = 0; i < m_words.size(); ++i) {
+      m_words[i] &= other.m_words[i];
+    }
+    return static_cast<T &>(*this);
+  }
+
+  /// Number of flags set
+  size_t count() const {
+    size_t total = 0;
+    for (auto word : m_words) {
+      total += popCount(word);
+    }
+    return total;
+  }
+
+  bool operator==(const BitFlags &other) const {
+    return m_size == other.m_size && m_words == other.m_words;
+  }
+  bool operator!=(const BitFlags &other) const { return !(*this == other); }
+
+  /// Underlying words. Flag i is bit i % 64 of word i / 64.
+  const std::vector<Word> &words() const { return m_words; }
+
+  T *clone() const { return new T(static_cast<T const &>(*this)); }
+
+protected:
+  // This is used as base class only, cannot delete polymorphically, so
+  // destructor is protected.
+  ~BitFlags() = default;
+
+private:
+  void checkPosition(size_t pos) const {
+    if (pos >= m_size) {
+      throw std::out_of_range("BitFlags: position out of range");
+    }
+  }
+
+  void checkSize(const BitFlags &other) const {
+    if (m_size != other.m_size) {
+      throw std::invalid_argument("BitFlags: size mismatch");
+    }
+  }
+
+  void clearTail() {
+    if (m_size % wordBits != 0) {
+      m_words.back() &= ~(~Word(0) << (m_size % wordBits));
+    }
+  }
+
+  size_t m_size = 0;
+  std::vector<Word> m_words;
+};
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef CHUNKED_VECTOR_H
+#define CHUNKED_VECTOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+/**
+ * Fixed length vector held as shared pages of PageSize elements. Copies share
+ * all pages, and a write copies only the page it touches, so copies that
+ * differ in a few elements cost little more memory than one.
+ *
+ * Held behind a CowPtr, a first write to a shared copy duplicates only the
+ * page table rather than the whole array.
+ *
+ * Writes through different pages may run concurrently. Writes through the
+ * same page may not, as the first may copy it.
+ */
+template <typename T, size_t PageSize = 1024> class ChunkedVector {
+public:
+  static constexpr size_t pageSize = PageSize;
+
+  class const_iterator
+      : public std::iterator<std::random_access_iterator_tag, T, ptrdiff_t,
+                             const T *, const T &> {
+  public:
+    const_iterator(const ChunkedVector *vector, size_t index)
+        : m_vector(vector), m_index(index) {}
+    const T &operator*() const { return (*m_vector)[m_index]; }
+    const T *operator->() const { return &(*m_vector)[m_index]; }
+    const T &operator[](ptrdiff_t n) const { return (*m_vector)[m_index + n]; }
+    const_iterator &operator++() {
+      ++m_index;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator before = *this;
+      ++m_index;
+      return before;
+    }
+    const_iterator &operator--() {
+      --m_index;
+      return *this;
+    }
+    const_iterator operator--(int) {
+      const_iterator before = *this;
+      --m_index;
+      return before;
+    }
+    const_iterator &operator+=(ptrdiff_t n) {
+      m_index += n;
+      return *this;
+    }
+    const_iterator &operator-=(ptrdiff_t n) {
+      m_index -= n;
+      return *this;
+    }
+    const_iterator operator+(ptrdiff_t n) const {
+      return const_iterator(m_vector, m_index + n);
+    }
+    friend const_iterator operator+(ptrdiff_t n, const const_iterator &it) {
+      return it + n;
+    }
+    const_iterator operator-(ptrdiff_t n) const {
+      return const_iterator(m_vector, m_index - n);
+    }
+    ptrdiff_t operator-(const const_iterator &other) const {
+      return ptrdiff_t(m_index) - ptrdiff_t(other.m_index);
+    }
+    bool operator==(const const_iterator &other) const {
+      return m_index == other.m_index;
+    }
+    bool operator!=(const const_iterator &other) const {
+      return m_index != other.m_index;
+    }
+    bool operator<(const const_iterator &other) const {
+      return m_index < other.m_index;
+    }
+    bool operator>(const const_iterator &other) const {
+      return m_index > other.m_index;
+    }
+    bool operator<=(const const_iterator &other) const {
+      return m_index <= other.m_index;
+    }
+    bool operator>=(const const_iterator &other) const {
+      return m_index >= other.m_index;
+    }
+
+  private:
+    const ChunkedVector *m_vector;
+    size_t m_index;
+  };
+
+  ChunkedVector() = default;
+
+  explicit ChunkedVector(size_t count, const T &value = T()) : m_size(count) {
+    m_pages.reserve(pageCount());
+    for (size_t page = 0; page < pageCount(); ++page) {
+      m_pages.push_back(
+          std::make_shared<std::vector<T>>(pageLength(page), value));
+    }
+  }
+
+  ChunkedVector(const std::vector<T> &values) : m_size(values.size()) {
+    m_pages.reserve(pageCount());
+    for (size_t page = 0; page < pageCount(); ++page) {
+      auto first = values.begin() + page * PageSize;
+      m_pages.push_back(
+          std::make_shared<std::vector<T>>(first, first + pageLength(page)));
+    }
+  }
+
+  size_t size() const { return m_size; }
+
+  const T &operator[](size_t pos) const {
+    return (*m_pages[pos / PageSize])[pos % PageSize];
+  }
+
+  /// Write access. Copies the page holding pos if it is shared.
+  T &operator[](size_t pos) {
+    return mutablePage(pos / PageSize)[pos % PageSize];
+  }
+
+  size_t pageCount() const { return (m_size + PageSize - 1) / PageSize; }
+
+  /// Number of elements in page, PageSize for all but the last page
+  size_t pageLength(size_t page) const {
+    return std::min(PageSize, m_size - page * PageSize);
+  }
+
+  const T *page(size_t page) const { return m_pages[page]->data(); }
+
+  /// Write access to a whole page. Copies the page if it is shared.
+  T *mutablePage(size_t page) {
+    auto &held = m_pages[page];
+    if (held.use_count() > 1) {
+      held = std::make_shared<std::vector<T>>(*held);
+    }
+    return held->data();
+  }
+
+  /// True if page is held in common with other, i.e. not yet copied
+  bool sharesPage(const ChunkedVector &other, size_t page) const {
+    return m_pages[page] == other.m_pages[page];
+  }
+
+  std::vector<T> toVector() const {
+    std::vector<T> values;
+    values.reserve(m_size);
+    for (const auto &page : m_pages) {
+      values.insert(values.end(), page->begin(), page->end());
+    }
+    return values;
+  }
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, m_size); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+private:
+  size_t m_size = 0;
+  std::vector<std::shared_ptr<std::vector<T>>> m_pages;
+};
+
+template <typename T, size_t PageSize>
+constexpr size_t ChunkedVector<T, PageSize>::pageSize;
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef COMPONENT_INFO_H
 #define COMPONENT_INFO_H
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <stdexcept>
@@ -13,12 +14,19 @@
 #include "ComponentProxy.h"
 #include "cow_ptr.h"
 #include "DetectorInfo.h"
+#include "EditTransaction.h"
+#include "SubTree.h"
 
 /**
  * ComponentInfo type. Provides meta-data an behaviour for working with a
  * FlatTree at the component level. Wraps DetectorInfo and PatchComponentInfo
  * and therefore
  * gives a Component only view of the data and associated operations.
+ *
+ * L1/L2 are recalculated lazily, on the first read after edits (see
+ * DetectorInfo). Wrap several edits in an
+ * EditTransaction<ComponentInfo<InstTree>> to recalculate them at its commit
+ * instead.
  */
 template <typename InstTree> class ComponentInfo {
 public:
@@ -35,28 +43,47 @@ public:
 
   const InstTree &const_instrumentTree() const;
 
+  const DetectorInfo<InstTree> &detectorInfo() const;
+
+  const AssemblyInfo<InstTree> &assemblyInfo() const;
+
   void move(size_t componentIndex, const Eigen::Vector3d &offset);
 
   void rotate(size_t componentIndex, const Eigen::Vector3d &axis,
               const double &theta, const Eigen::Vector3d &center);
 
 private:
+  friend class EditTransaction<ComponentInfo<InstTree>>;
+  void openEdit();
+  void commitEdit();
   /// initalization
   void init();
-  /// Make maps with component index as key.
-  void makeInvertedMaps();
+  /// Make the table of local indexes, keyed by component index.
+  void makeLocalIndexes();
+  typename AssemblyInfo<InstTree>::Footprint
+  footprint(const SubTree &subTree) const;
+  /// Update the assembly bounds that contain an edited component.
+  void updateAssemblyBounds(
+      const SubTree &subTree,
+      const typename AssemblyInfo<InstTree>::Footprint &before);
   /// Detector info
   DetectorInfo<InstTree> m_detectorInfo;
   /// Assembly info (branched nodes)
   AssemblyInfo<InstTree> m_assemblyInfo;
-  /// Instrument tree
-  const InstTree &m_instrumentTree;
-  /// Inverted map to get detector indexes from component indexes
-  std::vector<int64_t> m_componentToDetectorIndex;
-  /// Inverted map to get path component indexes  from component indexes
-  std::vector<int64_t> m_componentToPathIndex;
-  /// Inverted map to get branch node indexes from component indexes
-  std::vector<int64_t> m_componentToBranchNodeIndex;
+  /// Instrument tree, owned by m_detectorInfo
+  const InstTree *m_instrumentTree;
+  /// Kind of component held in the top bits of a local index entry
+  enum LocalType : uint64_t {
+    DetectorType = 0,
+    PathComponentType = 1,
+    BranchNodeType = 2
+  };
+  static const int localTypeShift = 62;
+  static const uint64_t localIndexMask = (uint64_t(1) << localTypeShift) - 1;
+  /// Per component, its kind (LocalType) in the top two bits and its index
+  /// among detectors, path components or branch nodes in the rest, so that
+  /// dispatching a lookup is a single load.
+  std::shared_ptr<const std::vector<uint64_t>> m_componentToLocalIndex;
 };
 
 template <typename InstTree>
@@ -64,10 +91,7 @@ ComponentInfo<InstTree>::ComponentInfo(
     const DetectorInfo<InstTree> &detectorInfo)
     : m_detectorInfo(detectorInfo),
       m_assemblyInfo(detectorInfo.const_instrumentTree()),
-      m_instrumentTree(m_detectorInfo.const_instrumentTree()),
-      m_componentToDetectorIndex(m_instrumentTree.componentSize(), -1),
-      m_componentToPathIndex(m_instrumentTree.componentSize(), -1),
-      m_componentToBranchNodeIndex(m_instrumentTree.componentSize(), -1)
+      m_instrumentTree(&m_detectorInfo.const_instrumentTree())
 
 {
 
@@ -79,10 +103,7 @@ ComponentInfo<InstTree>::ComponentInfo(
     const DetectorInfo<InstTree> &&detectorInfo)
     : m_detectorInfo(std::move(detectorInfo)),
       m_assemblyInfo(m_detectorInfo.const_instrumentTree()),
-      m_instrumentTree(m_detectorInfo.const_instrumentTree()),
-      m_componentToDetectorIndex(m_instrumentTree.componentSize(), -1),
-      m_componentToPathIndex(m_instrumentTree.componentSize(), -1),
-      m_componentToBranchNodeIndex(m_instrumentTree.componentSize(), -1)
+      m_instrumentTree(&m_detectorInfo.const_instrumentTree())
 
 {
 
@@ -91,153 +112,155 @@ ComponentInfo<InstTree>::ComponentInfo(
 
 
 template <typename InstrTree> void ComponentInfo<InstrTree>::init() {
-  makeInvertedMaps();
+  makeLocalIndexes();
 }
 
-template <typename InstTree> void ComponentInfo<InstTree>::makeInvertedMaps() {
+template <typename InstTree> void ComponentInfo<InstTree>::makeLocalIndexes() {
 
-  // Invert the map. Allows us to use component index as a key.
-  auto detToComponent = m_instrumentTree.detectorComponentIndexes();
-  auto pathToComponent = m_instrumentTree.pathComponentIndexes();
-  auto branchNodeToComponent = m_instrumentTree.branchNodeComponentIndexes();
-  for (size_t i = 0; i < detToComponent.size(); ++i) {
-    m_componentToDetectorIndex[detToComponent[i]] = i;
-  }
-  for (size_t i = 0; i < pathToComponent.size(); ++i) {
-    m_componentToPathIndex[pathToComponent[i]] = i;
-  }
-  for (size_t i = 0; i < branchNodeToComponent.size(); ++i) {
-    m_componentToBranchNodeIndex[branchNodeToComponent[i]] = i;
-  }
+  const size_t componentSize = m_instrumentTree->componentSize();
+  std::vector<uint64_t> componentToLocalIndex(componentSize);
+  auto assign = [&](const std::vector<IndexType> &componentIndexes,
+                    LocalType type) {
+    for (size_t i = 0; i < componentIndexes.size(); ++i) {
+      componentToLocalIndex[componentIndexes[i]] =
+          (uint64_t(type) << localTypeShift) | i;
+    }
+  };
+  // Later kinds take precedence, should a component be listed twice.
+  assign(m_instrumentTree->branchNodeComponentIndexes(), BranchNodeType);
+  assign(m_instrumentTree->pathComponentIndexes(), PathComponentType);
+  assign(m_instrumentTree->detectorComponentIndexes(), DetectorType);
+  m_componentToLocalIndex = std::make_shared<const std::vector<uint64_t>>(
+      std::move(componentToLocalIndex));
 }
 
 template <typename InstTree>
 Eigen::Vector3d ComponentInfo<InstTree>::position(size_t componentIndex) const {
 
-  auto detIndex = m_componentToDetectorIndex[componentIndex];
-  if (detIndex >= 0) {
-    return m_detectorInfo.position(detIndex);
-  }
-
-  auto pathIndex = m_componentToPathIndex[componentIndex];
-  if (pathIndex >= 0) {
-    return m_detectorInfo.pathComponentInfo().position(pathIndex);
+  const uint64_t local = (*m_componentToLocalIndex)[componentIndex];
+  const size_t index = local & localIndexMask;
+  switch (local >> localTypeShift) {
+  case DetectorType:
+    return m_detectorInfo.position(index);
+  case PathComponentType:
+    return m_detectorInfo.pathComponentInfo().position(index);
+  default:
+    return m_assemblyInfo.position(index);
   }
-  auto assemblyIndex = m_componentToBranchNodeIndex[componentIndex];
-  return m_assemblyInfo.position(assemblyIndex);
 }
 
 template <typename InstTree>
 Eigen::Quaterniond
 ComponentInfo<InstTree>::rotation(size_t componentIndex) const {
-  auto detIndex = m_componentToDetectorIndex[componentIndex];
-  if (detIndex >= 0) {
-    return m_detectorInfo.rotation(detIndex);
-  }
 
-  auto pathIndex = m_componentToPathIndex[componentIndex];
-  if (pathIndex >= 0) {
-    return m_detectorInfo.pathComponentInfo().rotation(pathIndex);
+  const uint64_t local = (*m_componentToLocalIndex)[componentIndex];
+  const size_t index = local & localIndexMask;
+  switch (local >> localTypeShift) {
+  case DetectorType:
+    return m_detectorInfo.rotation(index);
+  case PathComponentType:
+    return m_detectorInfo.pathComponentInfo().rotation(index);
+  default:
+    return m_assemblyInfo.rotation(index);
   }
-  auto assemblyIndex = m_componentToBranchNodeIndex[componentIndex];
-  return m_assemblyInfo.rotation(assemblyIndex);
 }
 
 template <typename InstTree>
 size_t ComponentInfo<InstTree>::componentSize() const {
-  return m_instrumentTree.componentSize();
+  return m_instrumentTree->componentSize();
 }
 
 template <typename InstTree>
 const InstTree &ComponentInfo<InstTree>::const_instrumentTree() const {
-  return m_instrumentTree;
+  return *m_instrumentTree;
 }
 
+/**
+ * Detector and path component data. Use its bulk accessors, such as
+ * positions() and pathComponentInfo().positions(), for whole-array reads.
+ */
 template <typename InstTree>
-void ComponentInfo<InstTree>::move(size_t componentIndex,
-                                   const Eigen::Vector3d &offset) {
+const DetectorInfo<InstTree> &ComponentInfo<InstTree>::detectorInfo() const {
+  return m_detectorInfo;
+}
 
-  // All "connected" component indexes
-  const std::vector<size_t> componentIndexes =
-      m_instrumentTree.subTreeIndexes(componentIndex);
-
-  std::vector<size_t>
-      detectorsToMove; // Cache of detector indexes which will be moved.
-  std::vector<size_t> pathComponentsToMove; // Cache of path component indexes
-                                            // which will be moved
-  std::vector<size_t> assemblyComponentsToMove; // Cache of assembly component
-                                                // indexes which will be moved.
-
-  detectorsToMove.reserve(componentIndexes.size());
-  pathComponentsToMove.reserve(componentIndexes.size());
-  assemblyComponentsToMove.reserve(componentIndexes.size());
-  for (auto &compIndex : componentIndexes) {
-    auto detIndex = m_componentToDetectorIndex[compIndex];
-    if (detIndex >= 0) {
-      detectorsToMove.push_back(detIndex);
-    }
+/// Assembly (branch node) data, for whole-array reads
+template <typename InstTree>
+const AssemblyInfo<InstTree> &ComponentInfo<InstTree>::assemblyInfo() const {
+  return m_assemblyInfo;
+}
 
-    auto pathIndex = m_componentToPathIndex[compIndex];
-    if (pathIndex >= 0) {
-      pathComponentsToMove.push_back(pathIndex);
-    }
+/**
+ * Move a component and everything below it. The sub-tree is contiguous in
+ * every index (see FlatTree::subTree), so each kind of component is updated
+ * by a single loop, without allocating. Assembly bounds inside the sub-tree
+ * move with it; only those of its ancestors are refitted.
+ */
+template <typename InstTree>
+void ComponentInfo<InstTree>::move(size_t componentIndex,
+                                   const Eigen::Vector3d &offset) {
 
-    auto assemblyIndex = m_componentToBranchNodeIndex[compIndex];
-    if (assemblyIndex >= 0) {
-      /*
-       * Note that sub-components of the assembly are handled at the
-       * component-index level (see FlatTree::subTree).
-       */
-      assemblyComponentsToMove.push_back(assemblyIndex);
-    }
-  }
+  const SubTree subTree = m_instrumentTree->subTree(componentIndex);
+  const auto before = footprint(subTree);
 
-  m_assemblyInfo.moveAssemblyComponents(assemblyComponentsToMove, offset);
-  m_detectorInfo.moveDetectors(detectorsToMove, offset);
-  m_detectorInfo.movePathComponents(pathComponentsToMove, offset);
+  m_assemblyInfo.moveAssemblyRange(subTree.branchNodes.begin,
+                                   subTree.branchNodes.end, offset);
+  m_detectorInfo.moveDetectorRange(subTree.detectors.begin,
+                                   subTree.detectors.end, offset);
+  m_detectorInfo.movePathComponentRange(subTree.pathComponents.begin,
+                                        subTree.pathComponents.end, offset);
+  updateAssemblyBounds(subTree, before);
 }
 
+/// Rotate a component and everything below it. See move.
 template <typename InstTree>
 void ComponentInfo<InstTree>::rotate(size_t componentIndex,
                                      const Eigen::Vector3d &axis,
                                      const double &theta,
                                      const Eigen::Vector3d &center) {
 
-  // All "connected" component indexes
-  const std::vector<size_t> componentIndexes =
-      m_instrumentTree.subTreeIndexes(componentIndex);
-
-  std::vector<size_t>
-      detectorsToRotate; // Cache of detector indexes which will be rotated.
-  std::vector<size_t> pathComponentsToRotate; // Cache of path component indexes
-                                              // which will be rotated
-  std::vector<size_t>
-      assemblyComponentsToRotate; // Cache of assembly indexes to rotate
-  detectorsToRotate.reserve(componentIndexes.size());
-  pathComponentsToRotate.reserve(componentIndexes.size());
-  assemblyComponentsToRotate.reserve(componentIndexes.size());
-  for (auto &compIndex : componentIndexes) {
-    auto detIndex = m_componentToDetectorIndex[compIndex];
-    if (detIndex >= 0) {
-      detectorsToRotate.push_back(detIndex);
-    }
-
-    auto pathIndex = m_componentToPathIndex[compIndex];
-    if (pathIndex >= 0) {
-      pathComponentsToRotate.push_back(pathIndex);
-    }
+  const SubTree subTree = m_instrumentTree->subTree(componentIndex);
+  const auto before = footprint(subTree);
+
+  m_assemblyInfo.rotateAssemblyRange(subTree.branchNodes.begin,
+                                     subTree.branchNodes.end, axis, theta,
+                                     center);
+  m_detectorInfo.rotateDetectorRange(subTree.detectors.begin,
+                                     subTree.detectors.end, axis, theta,
+                                     center);
+  m_detectorInfo.rotatePathComponentRange(subTree.pathComponents.begin,
+                                          subTree.pathComponents.end, axis,
+                                          theta, center);
+  updateAssemblyBounds(subTree, before);
+}
 
-    auto assemblyIndex = m_componentToBranchNodeIndex[compIndex];
-    if (assemblyIndex >= 0) {
-      assemblyComponentsToRotate.push_back(assemblyIndex);
-    }
+/// Footprint of the root of a sub-tree, for updating the assembly bounds
+template <typename InstTree>
+typename AssemblyInfo<InstTree>::Footprint
+ComponentInfo<InstTree>::footprint(const SubTree &subTree) const {
+  // Only an assembly has assemblies in its sub-tree, itself first
+  if (subTree.branchNodes.size() > 0) {
+    return m_assemblyInfo.footprint(subTree.branchNodes.begin);
   }
+  return AssemblyInfo<InstTree>::leafFootprint(
+      position(subTree.components.begin));
+}
 
-  m_assemblyInfo.rotateAssemblyComponents(assemblyComponentsToRotate, axis,
-                                          theta, center);
-  m_detectorInfo.rotateDetectors(detectorsToRotate, axis, theta, center);
-  m_detectorInfo.rotatePathComponents(pathComponentsToRotate, axis, theta,
-                                       center);
+template <typename InstTree>
+void ComponentInfo<InstTree>::updateAssemblyBounds(
+    const SubTree &subTree,
+    const typename AssemblyInfo<InstTree>::Footprint &before) {
+  m_assemblyInfo.updateAncestors(
+      subTree.components.begin, before, footprint(subTree),
+      [this](size_t leafIndex) { return position(leafIndex); });
+}
+
+template <typename InstTree> void ComponentInfo<InstTree>::openEdit() {
+  m_detectorInfo.openEdit();
+}
+
+template <typename InstTree> void ComponentInfo<InstTree>::commitEdit() {
+  m_detectorInfo.commitEdit();
 }
 
 #endif
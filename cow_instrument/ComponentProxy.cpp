@@ -1,18 +1,10 @@
 #include "ComponentProxy.h"
 #include "Component.h"
-#include <utility>
+#include <stdexcept>
 
-ComponentProxy::ComponentProxy(const ComponentIdType &id)
-    : m_previous(-1), m_componentId(id) {}
-
-ComponentProxy::ComponentProxy(size_t previous, const ComponentIdType &id)
-    : m_previous(previous), m_componentId(id) {}
-
-ComponentProxy::ComponentProxy(size_t previous, const ComponentIdType &id,
-                               std::vector<size_t> &&children)
-    : m_previous(previous), m_componentId(id), m_next(std::move(children)) {}
-
-void ComponentProxy::addChild(size_t child) { m_next.emplace_back(child); }
+ComponentProxy::ComponentProxy(int64_t parent, Span<IndexType> children,
+                               const ComponentIdType &id)
+    : m_previous(parent), m_next(children), m_componentId(id) {}
 
 bool ComponentProxy::hasParent() const { return m_previous >= 0; }
 
@@ -29,18 +21,40 @@ size_t ComponentProxy::child(size_t index) const {
 
 size_t ComponentProxy::nChildren() const { return m_next.size(); }
 
-const std::vector<size_t> &ComponentProxy::children() const { return m_next; }
+Span<IndexType> ComponentProxy::children() const { return m_next; }
 
 const ComponentIdType ComponentProxy::componentId() const {
   return m_componentId;
 }
 
 bool ComponentProxy::operator==(const ComponentProxy &other) const {
-  return m_componentId == other.componentId() && m_next == other.children() &&
-         m_previous == other.parent();
+  return m_componentId == other.componentId() &&
+         m_next == other.m_next &&
+         m_previous == int64_t(other.parent());
 }
 
 bool ComponentProxy::operator!=(const ComponentProxy &other) const {
   return !(this->operator==(other));
 }
 
+void makeChildIndexes(const std::vector<int64_t> &parents,
+                      std::vector<IndexType> &childOffsets,
+                      std::vector<IndexType> &children) {
+  const size_t size = parents.size();
+  childOffsets.assign(size + 1, 0);
+  for (auto parent : parents) {
+    if (parent >= 0) {
+      ++childOffsets[parent + 1];
+    }
+  }
+  for (size_t i = 0; i < size; ++i) {
+    childOffsets[i + 1] += childOffsets[i];
+  }
+  children.resize(childOffsets[size]);
+  std::vector<IndexType> next(childOffsets.begin(), childOffsets.end() - 1);
+  for (size_t i = 0; i < size; ++i) {
+    if (parents[i] >= 0) {
+      children[next[parents[i]]++] = IndexType(i);
+    }
+  }
+}
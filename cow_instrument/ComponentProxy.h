@@ -5,6 +5,8 @@
 #include <cstddef>
 #include <cstdint>
 #include "IdType.h"
+#include "IndexType.h"
+#include "Span.h"
 
 class Component;
 
@@ -20,27 +22,25 @@ class Component;
  *linked-list representation,
  * but without the need for pointers to objects, and hopefully less access to
  *main memory and better cache locality.
+ *
+ * A proxy is a lightweight view onto the topology arrays of its tree (see
+ * makeChildIndexes), handed out by value. It owns nothing, and is valid for as
+ * long as the tree it came from.
  */
 class ComponentProxy {
 public:
-  ComponentProxy(const ComponentIdType &id);
-
-  ComponentProxy(size_t previous, const ComponentIdType &id);
-
-  ComponentProxy(size_t previous, const ComponentIdType &id,
-                 std::vector<size_t> &&children);
+  ComponentProxy(int64_t parent, Span<IndexType> children,
+                 const ComponentIdType &id);
 
   bool hasParent() const;
 
   bool hasChildren() const;
 
-  void addChild(size_t child);
-
   size_t parent() const;
 
   size_t child(size_t index) const;
 
-  const std::vector<size_t> &children() const;
+  Span<IndexType> children() const;
 
   const ComponentIdType componentId() const; // Not strictly needed.
 
@@ -52,10 +52,19 @@ public:
 private:
   /// Parent component, negative index indicates no parent.
   int64_t m_previous;
-  /// Next or child nodes (owned)
-  std::vector<size_t> m_next; // Children
+  /// Next or child nodes (not owned)
+  Span<IndexType> m_next;
   /// Identifier for the component.
   ComponentIdType m_componentId;
 };
 
+/**
+ * Child lists in compressed sparse row form, built from the parent of each
+ * component (-1 for none). The children of component i are
+ * children[childOffsets[i], childOffsets[i + 1]), in ascending order.
+ */
+void makeChildIndexes(const std::vector<int64_t> &parents,
+                      std::vector<IndexType> &childOffsets,
+                      std::vector<IndexType> &children);
+
 #endif
@@ -0,0 +1,490 @@
+#ifndef DETECTOR_BVH_H
+#define DETECTOR_BVH_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include "DetectorInfo.h"
+#include "SubTree.h"
+
+/**
+ * DetectorBVH. Bounding volume hierarchy over detector positions, for ray,
+ * nearest-detector, box and cone queries without scanning every detector.
+ *
+ * Detectors carry no shape, so each is treated as a sphere of a fixed radius
+ * about its position, e.g. half the pixel pitch.
+ *
+ * The upper levels of the hierarchy follow the assembly structure of the
+ * instrument tree: every component with detectors below it gets a node.
+ * Large groups of detectors sharing a parent, such as the pixels of a bank,
+ * are split further at the median along their longest extent.
+ *
+ * Nodes are held in depth-first order, so each sub-tree of nodes is a
+ * contiguous range. After a component is moved or rotated, refit updates only
+ * the boxes below and above the node of that component.
+ *
+ * Positions are copied from a DetectorInfo at construction and refit. For a
+ * scanning DetectorInfo, the positions at the first time index are used.
+ */
+template <typename InstTree> class DetectorBVH {
+public:
+  static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+  template <typename PositionStorage>
+  DetectorBVH(const DetectorInfo<InstTree, PositionStorage> &detectorInfo,
+              double detectorRadius, size_t leafSize = 8);
+
+  template <typename PositionStorage>
+  void refit(const DetectorInfo<InstTree, PositionStorage> &detectorInfo);
+
+  template <typename PositionStorage>
+  void refit(const DetectorInfo<InstTree, PositionStorage> &detectorInfo,
+             size_t componentIndex);
+
+  size_t intersect(const Eigen::Vector3d &origin,
+                   const Eigen::Vector3d &direction, double &distance) const;
+
+  size_t nearest(const Eigen::Vector3d &point) const;
+
+  void inBox(const Eigen::AlignedBox3d &box, std::vector<size_t> &out) const;
+
+  void inCone(const Eigen::Vector3d &apex, const Eigen::Vector3d &axis,
+              double halfAngle, std::vector<size_t> &out) const;
+
+  size_t nodeCount() const { return m_nodes.size(); }
+
+private:
+  struct Node {
+    Eigen::AlignedBox3d box;
+    /// Detectors of the node, [begin, end) into m_order
+    size_t begin;
+    size_t end;
+    /// One past the last node of this node's sub-tree
+    size_t subTreeEnd;
+    size_t parent;
+  };
+
+  bool isLeaf(size_t node) const {
+    return m_nodes[node].subTreeEnd == node + 1;
+  }
+
+  size_t newNode(size_t parent);
+  void finishNode(size_t node);
+  void buildComponent(const InstTree &tree, size_t componentIndex,
+                      size_t parent);
+  void buildSplit(size_t node, std::vector<size_t>::iterator begin,
+                  std::vector<size_t>::iterator end);
+  void fitNode(size_t node);
+  void refitAncestors(size_t node);
+
+  double m_radius;
+  size_t m_leafSize;
+  /// Detector indexed positions
+  std::vector<Eigen::Vector3d> m_positions;
+  /// Detector indexes, grouped so that each node's detectors are contiguous
+  std::vector<size_t> m_order;
+  std::vector<Node> m_nodes;
+  /// Node of each component with detectors below it, or npos
+  std::vector<size_t> m_componentNode;
+  /// Leaf node holding each detector
+  std::vector<size_t> m_detectorLeaf;
+};
+
+template <typename InstTree> constexpr size_t DetectorBVH<InstTree>::npos;
+
+/**
+ * Build the hierarchy.
+ * @param detectorInfo : Source of detector positions and the instrument tree
+ * @param detectorRadius : Radius of the sphere standing in for each detector
+ * @param leafSize : Most detectors held by a node before it is split
+ */
+template <typename InstTree>
+template <typename PositionStorage>
+DetectorBVH<InstTree>::DetectorBVH(
+    const DetectorInfo<InstTree, PositionStorage> &detectorInfo,
+    double detectorRadius, size_t leafSize)
+    : m_radius(detectorRadius), m_leafSize(std::max<size_t>(leafSize, 1)) {
+  const auto &tree = detectorInfo.const_instrumentTree();
+  const size_t nDetectors = detectorInfo.detectorSize();
+  m_positions.resize(nDetectors);
+  for (size_t i = 0; i < nDetectors; ++i) {
+    m_positions[i] = detectorInfo.position(i, 0);
+  }
+  m_order.reserve(nDetectors);
+  m_componentNode.assign(tree.componentSize(), npos);
+  m_detectorLeaf.assign(nDetectors, npos);
+  if (nDetectors > 0) {
+    buildComponent(tree, 0, npos);
+  }
+}
+
+template <typename InstTree>
+size_t DetectorBVH<InstTree>::newNode(size_t parent) {
+  Node node;
+  node.begin = m_order.size();
+  node.end = node.begin;
+  node.subTreeEnd = npos;
+  node.parent = parent;
+  m_nodes.push_back(node);
+  return m_nodes.size() - 1;
+}
+
+template <typename InstTree>
+void DetectorBVH<InstTree>::finishNode(size_t node) {
+  m_nodes[node].end = m_order.size();
+  m_nodes[node].subTreeEnd = m_nodes.size();
+  if (isLeaf(node)) {
+    for (size_t i = m_nodes[node].begin; i < m_nodes[node].end; ++i) {
+      m_detectorLeaf[m_order[i]] = node;
+    }
+  }
+  fitNode(node);
+}
+
+/**
+ * Node for componentIndex. Sub-assemblies get nodes of their own. Detectors
+ * directly below the component, and the component itself if a detector, are
+ * split by buildSplit.
+ */
+template <typename InstTree>
+void DetectorBVH<InstTree>::buildComponent(const InstTree &tree,
+                                           size_t componentIndex,
+                                           size_t parent) {
+  const SubTree subTree = tree.subTree(componentIndex);
+  const size_t node = newNode(parent);
+  m_componentNode[componentIndex] = node;
+
+  std::vector<size_t> direct;
+  if (tree.detIndexToCompIndex(subTree.detectors.begin) == componentIndex) {
+    direct.push_back(subTree.detectors.begin);
+  }
+  for (auto child : tree.proxyAt(componentIndex).children()) {
+    const SubTree childTree = tree.subTree(child);
+    if (childTree.detectors.empty()) {
+      continue;
+    }
+    if (childTree.components.size() == 1) {
+      direct.push_back(childTree.detectors.begin);
+    } else {
+      buildComponent(tree, child, node);
+    }
+  }
+
+  if (!direct.empty()) {
+    if (m_nodes.size() == node + 1) {
+      buildSplit(node, direct.begin(), direct.end());
+    } else {
+      const size_t group = newNode(node);
+      buildSplit(group, direct.begin(), direct.end());
+      finishNode(group);
+    }
+  }
+  finishNode(node);
+}
+
+/// Place detectors [begin, end) under node, splitting at the median.
+template <typename InstTree>
+void DetectorBVH<InstTree>::buildSplit(size_t node,
+                                       std::vector<size_t>::iterator begin,
+                                       std::vector<size_t>::iterator end) {
+  if (size_t(end - begin) <= m_leafSize) {
+    m_order.insert(m_order.end(), begin, end);
+    return;
+  }
+  Eigen::AlignedBox3d centers;
+  for (auto it = begin; it != end; ++it) {
+    centers.extend(m_positions[*it]);
+  }
+  int axis;
+  centers.sizes().maxCoeff(&axis);
+  auto middle = begin + (end - begin) / 2;
+  std::nth_element(begin, middle, end, [&](size_t a, size_t b) {
+    return m_positions[a][axis] < m_positions[b][axis];
+  });
+  for (auto half :
+       {std::make_pair(begin, middle), std::make_pair(middle, end)}) {
+    const size_t child = newNode(node);
+    buildSplit(child, half.first, half.second);
+    finishNode(child);
+  }
+}
+
+/// Box of node from its detectors (leaf) or its children
+template <typename InstTree> void DetectorBVH<InstTree>::fitNode(size_t node) {
+  auto &current = m_nodes[node];
+  current.box.setEmpty();
+  if (isLeaf(node)) {
+    const Eigen::Vector3d pad = Eigen::Vector3d::Constant(m_radius);
+    for (size_t i = current.begin; i < current.end; ++i) {
+      const auto &position = m_positions[m_order[i]];
+      current.box.extend(position - pad);
+      current.box.extend(position + pad);
+    }
+    return;
+  }
+  for (size_t child = node + 1; child < current.subTreeEnd;
+       child = m_nodes[child].subTreeEnd) {
+    current.box.extend(m_nodes[child].box);
+  }
+}
+
+template <typename InstTree>
+void DetectorBVH<InstTree>::refitAncestors(size_t node) {
+  for (size_t parent = m_nodes[node].parent; parent != npos;
+       parent = m_nodes[parent].parent) {
+    fitNode(parent);
+  }
+}
+
+/// Re-read all positions and refit every box. The grouping is kept.
+template <typename InstTree>
+template <typename PositionStorage>
+void DetectorBVH<InstTree>::refit(
+    const DetectorInfo<InstTree, PositionStorage> &detectorInfo) {
+  for (size_t i = 0; i < m_positions.size(); ++i) {
+    m_positions[i] = detectorInfo.position(i, 0);
+  }
+  for (size_t node = m_nodes.size(); node-- > 0;) {
+    fitNode(node);
+  }
+}
+
+/**
+ * Re-read positions of the detectors below componentIndex, after it has been
+ * moved or rotated, and refit the boxes containing them. Costs in proportion
+ * to the size of the sub-tree plus the depth of the hierarchy.
+ */
+template <typename InstTree>
+template <typename PositionStorage>
+void DetectorBVH<InstTree>::refit(
+    const DetectorInfo<InstTree, PositionStorage> &detectorInfo,
+    size_t componentIndex) {
+  const IndexRange detectors =
+      detectorInfo.const_instrumentTree().subTree(componentIndex).detectors;
+  for (size_t i = detectors.begin; i < detectors.end; ++i) {
+    m_positions[i] = detectorInfo.position(i, 0);
+  }
+  const size_t node = m_componentNode[componentIndex];
+  if (node != npos) {
+    for (size_t i = m_nodes[node].subTreeEnd; i-- > node;) {
+      fitNode(i);
+    }
+    refitAncestors(node);
+    return;
+  }
+  // A lone detector, grouped into a leaf with its siblings
+  for (size_t i = detectors.begin; i < detectors.end; ++i) {
+    fitNode(m_detectorLeaf[i]);
+    refitAncestors(m_detectorLeaf[i]);
+  }
+}
+
+/**
+ * First detector hit by a ray.
+ * @param origin : Start of the ray
+ * @param direction : Direction of the ray, need not be normalized
+ * @param distance : Set to the distance along the ray to the hit, in units of
+ * |direction|
+ * @return Detector index of the nearest detector hit, or npos if none
+ */
+template <typename InstTree>
+size_t DetectorBVH<InstTree>::intersect(const Eigen::Vector3d &origin,
+                                        const Eigen::Vector3d &direction,
+                                        double &distance) const {
+  const Eigen::Vector3d inverse = direction.cwiseInverse();
+  const double a = direction.squaredNorm();
+  const double r2 = m_radius * m_radius;
+  double best = std::numeric_limits<double>::infinity();
+  size_t hit = npos;
+
+  // Slab test. Entry distance of the ray into box, or infinity for a miss.
+  const double miss = std::numeric_limits<double>::infinity();
+  auto entry = [&](const Eigen::AlignedBox3d &box) {
+    double tNear = 0;
+    double tFar = miss;
+    for (int k = 0; k < 3; ++k) {
+      if (direction[k] == 0) {
+        if (origin[k] < box.min()[k] || origin[k] > box.max()[k]) {
+          return miss;
+        }
+        continue;
+      }
+      double t0 = (box.min()[k] - origin[k]) * inverse[k];
+      double t1 = (box.max()[k] - origin[k]) * inverse[k];
+      if (t0 > t1) {
+        std::swap(t0, t1);
+      }
+      tNear = std::max(tNear, t0);
+      tFar = std::min(tFar, t1);
+    }
+    return tNear <= tFar ? tNear : miss;
+  };
+
+  std::vector<size_t> stack;
+  if (!m_nodes.empty()) {
+    stack.push_back(0);
+  }
+  while (!stack.empty()) {
+    const size_t node = stack.back();
+    stack.pop_back();
+    if (entry(m_nodes[node].box) >= best) {
+      continue;
+    }
+    if (!isLeaf(node)) {
+      for (size_t child = node + 1; child < m_nodes[node].subTreeEnd;
+           child = m_nodes[child].subTreeEnd) {
+        stack.push_back(child);
+      }
+      continue;
+    }
+    for (size_t i = m_nodes[node].begin; i < m_nodes[node].end; ++i) {
+      // Solve |origin + t * direction - position| = radius for the smaller t
+      const Eigen::Vector3d toOrigin = origin - m_positions[m_order[i]];
+      const double b = toOrigin.dot(direction);
+      const double c = toOrigin.squaredNorm() - r2;
+      const double discriminant = b * b - a * c;
+      if (discriminant < 0) {
+        continue;
+      }
+      const double root = std::sqrt(discriminant);
+      double t = (-b - root) / a;
+      if (t < 0) {
+        t = (-b + root) / a; // Origin inside the sphere
+      }
+      if (t >= 0 && t < best) {
+        best = t;
+        hit = m_order[i];
+      }
+    }
+  }
+  distance = best;
+  return hit;
+}
+
+/// Detector whose position is nearest to point, or npos if there are none
+template <typename InstTree>
+size_t DetectorBVH<InstTree>::nearest(const Eigen::Vector3d &point) const {
+  double best = std::numeric_limits<double>::infinity();
+  size_t found = npos;
+  std::vector<size_t> stack;
+  if (!m_nodes.empty()) {
+    stack.push_back(0);
+  }
+  while (!stack.empty()) {
+    const size_t node = stack.back();
+    stack.pop_back();
+    // Boxes contain every position below them, so bound the distance.
+    if (m_nodes[node].box.squaredExteriorDistance(point) >= best) {
+      continue;
+    }
+    if (!isLeaf(node)) {
+      for (size_t child = node + 1; child < m_nodes[node].subTreeEnd;
+           child = m_nodes[child].subTreeEnd) {
+        stack.push_back(child);
+      }
+      continue;
+    }
+    for (size_t i = m_nodes[node].begin; i < m_nodes[node].end; ++i) {
+      const double d2 = (m_positions[m_order[i]] - point).squaredNorm();
+      if (d2 < best) {
+        best = d2;
+        found = m_order[i];
+      }
+    }
+  }
+  return found;
+}
+
+/// Append to out the detectors whose positions lie inside box, in no order
+template <typename InstTree>
+void DetectorBVH<InstTree>::inBox(const Eigen::AlignedBox3d &box,
+                                  std::vector<size_t> &out) const {
+  std::vector<size_t> stack;
+  if (!m_nodes.empty()) {
+    stack.push_back(0);
+  }
+  while (!stack.empty()) {
+    const size_t node = stack.back();
+    stack.pop_back();
+    const auto &current = m_nodes[node];
+    if (!box.intersects(current.box)) {
+      continue;
+    }
+    if (box.contains(current.box)) {
+      out.insert(out.end(), m_order.begin() + current.begin,
+                 m_order.begin() + current.end);
+      continue;
+    }
+    if (!isLeaf(node)) {
+      for (size_t child = node + 1; child < current.subTreeEnd;
+           child = m_nodes[child].subTreeEnd) {
+        stack.push_back(child);
+      }
+      continue;
+    }
+    for (size_t i = current.begin; i < current.end; ++i) {
+      if (box.contains(m_positions[m_order[i]])) {
+        out.push_back(m_order[i]);
+      }
+    }
+  }
+}
+
+/**
+ * Append to out the detectors whose positions lie inside a cone, in no order.
+ * @param apex : Tip of the cone
+ * @param axis : Direction of the cone, need not be normalized
+ * @param halfAngle : Angle between the axis and the surface, in radians, less
+ * than pi/2
+ * @param out : Detector indexes are appended
+ */
+template <typename InstTree>
+void DetectorBVH<InstTree>::inCone(const Eigen::Vector3d &apex,
+                                   const Eigen::Vector3d &axis,
+                                   double halfAngle,
+                                   std::vector<size_t> &out) const {
+  const Eigen::Vector3d unitAxis = axis.normalized();
+  const double cosHalfAngle = std::cos(halfAngle);
+  auto inside = [&](const Eigen::Vector3d &position) {
+    const Eigen::Vector3d toPosition = position - apex;
+    return toPosition.dot(unitAxis) >= cosHalfAngle * toPosition.norm();
+  };
+
+  std::vector<size_t> stack;
+  if (!m_nodes.empty()) {
+    stack.push_back(0);
+  }
+  while (!stack.empty()) {
+    const size_t node = stack.back();
+    stack.pop_back();
+    const auto &current = m_nodes[node];
+    // Reject the node if its bounding sphere lies wholly outside the cone
+    const Eigen::Vector3d toCenter = current.box.center() - apex;
+    const double d = toCenter.norm();
+    const double r = 0.5 * current.box.diagonal().norm();
+    if (d > r) {
+      const double angle =
+          std::acos(std::max(-1.0, std::min(1.0, toCenter.dot(unitAxis) / d)));
+      if (angle - std::asin(r / d) > halfAngle) {
+        continue;
+      }
+    }
+    if (!isLeaf(node)) {
+      for (size_t child = node + 1; child < current.subTreeEnd;
+           child = m_nodes[child].subTreeEnd) {
+        stack.push_back(child);
+      }
+      continue;
+    }
+    for (size_t i = current.begin; i < current.end; ++i) {
+      if (inside(m_positions[m_order[i]])) {
+        out.push_back(m_order[i]);
+      }
+    }
+  }
+}
+
+#endif
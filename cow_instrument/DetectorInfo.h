@@ -1,26 +1,37 @@
 #ifndef DETECTOR_INFO_H
 #define DETECTOR_INFO_H
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <stdexcept>
 #include <string>
 #include <sstream>
 #include <cmath>
 
+#include "ChunkedVector.h"
 #include "ComponentProxy.h"
 #include "cow_ptr.h"
 #include "Detector.h"
+#include "EditTransaction.h"
 #include "IdType.h"
+#include "IndexType.h"
 #include "L1s.h"
 #include "L2s.h"
+#include "LinearIndexMap.h"
 #include "MaskFlags.h"
 #include "MonitorFlags.h"
+#include "Parallel.h"
 #include "Path.h"
 #include "PathComponent.h"
 #include "PathComponentInfo.h"
 #include "PathFactory.h"
+#include "Positions.h"
+#include "Rotations.h"
 #include "ScanTime.h"
+#include "ScatteringAngles.h"
+#include "Span.h"
 #include "Spectrum.h"
 #include "SourceSampleDetectorPathFactory.h"
 
@@ -28,8 +39,31 @@
  * DetectorInfo type. Provides Meta-data context to an InstrumentTree
  * of detectors, and a facade for modifications.
  * Meta-data is provided per detector.
+ *
+ * Cached L1 and L2 values, and the scattering angles computed alongside L2
+ * once cacheScatteringAngles() is called, are recalculated lazily. Geometry
+ * writes only record which values have gone stale, and the next read of a
+ * derived value recalculates just those, so a long run of writes costs no
+ * recalculation until something is read. The recalculation is serialised by
+ * a lock, so const reads may be shared between threads; once the caches are
+ * up to date a read costs a single atomic load on top of the lookup. Reads
+ * within an EditTransaction likewise see every write made so far, including
+ * moves of the source or sample, which change the beam frame. The commit
+ * brings the values up to date, so that a failure is reported there.
+ *
+ * Without the angle cache, twoTheta(), signedTwoTheta() and phi() are
+ * calculated on each call. Angles are measured in the BeamFrame of the
+ * source to sample vector, with y up.
+ *
+ * Construction and full recalculations of the caches are spread over
+ * parallelThreadCount() threads (see Parallel.h).
+ *
+ * Bulk accessors return read-only views without copying: a Span where the
+ * data is one contiguous array, otherwise a const reference to the named
+ * container (Rotations, MaskFlags, MonitorFlags), which is paged or packed.
  */
-template <typename InstTree> class DetectorInfo {
+template <typename InstTree, typename PositionStorage = AoSPositions>
+class DetectorInfo {
 public:
   template <typename InstSptrType, typename PathFactoryType>
   explicit DetectorInfo(InstSptrType &&instrumentTree,
@@ -50,10 +84,24 @@ public:
                         ScanTimesType &&scanTimes, PositionsType &&positions,
                         RotationsType &&rotations);
 
+  DetectorInfo(const DetectorInfo<InstTree, PositionStorage> &other);
+  DetectorInfo<InstTree, PositionStorage> &
+  operator=(const DetectorInfo<InstTree, PositionStorage> &other);
+
   void setMasked(size_t detectorIndex);
 
+  void setMasked(const std::vector<size_t> &detectorIndexes);
+
+  void setMaskedRange(size_t beginIndex, size_t endIndex);
+
+  void unionMask(const MaskFlags &mask);
+
+  void intersectMask(const MaskFlags &mask);
+
   bool isMasked(size_t detectorIndex) const;
 
+  size_t maskedCount() const;
+
   void setMonitor(size_t detectorIndex);
 
   bool isMonitor(size_t detectorIndex) const;
@@ -72,6 +120,18 @@ public:
 
   double l1(size_t detectorIndex) const;
 
+  double twoTheta(size_t detectorIndex) const;
+
+  double twoTheta(size_t detectorIndex, size_t timeIndex) const;
+
+  double signedTwoTheta(size_t detectorIndex) const;
+
+  double signedTwoTheta(size_t detectorIndex, size_t timeIndex) const;
+
+  double phi(size_t detectorIndex) const;
+
+  double phi(size_t detectorIndex, size_t timeIndex) const;
+
   size_t detectorSize() const;
 
   const InstTree &const_instrumentTree() const;
@@ -91,6 +151,13 @@ public:
                        const Eigen::Vector3d &axis, const double &theta,
                        const Eigen::Vector3d &center);
 
+  void moveDetectorRange(size_t begin, size_t end,
+                         const Eigen::Vector3d &offset);
+
+  void rotateDetectorRange(size_t begin, size_t end,
+                           const Eigen::Vector3d &axis, const double &theta,
+                           const Eigen::Vector3d &center);
+
   void rotatePathComponents(const std::vector<size_t> &pathComponentIndexes,
                             const Eigen::Vector3d &axis, const double &theta,
                             const Eigen::Vector3d &center);
@@ -98,42 +165,128 @@ public:
   void movePathComponents(const std::vector<size_t> &pathComponentIndexes,
                           const Eigen::Vector3d &offset);
 
+  void movePathComponentRange(size_t begin, size_t end,
+                              const Eigen::Vector3d &offset);
+
+  void rotatePathComponentRange(size_t begin, size_t end,
+                                const Eigen::Vector3d &axis,
+                                const double &theta,
+                                const Eigen::Vector3d &center);
+
   std::vector<Spectrum> makeSpectra() const;
 
   const PathComponentInfo<InstTree> &pathComponentInfo() const;
 
+  const PositionStorage &const_positions() const;
+
+  typename PositionStorage::ConstMap positions() const;
+
+  typename PositionStorage::ConstStridedMap
+  scanPositions(size_t timeIndex) const;
+
+  const Rotations &rotations() const;
+
+  Span<double> l1s() const;
+
+  Span<PathId> l1PathIds() const;
+
   CowPtr<L2s> l2s() const;
 
+  CowPtr<ScatteringAngles> scatteringAngles() const;
+
+  void cacheScatteringAngles();
+
+  bool cachesScatteringAngles() const;
+
+  const MaskFlags &maskFlags() const;
+
+  const MonitorFlags &monitorFlags() const;
+
   bool isScanning() const;
 
   size_t scanCount() const;
 
 private:
-  void init();
-  void initL2();
-  void initL1();
+  friend class EditTransaction<DetectorInfo<InstTree, PositionStorage>>;
+  template <typename T> friend class ComponentInfo;
+
+  /// Values derived from the geometry, recalculated after writes
+  struct DerivedCache {
+    DerivedCache(size_t l1Size, size_t l2Size);
+    /// L1 of each unique L1 path, indexed by PathId
+    CowPtr<L1s> l1;
+    CowPtr<L2s> l2;
+    /// Linearly indexed two-theta, phi etc. Kept in step with l2 if
+    /// m_cacheAngles, otherwise empty.
+    CowPtr<ScatteringAngles> angles;
+    /// All L1 values need recalculating
+    bool l1Stale = false;
+    /// Some L2 values need recalculating
+    bool l2Dirty = false;
+    /// All L2 values need recalculating
+    bool l2Stale = false;
+    /// Linear indexes for which L2 needs recalculating
+    std::vector<size_t> staleL2Indexes;
+    /// Length of each unique L2 path up to its exit point, indexed by PathId
+    std::vector<double> l2PathLengths;
+    /// Sample exit point, the origin of scattered directions
+    Eigen::Vector3d scatteringPoint;
+    /// Frame of the source to sample vector, in which angles are measured
+    BeamFrame beamFrame;
+  };
+
+  void openEdit();
+  void commitEdit();
+  void markL2Stale(size_t linearIndex);
+  void markL2Stale(size_t begin, size_t end);
+  void markPathsStale();
+  const DerivedCache &derived() const;
+  void refresh() const;
+  void refreshL1() const;
+  void refreshL2() const;
+  DerivedCache lockedDerived() const;
 
-  const size_t m_nDetectors;
+  void init();
+  void initL2() const;
+  void initL1() const;
+  void initBeam() const;
+  void updateL2(size_t linearIndex) const;
+  double calculateL2(size_t detectorIndex, size_t linearIndex) const;
+  Eigen::Vector3d scatteredDirection(size_t linearIndex) const;
+  void calculateAngles(ScatteringAngles &angles) const;
+  size_t detectorIndexOf(size_t linearIndex) const;
+
+  size_t m_nDetectors;
   CowPtr<MaskFlags> m_isMasked;
   CowPtr<MonitorFlags> m_isMonitor;
 
-  CowPtr<L1s> m_l1;
-  CowPtr<L2s> m_l2;
   CowPtr<const Paths> m_l2Paths;
   CowPtr<const Paths> m_l1Paths;
-  std::shared_ptr<const std::vector<size_t>> m_detectorComponentIndexes;
-  /// Locally (detector) indexed positions
-  CowPtr<std::vector<Eigen::Vector3d>> m_positions;
-  /// Locally (detector) indexed rotations
-  CowPtr<std::vector<Eigen::Quaterniond>> m_rotations;
+  /// Recalculated by const readers under m_derivedMutex
+  mutable DerivedCache m_derived;
+  mutable std::mutex m_derivedMutex;
+  /// Whether m_derived has stale values. Read without the lock.
+  mutable std::atomic<bool> m_isStale{false};
+  std::shared_ptr<const std::vector<IndexType>> m_detectorComponentIndexes;
+  /// Linearly indexed positions
+  CowPtr<PositionStorage> m_positions;
+  /// Linearly indexed rotations
+  CowPtr<Rotations> m_rotations;
   /// Linear index map (detector indexed)
-  std::shared_ptr<const std::vector<std::vector<size_t>>> m_linearIndexMap;
+  std::shared_ptr<const LinearIndexMap> m_linearIndexMap;
+  /// Inverse of the linear index map (linear indexed). Only set if the map
+  /// cannot be inverted by division.
+  std::shared_ptr<const std::vector<IndexType>> m_linearToDetectorIndex;
   /// Scan durations
   std::shared_ptr<const ScanTimes> m_durations;
   /// Path component information
   PathComponentInfo<InstTree> m_pathComponentInfo;
   /// Is scanning
-  const bool m_isScanning = false;
+  bool m_isScanning = false;
+  /// Whether m_angles is maintained
+  bool m_cacheAngles = false;
+  /// Number of open edit transactions
+  size_t m_editDepth = 0;
 };
 
 namespace {
@@ -152,35 +305,39 @@ double distance(const Eigen::Vector3d &a, const Eigen::Vector3d &b) {
 }
 
 template <typename InstSptrType>
-std::shared_ptr<std::vector<std::vector<size_t>>>
+std::shared_ptr<const LinearIndexMap>
 makeDefaultIndexes(InstSptrType &instrumentTree) {
-  size_t size = instrumentTree->nDetectors();
-  auto indexes = std::make_shared<std::vector<std::vector<size_t>>>(size);
-  for (size_t i = 0; i < size; ++i) {
-    // Always one time index per detector. Just need the detector index.
-    (*indexes)[i] = std::vector<size_t>(1, i);
+  // Always one time index per detector. Just need the detector index.
+  return std::make_shared<const LinearIndexMap>(instrumentTree->nDetectors());
+}
+
+std::shared_ptr<const std::vector<IndexType>>
+makeDetectorIndexes(const LinearIndexMap &linearIndexMap,
+                    size_t nLinearIndexes) {
+  if (linearIndexMap.isStrided()) {
+    return nullptr;
   }
-  return indexes;
+  return std::make_shared<const std::vector<IndexType>>(
+      linearIndexMap.detectorIndexes(nLinearIndexes));
 }
 }
 
-template <typename InstTree>
+template <typename InstTree, typename PositionStorage>
 template <typename InstSptrType, typename PathFactoryType>
-DetectorInfo<InstTree>::DetectorInfo(InstSptrType &&instrumentTree,
-                                     PathFactoryType &&pathFactory,
-                                     ScanTime scanTime)
+DetectorInfo<InstTree, PositionStorage>::DetectorInfo(
+    InstSptrType &&instrumentTree, PathFactoryType &&pathFactory,
+    ScanTime scanTime)
     : m_l2Paths(pathFactory.createL2(*instrumentTree)),
       m_l1Paths(pathFactory.createL1(*instrumentTree)),
       m_nDetectors(instrumentTree->nDetectors()),
-      m_l1(std::make_shared<L1s>(m_nDetectors)),
-      m_l2(std::make_shared<L2s>(m_nDetectors)),
-      m_isMasked(std::make_shared<MaskFlags>(m_nDetectors, Bool(false))),
-      m_isMonitor(std::make_shared<MonitorFlags>(m_nDetectors, Bool(false))),
-      m_detectorComponentIndexes(std::make_shared<const std::vector<size_t>>(
-          instrumentTree->detectorComponentIndexes())),
-      m_positions(std::make_shared<std::vector<Eigen::Vector3d>>(m_nDetectors)),
-      m_rotations(
-          std::make_shared<std::vector<Eigen::Quaterniond>>(m_nDetectors)),
+      m_derived(m_l1Paths.const_ref().uniqueSize(), m_nDetectors),
+      m_isMasked(std::make_shared<MaskFlags>(m_nDetectors, false)),
+      m_isMonitor(std::make_shared<MonitorFlags>(m_nDetectors, false)),
+      m_detectorComponentIndexes(
+          std::make_shared<const std::vector<IndexType>>(
+              instrumentTree->detectorComponentIndexes())),
+      m_positions(std::make_shared<PositionStorage>(m_nDetectors)),
+      m_rotations(std::make_shared<Rotations>(m_nDetectors)),
       m_linearIndexMap(makeDefaultIndexes(instrumentTree)),
       m_durations(std::make_shared<const ScanTimes>(1, scanTime)),
       m_pathComponentInfo(std::forward<InstSptrType>(instrumentTree)) {
@@ -188,23 +345,22 @@ DetectorInfo<InstTree>::DetectorInfo(InstSptrType &&instrumentTree,
   init();
 }
 
-template <typename InstTree>
-DetectorInfo<InstTree>::DetectorInfo(std::shared_ptr<InstTree> &instrumentTree,
-                                     ScanTime scanTime)
+template <typename InstTree, typename PositionStorage>
+DetectorInfo<InstTree, PositionStorage>::DetectorInfo(
+    std::shared_ptr<InstTree> &instrumentTree, ScanTime scanTime)
     : m_l2Paths(SourceSampleDetectorPathFactory<InstTree>{}.createL2(
           *instrumentTree)),
       m_l1Paths(SourceSampleDetectorPathFactory<InstTree>{}.createL1(
           *instrumentTree)),
       m_nDetectors(instrumentTree->nDetectors()),
-      m_l1(std::make_shared<L1s>(m_nDetectors)),
-      m_l2(std::make_shared<L2s>(m_nDetectors)),
-      m_isMasked(std::make_shared<MaskFlags>(m_nDetectors, Bool(false))),
-      m_isMonitor(std::make_shared<MonitorFlags>(m_nDetectors, Bool(false))),
-      m_detectorComponentIndexes(std::make_shared<const std::vector<size_t>>(
-          instrumentTree->detectorComponentIndexes())),
-      m_positions(std::make_shared<std::vector<Eigen::Vector3d>>(m_nDetectors)),
-      m_rotations(
-          std::make_shared<std::vector<Eigen::Quaterniond>>(m_nDetectors)),
+      m_derived(m_l1Paths.const_ref().uniqueSize(), m_nDetectors),
+      m_isMasked(std::make_shared<MaskFlags>(m_nDetectors, false)),
+      m_isMonitor(std::make_shared<MonitorFlags>(m_nDetectors, false)),
+      m_detectorComponentIndexes(
+          std::make_shared<const std::vector<IndexType>>(
+              instrumentTree->detectorComponentIndexes())),
+      m_positions(std::make_shared<PositionStorage>(m_nDetectors)),
+      m_rotations(std::make_shared<Rotations>(m_nDetectors)),
       m_linearIndexMap(makeDefaultIndexes(instrumentTree)),
       m_durations(std::make_shared<const ScanTimes>(1, scanTime)),
       m_pathComponentInfo(instrumentTree) {
@@ -212,23 +368,22 @@ DetectorInfo<InstTree>::DetectorInfo(std::shared_ptr<InstTree> &instrumentTree,
   init();
 }
 
-template <typename InstTree>
-DetectorInfo<InstTree>::DetectorInfo(std::shared_ptr<InstTree> &&instrumentTree,
-                                     ScanTime scanTime)
+template <typename InstTree, typename PositionStorage>
+DetectorInfo<InstTree, PositionStorage>::DetectorInfo(
+    std::shared_ptr<InstTree> &&instrumentTree, ScanTime scanTime)
     : m_l2Paths(SourceSampleDetectorPathFactory<InstTree>{}.createL2(
           *instrumentTree)),
       m_l1Paths(SourceSampleDetectorPathFactory<InstTree>{}.createL1(
           *instrumentTree)),
       m_nDetectors(instrumentTree->nDetectors()),
-      m_l1(std::make_shared<L1s>(m_nDetectors)),
-      m_l2(std::make_shared<L2s>(m_nDetectors)),
-      m_isMasked(std::make_shared<MaskFlags>(m_nDetectors, Bool(false))),
-      m_isMonitor(std::make_shared<MonitorFlags>(m_nDetectors, Bool(false))),
-      m_detectorComponentIndexes(std::make_shared<const std::vector<size_t>>(
-          instrumentTree->detectorComponentIndexes())),
-      m_positions(std::make_shared<std::vector<Eigen::Vector3d>>(m_nDetectors)),
-      m_rotations(
-          std::make_shared<std::vector<Eigen::Quaterniond>>(m_nDetectors)),
+      m_derived(m_l1Paths.const_ref().uniqueSize(), m_nDetectors),
+      m_isMasked(std::make_shared<MaskFlags>(m_nDetectors, false)),
+      m_isMonitor(std::make_shared<MonitorFlags>(m_nDetectors, false)),
+      m_detectorComponentIndexes(
+          std::make_shared<const std::vector<IndexType>>(
+              instrumentTree->detectorComponentIndexes())),
+      m_positions(std::make_shared<PositionStorage>(m_nDetectors)),
+      m_rotations(std::make_shared<Rotations>(m_nDetectors)),
       m_linearIndexMap(makeDefaultIndexes(instrumentTree)),
       m_durations(std::make_shared<const ScanTimes>(1, scanTime)),
       m_pathComponentInfo(
@@ -237,31 +392,30 @@ DetectorInfo<InstTree>::DetectorInfo(std::shared_ptr<InstTree> &&instrumentTree,
   init();
 }
 
-template <typename InstTree>
+template <typename InstTree, typename PositionStorage>
 template <typename InstSptrType, typename TimeIndexesType,
           typename ScanTimesType, typename PositionsType,
           typename RotationsType>
-DetectorInfo<InstTree>::DetectorInfo(InstSptrType &&instrumentTree,
-                                     TimeIndexesType &&timeIndexes,
-                                     ScanTimesType &&scanTimes,
-                                     PositionsType &&positions,
-                                     RotationsType &&rotations)
+DetectorInfo<InstTree, PositionStorage>::DetectorInfo(
+    InstSptrType &&instrumentTree, TimeIndexesType &&timeIndexes,
+    ScanTimesType &&scanTimes, PositionsType &&positions,
+    RotationsType &&rotations)
     : m_l2Paths(SourceSampleDetectorPathFactory<InstTree>{}.createL2(
           *instrumentTree)),
       m_l1Paths(SourceSampleDetectorPathFactory<InstTree>{}.createL1(
           *instrumentTree)),
       m_nDetectors(instrumentTree->nDetectors()),
-      m_l1(std::make_shared<L1s>(m_nDetectors)),
-      m_l2(std::make_shared<L2s>(positions.size())),
-      m_isMasked(std::make_shared<MaskFlags>(m_nDetectors, Bool(false))),
-      m_isMonitor(std::make_shared<MonitorFlags>(m_nDetectors, Bool(false))),
-      m_detectorComponentIndexes(std::make_shared<const std::vector<size_t>>(
-          instrumentTree->detectorComponentIndexes())),
-      m_positions(std::make_shared<std::vector<Eigen::Vector3d>>(
+      m_derived(m_l1Paths.const_ref().uniqueSize(), positions.size()),
+      m_isMasked(std::make_shared<MaskFlags>(m_nDetectors, false)),
+      m_isMonitor(std::make_shared<MonitorFlags>(m_nDetectors, false)),
+      m_detectorComponentIndexes(
+          std::make_shared<const std::vector<IndexType>>(
+              instrumentTree->detectorComponentIndexes())),
+      m_positions(std::make_shared<PositionStorage>(
           std::forward<PositionsType>(positions))),
-      m_rotations(std::make_shared<std::vector<Eigen::Quaterniond>>(
+      m_rotations(std::make_shared<Rotations>(
           std::forward<RotationsType>(rotations))),
-      m_linearIndexMap(std::make_shared<std::vector<std::vector<size_t>>>(
+      m_linearIndexMap(std::make_shared<const LinearIndexMap>(
           std::forward<TimeIndexesType>(timeIndexes))),
       m_durations(
           std::make_shared<ScanTimes>(std::forward<ScanTimesType>(scanTimes))),
@@ -270,39 +424,136 @@ DetectorInfo<InstTree>::DetectorInfo(InstSptrType &&instrumentTree,
       m_isScanning(true) {
 
   if (m_positions->size() != m_rotations->size()) {
-    throw std::invalid_argument("The numbers of rotations and positions should match");
+    throw std::invalid_argument(
+        "The numbers of rotations and positions should match");
   }
+  m_linearToDetectorIndex =
+      makeDetectorIndexes(*m_linearIndexMap, m_positions->size());
 
   initL1();
   initL2();
 }
 
-template <typename InstTree>
-void DetectorInfo<InstTree>::setMasked(size_t detectorIndex) {
+/// Copies the caches of other as they stand, stale values included
+template <typename InstTree, typename PositionStorage>
+DetectorInfo<InstTree, PositionStorage>::DetectorInfo(
+    const DetectorInfo<InstTree, PositionStorage> &other)
+    : m_nDetectors(other.m_nDetectors), m_isMasked(other.m_isMasked),
+      m_isMonitor(other.m_isMonitor), m_l2Paths(other.m_l2Paths),
+      m_l1Paths(other.m_l1Paths), m_derived(other.lockedDerived()),
+      m_isStale(m_derived.l1Stale || m_derived.l2Dirty),
+      m_detectorComponentIndexes(other.m_detectorComponentIndexes),
+      m_positions(other.m_positions), m_rotations(other.m_rotations),
+      m_linearIndexMap(other.m_linearIndexMap),
+      m_linearToDetectorIndex(other.m_linearToDetectorIndex),
+      m_durations(other.m_durations),
+      m_pathComponentInfo(other.m_pathComponentInfo),
+      m_isScanning(other.m_isScanning), m_cacheAngles(other.m_cacheAngles),
+      m_editDepth(other.m_editDepth) {}
+
+template <typename InstTree, typename PositionStorage>
+DetectorInfo<InstTree, PositionStorage> &
+DetectorInfo<InstTree, PositionStorage>::
+operator=(const DetectorInfo<InstTree, PositionStorage> &other) {
+  if (this != &other) {
+    m_nDetectors = other.m_nDetectors;
+    m_isMasked = other.m_isMasked;
+    m_isMonitor = other.m_isMonitor;
+    m_l2Paths = other.m_l2Paths;
+    m_l1Paths = other.m_l1Paths;
+    m_derived = other.lockedDerived();
+    m_isStale = m_derived.l1Stale || m_derived.l2Dirty;
+    m_detectorComponentIndexes = other.m_detectorComponentIndexes;
+    m_positions = other.m_positions;
+    m_rotations = other.m_rotations;
+    m_linearIndexMap = other.m_linearIndexMap;
+    m_linearToDetectorIndex = other.m_linearToDetectorIndex;
+    m_durations = other.m_durations;
+    m_pathComponentInfo = other.m_pathComponentInfo;
+    m_isScanning = other.m_isScanning;
+    m_cacheAngles = other.m_cacheAngles;
+    m_editDepth = other.m_editDepth;
+  }
+  return *this;
+}
+
+template <typename InstTree, typename PositionStorage>
+DetectorInfo<InstTree, PositionStorage>::DerivedCache::DerivedCache(
+    size_t l1Size, size_t l2Size)
+    : l1(std::make_shared<L1s>(l1Size)), l2(std::make_shared<L2s>(l2Size)),
+      angles(std::make_shared<ScatteringAngles>(0)) {}
+
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::setMasked(size_t detectorIndex) {
   detectorRangeCheck(detectorIndex, m_isMasked.const_ref());
-  (*m_isMasked)[detectorIndex] = true;
+  m_isMasked->set(detectorIndex);
+}
+
+/**
+ * Mask all detectors in detectorIndexes. All indexes are range checked before
+ * any is masked.
+ */
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::setMasked(
+    const std::vector<size_t> &detectorIndexes) {
+  for (auto detectorIndex : detectorIndexes) {
+    detectorRangeCheck(detectorIndex, m_isMasked.const_ref());
+  }
+  m_isMasked->set(detectorIndexes);
 }
 
-template <typename InstTree> void DetectorInfo<InstTree>::init() {
+/// Mask detectors with indexes in [beginIndex, endIndex), e.g. a whole bank
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::setMaskedRange(size_t beginIndex,
+                                                             size_t endIndex) {
+  if (endIndex > 0) {
+    detectorRangeCheck(endIndex - 1, m_isMasked.const_ref());
+  }
+  if (beginIndex > endIndex) {
+    throw std::out_of_range("Begin of mask range is after its end");
+  }
+  m_isMasked->setRange(beginIndex, endIndex);
+}
+
+/// Also mask every detector masked in mask
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::unionMask(
+    const MaskFlags &mask) {
+  *m_isMasked |= mask;
+}
+
+/// Unmask every detector not masked in mask
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::intersectMask(
+    const MaskFlags &mask) {
+  *m_isMasked &= mask;
+}
 
-  // TODO. Refactor this so that a copy is not required!
-  std::vector<Eigen::Vector3d> allComponentPositions =
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::init() {
+
+  const auto &allComponentPositions =
       m_pathComponentInfo.const_instrumentTree().startPositions();
-  std::vector<Eigen::Quaterniond> allComponentRotations =
+  const auto &allComponentRotations =
       m_pathComponentInfo.const_instrumentTree().startRotations();
 
-  size_t i = 0;
-  for (auto &compIndex : (*m_detectorComponentIndexes)) {
-    (*m_positions)[i] = allComponentPositions[compIndex];
-    (*m_rotations)[i] = allComponentRotations[compIndex];
-    ++i;
-  }
+  const std::vector<IndexType> &componentIndexes =
+      *m_detectorComponentIndexes;
+  PositionStorage &positions = *m_positions;
+  Rotations &rotations = *m_rotations;
+  parallelFor(componentIndexes.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      positions.set(i, allComponentPositions[componentIndexes[i]]);
+      rotations[i] = allComponentRotations[componentIndexes[i]];
+    }
+  });
 
   initL1();
   initL2();
 }
 
-template <typename InstTree> void DetectorInfo<InstTree>::initL1() {
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::initL1() const {
 
   /*
    * Caution for future extension of this: We must not double count the
@@ -319,12 +570,13 @@ template <typename InstTree> void DetectorInfo<InstTree>::initL1() {
   const std::vector<double> &pathLengths =
       m_pathComponentInfo.const_pathLengths();
 
-  // Loop over all detector indexes. We will have a path for each.
-  for (size_t detectorIndex = 0; detectorIndex < m_nDetectors;
-       ++detectorIndex) {
+  // Evaluate each distinct path once. Detectors look their L1 up by PathId.
+  const Paths &paths = m_l1Paths.const_ref();
+  L1s &l1s = *m_derived.l1;
+  for (PathId pathId = 0; pathId < paths.uniqueSize(); ++pathId) {
 
     size_t i = 0;
-    const Path &path = (*m_l1Paths)[detectorIndex];
+    const Path &path = paths.uniquePath(pathId);
     if (path.size() < 2) {
       throw std::logic_error("Cannot have a L1 specified with less than 2 path "
                              "components (sample + source).");
@@ -336,12 +588,12 @@ template <typename InstTree> void DetectorInfo<InstTree>::initL1() {
       l1 += distance(entryPoints[path[i]], exitPoints[path[i - 1]]);
       l1 += pathLengths[path[i]];
     }
-
-    (*m_l1)[detectorIndex] = l1;
+    l1s[pathId] = l1;
   }
 }
 
-template <typename InstTree> void DetectorInfo<InstTree>::initL2() {
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::initL2() const {
 
   const std::vector<Eigen::Vector3d> &entryPoints =
       m_pathComponentInfo.const_entryPoints();
@@ -350,160 +602,348 @@ template <typename InstTree> void DetectorInfo<InstTree>::initL2() {
   const std::vector<double> &pathLengths =
       m_pathComponentInfo.const_pathLengths();
 
-  const size_t scanCount = m_durations->size();
-
-  // Loop over all detector indexes. We will have a path for each.
-  for (size_t detectorIndex = 0; detectorIndex < m_nDetectors;
-       ++detectorIndex) {
+  // Everything up to the exit point of each distinct path, once.
+  const Paths &paths = m_l2Paths.const_ref();
+  m_derived.l2PathLengths.resize(paths.uniqueSize());
+  for (PathId pathId = 0; pathId < paths.uniqueSize(); ++pathId) {
 
-    for (size_t timeIndex = 0; timeIndex < scanCount; ++timeIndex) {
+    const Path &path = paths.uniquePath(pathId);
+    if (path.size() < 1) {
+      throw std::logic_error("Cannot have a L2 specified with less than 1 path "
+                             "components (sample).");
+    }
+    size_t i = 0;
+    double l2 = pathLengths[path[i]];
+    for (i = 1; i < path.size(); ++i) {
+      l2 += distance(entryPoints[path[i]], exitPoints[path[i - 1]]);
+      l2 += pathLengths[path[i]];
+    }
+    m_derived.l2PathLengths[pathId] = l2;
+  }
 
-      const size_t linearIndex = (*m_linearIndexMap)[detectorIndex][timeIndex];
-      auto detectorPos =
-          (*m_positions)[linearIndex];
-      size_t i = 0;
-      const Path &path = (*m_l2Paths)[detectorIndex];
-      if (path.size() < 1) {
-        throw std::logic_error(
-            "Cannot have a L2 specified with less than 1 path "
-            "components (sample).");
+  initBeam();
+
+  static_assert(parallelGrainSize % L2s::pageSize == 0,
+                "Parallel chunks must not split L2 pages");
+  L2s &l2s = *m_derived.l2;
+  ScatteringAngles *angles = m_cacheAngles ? &*m_derived.angles : nullptr;
+  const PositionStorage &positions = m_positions.const_ref();
+  const size_t nLinearIndexes = l2s.size();
+
+  if (paths.uniqueSize() == 1) {
+    // Every detector leaves from the same point, e.g. direct geometry. All
+    // linear indexes in one pass of the distance kernel.
+    const Path &path = paths.uniquePath(0);
+    const Eigen::Vector3d &exitPoint = exitPoints[path[path.size() - 1]];
+    const double pathLength = m_derived.l2PathLengths[0];
+    parallelFor(nLinearIndexes, [&](size_t begin, size_t end) {
+      // Chunks start on page boundaries, so threads never share a page.
+      for (size_t page = begin / L2s::pageSize; page < l2s.pageCount() &&
+                                                page * L2s::pageSize < end;
+           ++page) {
+        const size_t pageBegin = page * L2s::pageSize;
+        positions.offsetDistances(exitPoint, pathLength, pageBegin,
+                                  pageBegin + l2s.pageLength(page),
+                                  l2s.mutablePage(page));
       }
-      double l2 = pathLengths[path[i]];
-
-      // For each detector-l2-path calculate the total neutronic length
-      for (i = 1; i < path.size(); ++i) {
-        l2 += distance(entryPoints[path[i]], exitPoints[path[i - 1]]);
-        l2 += pathLengths[path[i]];
+      if (angles) {
+        for (size_t linearIndex = begin; linearIndex < end; ++linearIndex) {
+          angles->set(linearIndex, m_derived.beamFrame,
+                      scatteredDirection(linearIndex));
+        }
       }
-      l2 += distance(exitPoints[path[i - 1]], detectorPos);
+    });
+    return;
+  }
 
-      // TODO. We may end up assigning the same value to the same index in some scanning modes. That will need optimizing out.
-      (*m_l2)[linearIndex] = l2;
+  // Loop over linear indexes rather than detectors and time indexes, so that
+  // each value is written exactly once.
+  parallelFor(nLinearIndexes, [&](size_t begin, size_t end) {
+    for (size_t linearIndex = begin; linearIndex < end; ++linearIndex) {
+      l2s[linearIndex] = calculateL2(detectorIndexOf(linearIndex), linearIndex);
+      if (angles) {
+        angles->set(linearIndex, m_derived.beamFrame,
+                    scatteredDirection(linearIndex));
+      }
     }
+  });
+}
+
+/**
+ * Cache the beam geometry used for scattering angles. The beam runs from the
+ * source exit point to the sample entry point, and scattered directions start
+ * at the sample exit point. The up axis is y.
+ */
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::initBeam() const {
+  const InstTree &instrumentTree = m_pathComponentInfo.const_instrumentTree();
+  const size_t sourceIndex = instrumentTree.sourcePathIndex();
+  const size_t sampleIndex = instrumentTree.samplePathIndex();
+  m_derived.scatteringPoint =
+      m_pathComponentInfo.const_exitPoints()[sampleIndex];
+  m_derived.beamFrame =
+      BeamFrame(m_pathComponentInfo.const_entryPoints()[sampleIndex] -
+                    m_pathComponentInfo.const_exitPoints()[sourceIndex],
+                Eigen::Vector3d::UnitY());
+}
+
+/**
+ * Recalculate the cached L2 and scattering angles for a single linear index
+ * only. Used after detector-level edits, which cannot affect the L2 of any
+ * other detector.
+ * @param linearIndex : Linear index (position index) that was modified
+ */
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::updateL2(
+    size_t linearIndex) const {
+  (*m_derived.l2)[linearIndex] =
+      calculateL2(detectorIndexOf(linearIndex), linearIndex);
+  if (m_cacheAngles) {
+    m_derived.angles->set(linearIndex, m_derived.beamFrame,
+                          scatteredDirection(linearIndex));
   }
 }
 
-template <typename InstTree>
-bool DetectorInfo<InstTree>::isMasked(size_t detectorIndex) const {
+template <typename InstTree, typename PositionStorage>
+double DetectorInfo<InstTree, PositionStorage>::calculateL2(
+    size_t detectorIndex, size_t linearIndex) const {
+
+  // Path lengths up to the exit point were cached by the last initL2.
+  const Paths &paths = m_l2Paths.const_ref();
+  const PathId pathId = paths.pathId(detectorIndex);
+  const Path &path = paths.uniquePath(pathId);
+  const Eigen::Vector3d &exitPoint =
+      m_pathComponentInfo.const_exitPoints()[path[path.size() - 1]];
+  return m_derived.l2PathLengths[pathId] +
+         m_positions.const_ref().distance(linearIndex, exitPoint);
+}
+
+/// Sample exit point to the detector at linearIndex
+template <typename InstTree, typename PositionStorage>
+Eigen::Vector3d DetectorInfo<InstTree, PositionStorage>::scatteredDirection(
+    size_t linearIndex) const {
+  return m_positions.const_ref()[linearIndex] - m_derived.scatteringPoint;
+}
+
+template <typename InstTree, typename PositionStorage>
+size_t DetectorInfo<InstTree, PositionStorage>::detectorIndexOf(
+    size_t linearIndex) const {
+  // Without scanning, linear indexes and detector indexes are the same. With
+  // a strided map they differ by a factor of the scan count.
+  return m_linearToDetectorIndex ? (*m_linearToDetectorIndex)[linearIndex]
+                                 : linearIndex / m_linearIndexMap->stride();
+}
+
+template <typename InstTree, typename PositionStorage>
+bool DetectorInfo<InstTree, PositionStorage>::isMasked(
+    size_t detectorIndex) const {
   detectorRangeCheck(detectorIndex, m_isMasked.const_ref());
   return m_isMasked.const_ref()[detectorIndex];
 }
 
-template <typename InstTree>
-void DetectorInfo<InstTree>::setMonitor(size_t detectorIndex) {
+/// Number of masked detectors
+template <typename InstTree, typename PositionStorage>
+size_t DetectorInfo<InstTree, PositionStorage>::maskedCount() const {
+  return m_isMasked.const_ref().count();
+}
+
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::setMonitor(size_t detectorIndex) {
   detectorRangeCheck(detectorIndex, m_isMonitor.const_ref());
-  (*m_isMonitor)[detectorIndex] = true;
+  m_isMonitor->set(detectorIndex);
 }
 
-template <typename InstTree>
-bool DetectorInfo<InstTree>::isMonitor(size_t detectorIndex) const {
+template <typename InstTree, typename PositionStorage>
+bool DetectorInfo<InstTree, PositionStorage>::isMonitor(
+    size_t detectorIndex) const {
   detectorRangeCheck(detectorIndex, m_isMonitor.const_ref());
   return m_isMonitor.const_ref()[detectorIndex];
 }
 
-template <typename InstTree>
-double DetectorInfo<InstTree>::l2(size_t detectorIndex) const {
-  detectorRangeCheck(detectorIndex, m_l2.const_ref());
-  return m_l2.const_ref()[detectorIndex];
+template <typename InstTree, typename PositionStorage>
+double DetectorInfo<InstTree, PositionStorage>::l2(size_t detectorIndex) const {
+  const DerivedCache &cache = derived();
+  detectorRangeCheck(detectorIndex, cache.l2.const_ref());
+  return cache.l2.const_ref()[detectorIndex];
 }
 
-template <typename InstTree>
-double DetectorInfo<InstTree>::l2(size_t detectorIndex,
-                                  size_t timeIndex) const {
-  detectorRangeCheck(detectorIndex, m_l2.const_ref());
-  return m_l2.const_ref()[(*m_linearIndexMap)[detectorIndex][timeIndex]];
+template <typename InstTree, typename PositionStorage>
+double DetectorInfo<InstTree, PositionStorage>::l2(size_t detectorIndex,
+                                                   size_t timeIndex) const {
+  const DerivedCache &cache = derived();
+  detectorRangeCheck(detectorIndex, cache.l2.const_ref());
+  return cache.l2.const_ref()[(*m_linearIndexMap)(detectorIndex, timeIndex)];
 }
 
-template <typename InstTree>
-Eigen::Vector3d DetectorInfo<InstTree>::position(size_t detectorIndex) const {
+template <typename InstTree, typename PositionStorage>
+Eigen::Vector3d DetectorInfo<InstTree, PositionStorage>::position(
+    size_t detectorIndex) const {
 
   return (*m_positions)[detectorIndex];
 }
 
-template <typename InstTree>
-Eigen::Vector3d DetectorInfo<InstTree>::position(size_t detectorIndex,
-                                                 size_t timeIndex) const {
+template <typename InstTree, typename PositionStorage>
+Eigen::Vector3d DetectorInfo<InstTree, PositionStorage>::position(
+    size_t detectorIndex, size_t timeIndex) const {
 
-  return (*m_positions)[(*m_linearIndexMap)[detectorIndex][timeIndex]];
+  return (*m_positions)[(*m_linearIndexMap)(detectorIndex, timeIndex)];
 }
 
-template <typename InstTree>
+template <typename InstTree, typename PositionStorage>
 Eigen::Quaterniond
-DetectorInfo<InstTree>::rotation(size_t detectorIndex) const {
+DetectorInfo<InstTree, PositionStorage>::rotation(size_t detectorIndex) const {
   return (*m_rotations)[detectorIndex];
 }
 
-template <typename InstTree>
-Eigen::Quaterniond DetectorInfo<InstTree>::rotation(size_t detectorIndex,
-                                                    size_t timeIndex) const {
-  return (*m_rotations)[(*m_linearIndexMap)[detectorIndex][timeIndex]];
+template <typename InstTree, typename PositionStorage>
+Eigen::Quaterniond DetectorInfo<InstTree, PositionStorage>::rotation(
+    size_t detectorIndex, size_t timeIndex) const {
+  return (*m_rotations)[(*m_linearIndexMap)(detectorIndex, timeIndex)];
+}
+
+template <typename InstTree, typename PositionStorage>
+double DetectorInfo<InstTree, PositionStorage>::l1(size_t detectorIndex) const {
+  const DerivedCache &cache = derived();
+  detectorRangeCheck(detectorIndex, m_l1Paths.const_ref());
+  return cache.l1.const_ref()[m_l1Paths.const_ref().pathId(detectorIndex)];
+}
+
+/// Scattering angle in radians
+template <typename InstTree, typename PositionStorage>
+double DetectorInfo<InstTree, PositionStorage>::twoTheta(
+    size_t detectorIndex) const {
+  const DerivedCache &cache = derived();
+  detectorRangeCheck(detectorIndex, cache.l2.const_ref());
+  if (m_cacheAngles) {
+    return cache.angles.const_ref().twoTheta(detectorIndex);
+  }
+  return ScatteringAngles::twoTheta(cache.beamFrame,
+                                    scatteredDirection(detectorIndex));
+}
+
+template <typename InstTree, typename PositionStorage>
+double DetectorInfo<InstTree, PositionStorage>::twoTheta(
+    size_t detectorIndex, size_t timeIndex) const {
+  const DerivedCache &cache = derived();
+  detectorRangeCheck(detectorIndex, cache.l2.const_ref());
+  const size_t linearIndex = (*m_linearIndexMap)(detectorIndex, timeIndex);
+  if (m_cacheAngles) {
+    return cache.angles.const_ref().twoTheta(linearIndex);
+  }
+  return ScatteringAngles::twoTheta(cache.beamFrame,
+                                    scatteredDirection(linearIndex));
+}
+
+/// Scattering angle in radians, negative on the -x side of the BeamFrame
+template <typename InstTree, typename PositionStorage>
+double DetectorInfo<InstTree, PositionStorage>::signedTwoTheta(
+    size_t detectorIndex) const {
+  const DerivedCache &cache = derived();
+  detectorRangeCheck(detectorIndex, cache.l2.const_ref());
+  if (m_cacheAngles) {
+    return cache.angles.const_ref().signedTwoTheta(detectorIndex);
+  }
+  return ScatteringAngles::signedTwoTheta(cache.beamFrame,
+                                          scatteredDirection(detectorIndex));
+}
+
+template <typename InstTree, typename PositionStorage>
+double DetectorInfo<InstTree, PositionStorage>::signedTwoTheta(
+    size_t detectorIndex, size_t timeIndex) const {
+  const DerivedCache &cache = derived();
+  detectorRangeCheck(detectorIndex, cache.l2.const_ref());
+  const size_t linearIndex = (*m_linearIndexMap)(detectorIndex, timeIndex);
+  if (m_cacheAngles) {
+    return cache.angles.const_ref().signedTwoTheta(linearIndex);
+  }
+  return ScatteringAngles::signedTwoTheta(cache.beamFrame,
+                                          scatteredDirection(linearIndex));
+}
+
+/// Azimuth in radians of the scattered direction about the beam
+template <typename InstTree, typename PositionStorage>
+double DetectorInfo<InstTree, PositionStorage>::phi(
+    size_t detectorIndex) const {
+  const DerivedCache &cache = derived();
+  detectorRangeCheck(detectorIndex, cache.l2.const_ref());
+  if (m_cacheAngles) {
+    return cache.angles.const_ref().phi(detectorIndex);
+  }
+  return ScatteringAngles::phi(cache.beamFrame,
+                               scatteredDirection(detectorIndex));
 }
 
-template <typename InstTree>
-double DetectorInfo<InstTree>::l1(size_t detectorIndex) const {
-  detectorRangeCheck(detectorIndex, m_l1.const_ref());
-  return m_l1.const_ref()[detectorIndex];
+template <typename InstTree, typename PositionStorage>
+double DetectorInfo<InstTree, PositionStorage>::phi(
+    size_t detectorIndex, size_t timeIndex) const {
+  const DerivedCache &cache = derived();
+  detectorRangeCheck(detectorIndex, cache.l2.const_ref());
+  const size_t linearIndex = (*m_linearIndexMap)(detectorIndex, timeIndex);
+  if (m_cacheAngles) {
+    return cache.angles.const_ref().phi(linearIndex);
+  }
+  return ScatteringAngles::phi(cache.beamFrame,
+                               scatteredDirection(linearIndex));
 }
 
-template <typename InstTree>
-size_t DetectorInfo<InstTree>::detectorSize() const {
+template <typename InstTree, typename PositionStorage>
+size_t DetectorInfo<InstTree, PositionStorage>::detectorSize() const {
   return m_nDetectors;
 }
 
-template <typename InstTree>
-const InstTree &DetectorInfo<InstTree>::const_instrumentTree() const {
+template <typename InstTree, typename PositionStorage>
+const InstTree &
+DetectorInfo<InstTree, PositionStorage>::const_instrumentTree() const {
   return m_pathComponentInfo.const_instrumentTree();
 }
 
-template <typename InstTree>
-void DetectorInfo<InstTree>::moveDetector(size_t detectorIndex,
-                                          const Eigen::Vector3d &offset) {
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::moveDetector(
+    size_t detectorIndex, const Eigen::Vector3d &offset) {
 
-  (*m_positions)[detectorIndex] += offset;
+  m_positions->translate(detectorIndex, offset);
 
-  initL2();
+  markL2Stale(detectorIndex);
 }
 
-template <typename InstTree>
-void DetectorInfo<InstTree>::moveDetector(size_t detectorIndex,
-                                          size_t timeIndex,
-                                          const Eigen::Vector3d &offset) {
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::moveDetector(
+    size_t detectorIndex, size_t timeIndex, const Eigen::Vector3d &offset) {
 
-  (*m_positions)[(*m_linearIndexMap)[detectorIndex][timeIndex]] += offset;
+  const size_t linearIndex = (*m_linearIndexMap)(detectorIndex, timeIndex);
+  m_positions->translate(linearIndex, offset);
 
-  initL2();
+  markL2Stale(linearIndex);
 }
 
-template <typename InstTree>
-void DetectorInfo<InstTree>::moveDetectors(
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::moveDetectors(
     const std::vector<size_t> &detectorIndexes, const Eigen::Vector3d &offset) {
 
+  m_positions->translate(detectorIndexes, offset);
   for (auto &detIndex : detectorIndexes) {
-    (*m_positions)[detIndex] += offset;
+    markL2Stale(detIndex);
   }
-
-  initL2();
 }
 
-template <typename InstTree>
-void DetectorInfo<InstTree>::rotateDetector(size_t detectorIndex,
-                                            const Eigen::Vector3d &axis,
-                                            const double &theta,
-                                            const Eigen::Vector3d &center) {
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::rotateDetector(
+    size_t detectorIndex, const Eigen::Vector3d &axis, const double &theta,
+    const Eigen::Vector3d &center) {
 
   using namespace Eigen;
   const auto transform =
       Translation3d(center) * AngleAxisd(theta, axis) * Translation3d(-center);
   const auto rotation = transform.rotation();
 
-  (*m_positions)[detectorIndex] = transform * (*m_positions)[detectorIndex];
+  m_positions->transform(detectorIndex, transform);
   (*m_rotations)[detectorIndex] = rotation * (*m_rotations)[detectorIndex];
 
-  initL2();
+  markL2Stale(detectorIndex);
 }
 
-template <typename InstTree>
-void DetectorInfo<InstTree>::rotateDetectors(
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::rotateDetectors(
     const std::vector<size_t> &detectorIndexes, const Eigen::Vector3d &axis,
     const double &theta, const Eigen::Vector3d &center) {
 
@@ -511,17 +951,55 @@ void DetectorInfo<InstTree>::rotateDetectors(
   const auto transform =
       Translation3d(center) * AngleAxisd(theta, axis) * Translation3d(-center);
   const auto rotation = transform.rotation();
+  m_positions->transform(detectorIndexes, transform);
   for (auto &detIndex : detectorIndexes) {
 
-    (*m_positions)[detIndex] = transform * (*m_positions)[detIndex];
     (*m_rotations)[detIndex] = rotation * (*m_rotations)[detIndex];
+    markL2Stale(detIndex);
   }
+}
 
-  initL2();
+/**
+ * Move detectors [begin, end), e.g. the detectors of a sub-tree (see
+ * FlatTree::subTree).
+ */
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::moveDetectorRange(
+    size_t begin, size_t end, const Eigen::Vector3d &offset) {
+  if (begin == end) {
+    return;
+  }
+
+  m_positions->translateRange(begin, end, offset);
+  markL2Stale(begin, end);
+}
+
+/**
+ * Rotate detectors [begin, end), e.g. the detectors of a sub-tree (see
+ * FlatTree::subTree).
+ */
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::rotateDetectorRange(
+    size_t begin, size_t end, const Eigen::Vector3d &axis, const double &theta,
+    const Eigen::Vector3d &center) {
+  if (begin == end) {
+    return;
+  }
+
+  using namespace Eigen;
+  const auto transform =
+      Translation3d(center) * AngleAxisd(theta, axis) * Translation3d(-center);
+  const Quaterniond rotation(transform.rotation());
+  m_positions->transformRange(begin, end, transform);
+  auto &rotations = *m_rotations;
+  for (size_t detIndex = begin; detIndex < end; ++detIndex) {
+    rotations[detIndex] = rotation * rotations[detIndex];
+  }
+  markL2Stale(begin, end);
 }
 
-template <typename InstTree>
-void DetectorInfo<InstTree>::rotatePathComponents(
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::rotatePathComponents(
     const std::vector<size_t> &pathComponentIndexes,
     const Eigen::Vector3d &axis, const double &theta,
     const Eigen::Vector3d &center) {
@@ -529,23 +1007,48 @@ void DetectorInfo<InstTree>::rotatePathComponents(
   m_pathComponentInfo.rotatePathComponents(pathComponentIndexes, axis, theta,
                                            center);
 
-  initL1();
-  initL2();
+  markPathsStale();
 }
 
-template <typename InstTree>
-void DetectorInfo<InstTree>::movePathComponents(
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::movePathComponents(
     const std::vector<size_t> &pathComponentIndexes,
     const Eigen::Vector3d &offset) {
 
   m_pathComponentInfo.movePathComponents(pathComponentIndexes, offset);
 
-  initL1();
-  initL2();
+  markPathsStale();
+}
+
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::movePathComponentRange(
+    size_t begin, size_t end, const Eigen::Vector3d &offset) {
+
+  if (begin == end) {
+    return;
+  }
+  m_pathComponentInfo.movePathComponentRange(begin, end, offset);
+
+  markPathsStale();
+}
+
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::rotatePathComponentRange(
+    size_t begin, size_t end, const Eigen::Vector3d &axis, const double &theta,
+    const Eigen::Vector3d &center) {
+
+  if (begin == end) {
+    return;
+  }
+  m_pathComponentInfo.rotatePathComponentRange(begin, end, axis, theta,
+                                               center);
+
+  markPathsStale();
 }
 
-template <typename InstTree>
-std::vector<Spectrum> DetectorInfo<InstTree>::makeSpectra() const {
+template <typename InstTree, typename PositionStorage>
+std::vector<Spectrum>
+DetectorInfo<InstTree, PositionStorage>::makeSpectra() const {
   std::vector<Spectrum> spectra;
   const size_t spectraSize = m_positions->size();
   spectra.reserve(spectraSize);
@@ -555,21 +1058,278 @@ std::vector<Spectrum> DetectorInfo<InstTree>::makeSpectra() const {
   return spectra;
 }
 
-template <typename InstTree> CowPtr<L2s> DetectorInfo<InstTree>::l2s() const {
-  return m_l2;
+template <typename InstTree, typename PositionStorage>
+CowPtr<L2s> DetectorInfo<InstTree, PositionStorage>::l2s() const {
+  return derived().l2;
 }
 
-template <typename InstTree>
+/**
+ * Scattering angles of all linear indexes. Shares the cache if
+ * cacheScatteringAngles() was called, otherwise calculates them afresh.
+ */
+template <typename InstTree, typename PositionStorage>
+CowPtr<ScatteringAngles>
+DetectorInfo<InstTree, PositionStorage>::scatteringAngles() const {
+  const DerivedCache &cache = derived();
+  if (m_cacheAngles) {
+    return cache.angles;
+  }
+  auto angles =
+      std::make_shared<ScatteringAngles>(cache.l2.const_ref().size());
+  calculateAngles(*angles);
+  return CowPtr<ScatteringAngles>(angles);
+}
+
+/**
+ * Keep the scattering angles of every linear index cached from now on,
+ * updated alongside L2. Costs five doubles per linear index, in exchange for
+ * no trigonometry on reads.
+ */
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::cacheScatteringAngles() {
+  if (m_cacheAngles) {
+    return;
+  }
+  // Angles are measured in the current beam frame.
+  refresh();
+  auto angles =
+      std::make_shared<ScatteringAngles>(m_derived.l2.const_ref().size());
+  calculateAngles(*angles);
+  m_derived.angles = CowPtr<ScatteringAngles>(angles);
+  m_cacheAngles = true;
+}
+
+template <typename InstTree, typename PositionStorage>
+bool DetectorInfo<InstTree, PositionStorage>::cachesScatteringAngles() const {
+  return m_cacheAngles;
+}
+
+/// Fill angles for every linear index from the current positions
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::calculateAngles(
+    ScatteringAngles &angles) const {
+  parallelFor(angles.size(), [&](size_t begin, size_t end) {
+    for (size_t linearIndex = begin; linearIndex < end; ++linearIndex) {
+      angles.set(linearIndex, m_derived.beamFrame,
+                 scatteredDirection(linearIndex));
+    }
+  });
+}
+
+template <typename InstTree, typename PositionStorage>
 const PathComponentInfo<InstTree> &
-DetectorInfo<InstTree>::pathComponentInfo() const {
+DetectorInfo<InstTree, PositionStorage>::pathComponentInfo() const {
   return m_pathComponentInfo;
 }
 
-template <typename InstTree> bool DetectorInfo<InstTree>::isScanning() const {
+/**
+ * All positions, linearly indexed, in the layout of PositionStorage. Use
+ * PositionStorage::map() for an Eigen view.
+ */
+template <typename InstTree, typename PositionStorage>
+const PositionStorage &
+DetectorInfo<InstTree, PositionStorage>::const_positions() const {
+  return m_positions.const_ref();
+}
+
+/**
+ * Eigen view of all positions, linearly indexed. Equivalent to
+ * const_positions().map().
+ */
+template <typename InstTree, typename PositionStorage>
+typename PositionStorage::ConstMap
+DetectorInfo<InstTree, PositionStorage>::positions() const {
+  return m_positions.const_ref().map();
+}
+
+/**
+ * Eigen view of the positions of all detectors at one time index, in
+ * detector index order. Only available if every detector has the same number
+ * of time indexes, laid out as detectorIndex * scanCount + timeIndex.
+ * @param timeIndex : Time index to view
+ */
+template <typename InstTree, typename PositionStorage>
+typename PositionStorage::ConstStridedMap
+DetectorInfo<InstTree, PositionStorage>::scanPositions(
+    size_t timeIndex) const {
+  const LinearIndexMap &linearIndexMap = *m_linearIndexMap;
+  if (!linearIndexMap.isStrided()) {
+    throw std::logic_error("Positions at a single time index are not evenly "
+                           "spaced for this scanning layout");
+  }
+  if (timeIndex >= linearIndexMap.stride()) {
+    std::stringstream buffer;
+    buffer << "Time index " << timeIndex << " is out of range";
+    throw std::out_of_range(buffer.str());
+  }
+  return m_positions.const_ref().stridedMap(timeIndex, m_nDetectors,
+                                            linearIndexMap.stride());
+}
+
+/// All rotations, linearly indexed. Invalidated by writes, like a Span.
+template <typename InstTree, typename PositionStorage>
+const Rotations &DetectorInfo<InstTree, PositionStorage>::rotations() const {
+  return m_rotations.const_ref();
+}
+
+/// L1 of each unique L1 path. Index with l1PathIds() for per-detector values.
+template <typename InstTree, typename PositionStorage>
+Span<double> DetectorInfo<InstTree, PositionStorage>::l1s() const {
+  return derived().l1.const_ref().rawData();
+}
+
+/// Index into l1s() for each detector
+template <typename InstTree, typename PositionStorage>
+Span<PathId> DetectorInfo<InstTree, PositionStorage>::l1PathIds() const {
+  return m_l1Paths.const_ref().pathIds();
+}
+
+/// Mask flags, detector indexed. Invalidated by writes, like a Span.
+template <typename InstTree, typename PositionStorage>
+const MaskFlags &DetectorInfo<InstTree, PositionStorage>::maskFlags() const {
+  return m_isMasked.const_ref();
+}
+
+/// Monitor flags, detector indexed. Invalidated by writes, like a Span.
+template <typename InstTree, typename PositionStorage>
+const MonitorFlags &
+DetectorInfo<InstTree, PositionStorage>::monitorFlags() const {
+  return m_isMonitor.const_ref();
+}
+
+template <typename InstTree, typename PositionStorage>
+bool DetectorInfo<InstTree, PositionStorage>::isScanning() const {
   return m_isScanning;
 }
-template <typename InstTree> size_t DetectorInfo<InstTree>::scanCount() const {
+template <typename InstTree, typename PositionStorage>
+size_t DetectorInfo<InstTree, PositionStorage>::scanCount() const {
   return m_durations->size();
 }
 
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::openEdit() {
+  ++m_editDepth;
+}
+
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::commitEdit() {
+  if (m_editDepth == 0 || --m_editDepth > 0) {
+    // Only the outermost transaction recalculates.
+    return;
+  }
+  refresh();
+}
+
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::markL2Stale(size_t linearIndex) {
+  m_derived.l2Dirty = true;
+  if (!m_derived.l2Stale) {
+    m_derived.staleL2Indexes.push_back(linearIndex);
+    if (m_derived.staleL2Indexes.size() >=
+        m_derived.l2.const_ref().size()) {
+      // Cheaper to recalculate everything once.
+      m_derived.l2Stale = true;
+      m_derived.staleL2Indexes.clear();
+    }
+  }
+  m_isStale = true;
+}
+
+/// Mark linear indexes [begin, end) as needing their L2 recalculated
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::markL2Stale(size_t begin,
+                                                          size_t end) {
+  if (begin == end) {
+    return;
+  }
+  m_derived.l2Dirty = true;
+  if (!m_derived.l2Stale) {
+    if (m_derived.staleL2Indexes.size() + (end - begin) >=
+        m_derived.l2.const_ref().size()) {
+      // Cheaper to recalculate everything once.
+      m_derived.l2Stale = true;
+      m_derived.staleL2Indexes.clear();
+      m_isStale = true;
+      return;
+    }
+    for (size_t linearIndex = begin; linearIndex < end; ++linearIndex) {
+      m_derived.staleL2Indexes.push_back(linearIndex);
+    }
+  }
+  m_isStale = true;
+}
+
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::markPathsStale() {
+  m_derived.l1Stale = true;
+  m_derived.l2Dirty = true;
+  m_derived.l2Stale = true;
+  m_derived.staleL2Indexes.clear();
+  m_isStale = true;
+}
+
+/// Derived values, brought up to date first
+template <typename InstTree, typename PositionStorage>
+const typename DetectorInfo<InstTree, PositionStorage>::DerivedCache &
+DetectorInfo<InstTree, PositionStorage>::derived() const {
+  refresh();
+  return m_derived;
+}
+
+/**
+ * Recalculate whatever writes have marked stale. Callable from concurrent
+ * const readers: the first to take the lock recalculates, the others wait for
+ * it and find nothing left to do.
+ */
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::refresh() const {
+  if (!m_isStale.load(std::memory_order_acquire)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(m_derivedMutex);
+  if (!m_isStale.load(std::memory_order_relaxed)) {
+    return;
+  }
+  refreshL1();
+  refreshL2();
+  m_isStale.store(false, std::memory_order_release);
+}
+
+/// Bring L1 up to date if it has gone stale
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::refreshL1() const {
+  if (m_derived.l1Stale) {
+    initL1();
+    m_derived.l1Stale = false;
+  }
+}
+
+/**
+ * Bring L2 up to date if it has gone stale, recalculating only the recorded
+ * linear indexes where possible.
+ */
+template <typename InstTree, typename PositionStorage>
+void DetectorInfo<InstTree, PositionStorage>::refreshL2() const {
+  if (m_derived.l2Dirty) {
+    if (m_derived.l2Stale) {
+      initL2();
+    } else {
+      for (auto linearIndex : m_derived.staleL2Indexes) {
+        updateL2(linearIndex);
+      }
+    }
+    m_derived.l2Dirty = false;
+    m_derived.l2Stale = false;
+    std::vector<size_t>().swap(m_derived.staleL2Indexes);
+  }
+}
+
+/// Copy of the derived values, taken under the lock that refresh holds
+template <typename InstTree, typename PositionStorage>
+typename DetectorInfo<InstTree, PositionStorage>::DerivedCache
+DetectorInfo<InstTree, PositionStorage>::lockedDerived() const {
+  std::lock_guard<std::mutex> lock(m_derivedMutex);
+  return m_derived;
+}
+
 #endif
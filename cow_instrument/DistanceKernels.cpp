@@ -0,0 +1,176 @@
+#include "DistanceKernels.h"
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DISTANCE_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+void soaScalar(const double *x, const double *y, const double *z,
+               size_t begin, size_t count, const double *point, double offset,
+               double *out) {
+  for (size_t i = begin; i < count; ++i) {
+    const double dx = x[i] - point[0];
+    const double dy = y[i] - point[1];
+    const double dz = z[i] - point[2];
+    out[i] = offset + std::sqrt(dx * dx + dy * dy + dz * dz);
+  }
+}
+
+void aosScalar(const double *xyz, size_t begin, size_t count,
+               const double *point, double offset, double *out) {
+  for (size_t i = begin; i < count; ++i) {
+    const double dx = xyz[3 * i] - point[0];
+    const double dy = xyz[3 * i + 1] - point[1];
+    const double dz = xyz[3 * i + 2] - point[2];
+    out[i] = offset + std::sqrt(dx * dx + dy * dy + dz * dz);
+  }
+}
+
+#ifdef DISTANCE_KERNELS_X86
+
+// Vector lanes form the sum of squares in the same order as the scalar loop.
+
+__attribute__((target("avx2"))) void
+soaAvx2(const double *x, const double *y, const double *z, size_t count,
+        const double *point, double offset, double *out) {
+  const __m256d px = _mm256_set1_pd(point[0]);
+  const __m256d py = _mm256_set1_pd(point[1]);
+  const __m256d pz = _mm256_set1_pd(point[2]);
+  const __m256d off = _mm256_set1_pd(offset);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x + i), px);
+    const __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y + i), py);
+    const __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(z + i), pz);
+    const __m256d sum = _mm256_add_pd(
+        _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+        _mm256_mul_pd(dz, dz));
+    _mm256_storeu_pd(out + i, _mm256_add_pd(off, _mm256_sqrt_pd(sum)));
+  }
+  soaScalar(x, y, z, i, count, point, offset, out);
+}
+
+__attribute__((target("avx2"))) void aosAvx2(const double *xyz, size_t count,
+                                             const double *point,
+                                             double offset, double *out) {
+  const __m256d px = _mm256_set1_pd(point[0]);
+  const __m256d py = _mm256_set1_pd(point[1]);
+  const __m256d pz = _mm256_set1_pd(point[2]);
+  const __m256d off = _mm256_set1_pd(offset);
+  const __m256i stride = _mm256_set_epi64x(9, 6, 3, 0);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const double *base = xyz + 3 * i;
+    const __m256d dx =
+        _mm256_sub_pd(_mm256_i64gather_pd(base, stride, 8), px);
+    const __m256d dy =
+        _mm256_sub_pd(_mm256_i64gather_pd(base + 1, stride, 8), py);
+    const __m256d dz =
+        _mm256_sub_pd(_mm256_i64gather_pd(base + 2, stride, 8), pz);
+    const __m256d sum = _mm256_add_pd(
+        _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+        _mm256_mul_pd(dz, dz));
+    _mm256_storeu_pd(out + i, _mm256_add_pd(off, _mm256_sqrt_pd(sum)));
+  }
+  aosScalar(xyz, i, count, point, offset, out);
+}
+
+__attribute__((target("avx512f"))) void
+soaAvx512(const double *x, const double *y, const double *z, size_t count,
+          const double *point, double offset, double *out) {
+  const __m512d px = _mm512_set1_pd(point[0]);
+  const __m512d py = _mm512_set1_pd(point[1]);
+  const __m512d pz = _mm512_set1_pd(point[2]);
+  const __m512d off = _mm512_set1_pd(offset);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m512d dx = _mm512_sub_pd(_mm512_loadu_pd(x + i), px);
+    const __m512d dy = _mm512_sub_pd(_mm512_loadu_pd(y + i), py);
+    const __m512d dz = _mm512_sub_pd(_mm512_loadu_pd(z + i), pz);
+    const __m512d sum = _mm512_add_pd(
+        _mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy)),
+        _mm512_mul_pd(dz, dz));
+    _mm512_storeu_pd(out + i, _mm512_add_pd(off, _mm512_sqrt_pd(sum)));
+  }
+  soaScalar(x, y, z, i, count, point, offset, out);
+}
+
+__attribute__((target("avx512f"))) void
+aosAvx512(const double *xyz, size_t count, const double *point, double offset,
+          double *out) {
+  const __m512d px = _mm512_set1_pd(point[0]);
+  const __m512d py = _mm512_set1_pd(point[1]);
+  const __m512d pz = _mm512_set1_pd(point[2]);
+  const __m512d off = _mm512_set1_pd(offset);
+  const __m512i stride = _mm512_set_epi64(21, 18, 15, 12, 9, 6, 3, 0);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const double *base = xyz + 3 * i;
+    const __m512d dx =
+        _mm512_sub_pd(_mm512_i64gather_pd(stride, base, 8), px);
+    const __m512d dy =
+        _mm512_sub_pd(_mm512_i64gather_pd(stride, base + 1, 8), py);
+    const __m512d dz =
+        _mm512_sub_pd(_mm512_i64gather_pd(stride, base + 2, 8), pz);
+    const __m512d sum = _mm512_add_pd(
+        _mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy)),
+        _mm512_mul_pd(dz, dz));
+    _mm512_storeu_pd(out + i, _mm512_add_pd(off, _mm512_sqrt_pd(sum)));
+  }
+  aosScalar(xyz, i, count, point, offset, out);
+}
+
+enum class InstructionSet { Scalar, Avx2, Avx512 };
+
+InstructionSet detectInstructionSet() {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return InstructionSet::Avx512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return InstructionSet::Avx2;
+  }
+  return InstructionSet::Scalar;
+}
+
+InstructionSet instructionSet() {
+  static const InstructionSet supported = detectInstructionSet();
+  return supported;
+}
+
+#endif
+}
+
+void offsetDistancesSoA(const double *x, const double *y, const double *z,
+                        size_t count, const double *point, double offset,
+                        double *out) {
+#ifdef DISTANCE_KERNELS_X86
+  switch (instructionSet()) {
+  case InstructionSet::Avx512:
+    return soaAvx512(x, y, z, count, point, offset, out);
+  case InstructionSet::Avx2:
+    return soaAvx2(x, y, z, count, point, offset, out);
+  case InstructionSet::Scalar:
+    break;
+  }
+#endif
+  soaScalar(x, y, z, 0, count, point, offset, out);
+}
+
+void offsetDistancesAoS(const double *xyz, size_t count, const double *point,
+                        double offset, double *out) {
+#ifdef DISTANCE_KERNELS_X86
+  switch (instructionSet()) {
+  case InstructionSet::Avx512:
+    return aosAvx512(xyz, count, point, offset, out);
+  case InstructionSet::Avx2:
+    return aosAvx2(xyz, count, point, offset, out);
+  case InstructionSet::Scalar:
+    break;
+  }
+#endif
+  aosScalar(xyz, 0, count, point, offset, out);
+}
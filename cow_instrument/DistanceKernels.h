@@ -0,0 +1,25 @@
+#ifndef DISTANCE_KERNELS_H
+#define DISTANCE_KERNELS_H
+
+#include <cstddef>
+
+/**
+ * Bulk distance kernels. Both compute
+ *
+ *   out[i] = offset + |position[i] - point|
+ *
+ * for count positions, as needed for L2 when every detector scatters from the
+ * same point. The widest instruction set supported by the running CPU is
+ * selected at run time: AVX-512, then AVX2, then a scalar fallback.
+ */
+
+/// Positions held as separate x, y and z arrays (see SoAPositions).
+void offsetDistancesSoA(const double *x, const double *y, const double *z,
+                        size_t count, const double *point, double offset,
+                        double *out);
+
+/// Positions held interleaved as x0 y0 z0 x1 y1 z1 ... (see AoSPositions).
+void offsetDistancesAoS(const double *xyz, size_t count, const double *point,
+                        double offset, double *out);
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef EDIT_TRANSACTION_H
+#define EDIT_TRANSACTION_H
+
+/**
+ * EditTransaction. Scoped batch-edit over an Info type (DetectorInfo,
+ * ComponentInfo). Geometry writes on the Info only record what has gone
+ * stale. Committing the outermost transaction brings the derived values (L1,
+ * L2, scattering angles) up to date in one pass.
+ *
+ * Typical usage:
+ *        EditTransaction<DetectorInfo<FlatTree>> tx(detectorInfo);
+ *        detectorInfo.moveDetector(...);
+ *        detectorInfo.rotateDetector(...);
+ *        tx.commit();
+ *
+ * Reads while a transaction is open see every write made so far, derived
+ * values included: such a read recalculates what has gone stale since, as it
+ * would outside a transaction. Avoid reads in between writes to keep to a
+ * single recalculation.
+ *
+ * commit() reports any failure to bring the derived values up to date. A
+ * transaction destroyed without a commit still closes its edit and attempts
+ * the same update, but cannot report a failure; the derived values then stay
+ * marked stale and are recalculated by the next read or commit.
+ *
+ * The transaction holds a pointer to the Info, so the Info must outlive it
+ * and must not be moved, or assigned to, while it is open. Transactions
+ * themselves can be neither copied nor moved.
+ */
+template <typename Info> class EditTransaction {
+public:
+  explicit EditTransaction(Info &info);
+  EditTransaction(const EditTransaction<Info> &) = delete;
+  EditTransaction(EditTransaction<Info> &&) = delete;
+  EditTransaction<Info> &operator=(const EditTransaction<Info> &) = delete;
+  EditTransaction<Info> &operator=(EditTransaction<Info> &&) = delete;
+  ~EditTransaction();
+
+  void commit();
+
+  bool isOpen() const;
+
+private:
+  Info *m_info;
+};
+
+template <typename Info>
+EditTransaction<Info>::EditTransaction(Info &info)
+    : m_info(&info) {
+  m_info->openEdit();
+}
+
+template <typename Info> EditTransaction<Info>::~EditTransaction() {
+  try {
+    commit();
+  } catch (...) {
+    // Throwing from a destructor terminates. The edit is closed regardless
+    // (see commit), so the Info remains usable.
+  }
+}
+
+/**
+ * Close the transaction. Closing the outermost transaction brings the derived
+ * values up to date, and rethrows any failure to do so. The edit is closed
+ * even then.
+ */
+template <typename Info> void EditTransaction<Info>::commit() {
+  if (m_info) {
+    Info *info = m_info;
+    m_info = nullptr;
+    info->commitEdit();
+  }
+}
+
+template <typename Info> bool EditTransaction<Info>::isOpen() const {
+  return m_info != nullptr;
+}
+
+#endif
@@ -8,6 +8,8 @@
 #include <string>
 #include <algorithm>
 #include <iterator>
+#include <numeric>
+#include <stdexcept>
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 
@@ -21,8 +23,13 @@ namespace {
  */
 void findKeyComponents(const Component &component, LinkedTreeParser &info) {
 
-  // Walk through and register all detectors on the store.
-  component.registerContents(info);
+  // Walk through and register all detectors on the store. Banks below a
+  // composite root are walked in parallel.
+  if (auto composite = dynamic_cast<const CompositeComponent *>(&component)) {
+    info.registerCompositeInParallel(composite);
+  } else {
+    component.registerContents(info);
+  }
 }
 }
 
@@ -41,7 +48,6 @@ FlatTree::FlatTree(std::shared_ptr<Component> componentRoot)
   }
   m_sourceIndex = sourceIndex;
   m_sampleIndex = sampleIndex;
-  m_proxies = treeParser.proxies();
   m_positions = treeParser.startPositions();
   m_rotations = treeParser.startRotations();
   m_componentIds = treeParser.componentIds();
@@ -52,19 +58,20 @@ FlatTree::FlatTree(std::shared_ptr<Component> componentRoot)
   m_detectorComponentIndexes = treeParser.detectorComponentIndexes();
   m_branchNodeComponentIndexes = treeParser.branchNodeComponentIndexes();
   m_detectorIds = treeParser.detectorIds();
+  initIdIndexes();
+  initTopology(treeParser.parents());
+  initSubTrees();
 }
 
 /**
  * @brief FlatTree::FlatTree
  *
- * Prototype new constructor that bypasses the need to do anything with the
- *Component virtual
- * hierachy at all.
- *
- * Complexity of this constructor suggests that a constructional helper is
- *missing.
+ * Constructor that bypasses the need to do anything with the Component
+ * virtual hierarchy at all. The arrays must be consistent with one another and
+ * in depth-first order; prefer FlatTreeBuilder, which assembles them
+ * component by component and calls this constructor.
  *
- * @param proxies
+ * @param parents : Parent component index of each component, -1 for the root
  * @param positions
  * @param rotations
  * @param componentIds
@@ -77,20 +84,23 @@ FlatTree::FlatTree(std::shared_ptr<Component> componentRoot)
  * @param detectorIds
  * @param sourceIndex
  * @param sampleIndex
+ * @throws std::invalid_argument if the components are not in depth-first order,
+ * the detector, path or branch node indexes are not in component order, or
+ * there are more components than IndexType can index.
  */
-FlatTree::FlatTree(std::vector<ComponentProxy> &&proxies,
+FlatTree::FlatTree(std::vector<int64_t> &&parents,
                    std::vector<Eigen::Vector3d> &&positions,
                    std::vector<Eigen::Quaterniond> &&rotations,
                    std::vector<ComponentIdType> &&componentIds,
                    std::vector<Eigen::Vector3d> &&entryPoints,
                    std::vector<Eigen::Vector3d> &&exitPoints,
                    std::vector<double> &&pathLengths,
-                   std::vector<size_t> &&pathComponentIndexes,
-                   std::vector<size_t> &&detectorComponentIndexes,
-                   std::vector<size_t> &&branchNodeComponentIndexes,
+                   std::vector<IndexType> &&pathComponentIndexes,
+                   std::vector<IndexType> &&detectorComponentIndexes,
+                   std::vector<IndexType> &&branchNodeComponentIndexes,
                    std::vector<DetectorIdType> &&detectorIds,
                    size_t sourceIndex, size_t sampleIndex)
-    : m_proxies(std::move(proxies)), m_positions(std::move(positions)),
+    : m_positions(std::move(positions)),
       m_rotations(std::move(rotations)),
       m_componentIds(std::move(componentIds)),
       m_entryPoints(std::move(entryPoints)),
@@ -105,9 +115,105 @@ FlatTree::FlatTree(std::vector<ComponentProxy> &&proxies,
      This will currently stop serialization working from this construction mode.
      However,
      serialization is due an update anyway */
+  initIdIndexes();
+  initTopology(parents);
+  initSubTrees();
+}
+
+void FlatTree::initIdIndexes() {
+  m_detectorIdIndex =
+      std::make_shared<const IdIndex<DetectorIdType>>(m_detectorIds);
+  m_componentIdIndex =
+      std::make_shared<const IdIndex<ComponentIdType>>(m_componentIds);
+}
+
+namespace {
+
+/**
+ * Number of the given components before each component index, plus the total
+ * at [componentSize]. The components must be in ascending order.
+ */
+std::vector<size_t> countBefore(const std::vector<IndexType> &componentIndexes,
+                                size_t componentSize, const char *kind) {
+  if (!std::is_sorted(componentIndexes.begin(), componentIndexes.end())) {
+    throw std::invalid_argument(std::string("FlatTree: ") + kind +
+                                " indexes are not in component order");
+  }
+  std::vector<size_t> before(componentSize + 1, 0);
+  for (auto componentIndex : componentIndexes) {
+    ++before[componentIndex + 1];
+  }
+  std::partial_sum(before.begin(), before.end(), before.begin());
+  return before;
+}
+}
+
+/**
+ * @param parents : Parent of each component, -1 for the root
+ * @throws std::invalid_argument unless component 0 is the only root and every
+ * other component follows its parent
+ */
+void FlatTree::initTopology(const std::vector<int64_t> &parents) {
+  if (parents.size() > maxIndex) {
+    throw std::invalid_argument(
+        "FlatTree: too many components for the index type");
+  }
+  m_parents.resize(parents.size());
+  for (size_t i = 0; i < parents.size(); ++i) {
+    const int64_t parent = parents[i];
+    const bool valid =
+        i == 0 ? parent == -1 : (parent >= 0 && parent < int64_t(i));
+    if (!valid) {
+      throw std::invalid_argument(
+          "FlatTree: components are not in depth-first order");
+    }
+    m_parents[i] = IndexType(i == 0 ? 0 : parent);
+  }
+  makeChildIndexes(parents, m_childOffsets, m_children);
+}
+
+void FlatTree::initSubTrees() {
+  const size_t nComponents = m_parents.size();
+
+  // End of each sub-tree. In depth-first order a component's children follow
+  // it, each directly after the sub-tree of the one before, so a reverse
+  // sweep finds every child's end before its parent's.
+  std::vector<size_t> end(nComponents);
+  for (size_t i = nComponents; i-- > 0;) {
+    size_t next = i + 1;
+    for (size_t c = m_childOffsets[i]; c < m_childOffsets[i + 1]; ++c) {
+      const size_t child = m_children[c];
+      if (child != next) {
+        throw std::invalid_argument(
+            "FlatTree: components are not in depth-first order");
+      }
+      next = end[child];
+    }
+    end[i] = next;
+  }
+  if (nComponents > 0 && end[0] != nComponents) {
+    throw std::invalid_argument(
+        "FlatTree: not all components are below the root");
+  }
+
+  const auto detectorsBefore =
+      countBefore(m_detectorComponentIndexes, nComponents, "detector");
+  const auto pathsBefore =
+      countBefore(m_pathComponentIndexes, nComponents, "path component");
+  const auto branchNodesBefore =
+      countBefore(m_branchNodeComponentIndexes, nComponents, "branch node");
+
+  m_subTrees.resize(nComponents);
+  for (size_t i = 0; i < nComponents; ++i) {
+    auto &subTree = m_subTrees[i];
+    subTree.components = {i, end[i]};
+    subTree.detectors = {detectorsBefore[i], detectorsBefore[end[i]]};
+    subTree.pathComponents = {pathsBefore[i], pathsBefore[end[i]]};
+    subTree.branchNodes = {branchNodesBefore[i], branchNodesBefore[end[i]]};
+  }
 }
 
-const ComponentProxy &FlatTree::rootProxy() const { return m_proxies[0]; }
+ComponentProxy FlatTree::rootProxy() const { return proxyAt(0); }
 
 void FlatTree::fillDetectorMap(std::map<DetectorIdType, size_t> &toFill) const {
 
@@ -125,6 +231,33 @@ FlatTree::fillComponentMap(std::map<ComponentIdType, size_t> &toFill) const {
   }
 }
 
+/**
+ * Detector index of a detector id. O(1).
+ * @throws std::out_of_range if no detector has the id
+ */
+size_t FlatTree::detectorIndex(const DetectorIdType &detectorId) const {
+  return (*m_detectorIdIndex)[detectorId];
+}
+
+/**
+ * Component index of a component id. O(1).
+ * @throws std::out_of_range if no component has the id
+ */
+size_t FlatTree::componentIndex(const ComponentIdType &componentId) const {
+  return (*m_componentIdIndex)[componentId];
+}
+
+/**
+ * Detector index of each detector id, e.g. for a stream of events. Unknown
+ * ids give IdIndex<DetectorIdType>::npos.
+ * @param detectorIds : Ids to look up
+ * @param detectorIndexes : Resized and filled with the indexes
+ */
+void FlatTree::detectorIndexes(const std::vector<DetectorIdType> &detectorIds,
+                               std::vector<size_t> &detectorIndexes) const {
+  m_detectorIdIndex->find(detectorIds, detectorIndexes);
+}
+
 size_t FlatTree::sampleComponentIndex() const {
   return pathIndexToCompIndex(m_sampleIndex);
 }
@@ -137,23 +270,31 @@ size_t FlatTree::samplePathIndex() const { return m_sampleIndex; }
 
 size_t FlatTree::sourcePathIndex() const { return m_sourceIndex; }
 
-size_t FlatTree::componentSize() const { return m_proxies.size(); }
+size_t FlatTree::componentSize() const { return m_parents.size(); }
 
+/**
+ * Component indexes of the sub-tree of proxyIndex, in depth-first order. Note
+ * that the query proxy index is also returned. Prefer subTree, which does not
+ * allocate.
+ */
 std::vector<size_t> FlatTree::subTreeIndexes(size_t proxyIndex) const {
+  const auto components = subTree(proxyIndex).components;
+  std::vector<size_t> subtree(components.size());
+  std::iota(subtree.begin(), subtree.end(), components.begin);
+  return subtree;
+}
+
+/**
+ * Component, detector, path component and branch node index ranges of the
+ * sub-tree of proxyIndex, proxyIndex included.
+ * @throws std::invalid_argument if proxyIndex is out of range
+ */
+SubTree FlatTree::subTree(size_t proxyIndex) const {
   if (proxyIndex >= componentSize()) {
     throw std::invalid_argument("No subtree for proxy index: " +
                                 std::to_string(proxyIndex));
   }
-
-  // Note that the query proxy index is also returned
-  std::vector<size_t> subtree = {proxyIndex};
-  for (size_t index = 0; index < subtree.size(); ++index) {
-    const auto &currentProxy = m_proxies[subtree[index]];
-    const auto &currentChildren = currentProxy.children();
-    std::copy(currentChildren.begin(), currentChildren.end(),
-              std::back_inserter(subtree));
-  }
-  return subtree;
+  return m_subTrees[proxyIndex];
 }
 
 std::vector<size_t> FlatTree::nextLevelIndexes(size_t proxyIndex) const {
@@ -162,37 +303,39 @@ std::vector<size_t> FlatTree::nextLevelIndexes(size_t proxyIndex) const {
                                 std::to_string(proxyIndex));
   }
 
-  const auto &currentProxy = m_proxies[proxyIndex];
-  return currentProxy.children();
+  const auto children = proxyAt(proxyIndex).children();
+  return std::vector<size_t>(children.begin(), children.end());
 }
 
-std::vector<Eigen::Vector3d> FlatTree::startPositions() const {
+const std::vector<Eigen::Vector3d> &FlatTree::startPositions() const {
   return m_positions;
 }
 
-std::vector<Eigen::Quaterniond> FlatTree::startRotations() const {
+const std::vector<Eigen::Quaterniond> &FlatTree::startRotations() const {
   return m_rotations;
 }
 
-std::vector<Eigen::Vector3d> FlatTree::startExitPoints() const {
+const std::vector<Eigen::Vector3d> &FlatTree::startExitPoints() const {
   return m_exitPoints;
 }
 
-std::vector<Eigen::Vector3d> FlatTree::startEntryPoints() const {
+const std::vector<Eigen::Vector3d> &FlatTree::startEntryPoints() const {
   return m_entryPoints;
 }
 
-std::vector<double> FlatTree::pathLengths() const { return m_pathLengths; }
+const std::vector<double> &FlatTree::pathLengths() const {
+  return m_pathLengths;
+}
 
-std::vector<size_t> FlatTree::detectorComponentIndexes() const {
+const std::vector<IndexType> &FlatTree::detectorComponentIndexes() const {
   return m_detectorComponentIndexes;
 }
 
-std::vector<size_t> FlatTree::pathComponentIndexes() const {
+const std::vector<IndexType> &FlatTree::pathComponentIndexes() const {
   return m_pathComponentIndexes;
 }
 
-std::vector<size_t> FlatTree::branchNodeComponentIndexes() const {
+const std::vector<IndexType> &FlatTree::branchNodeComponentIndexes() const {
   return m_branchNodeComponentIndexes;
 }
 
@@ -216,26 +359,29 @@ size_t FlatTree::nPathComponents() const {
   return m_pathComponentIndexes.size();
 }
 
-const ComponentProxy &FlatTree::proxyAt(size_t index) const {
-  return m_proxies[index];
+/// View of a component's place in the tree. Valid for the life of the tree.
+ComponentProxy FlatTree::proxyAt(size_t index) const {
+  const size_t begin = m_childOffsets[index];
+  const int64_t parent = index == 0 ? -1 : int64_t(m_parents[index]);
+  return ComponentProxy(parent,
+                        Span<IndexType>(m_children.data() + begin,
+                                     m_childOffsets[index + 1] - begin),
+                        m_componentIds[index]);
 }
 
-std::vector<ComponentProxy>::const_iterator FlatTree::begin() const {
-  return m_proxies.begin();
-}
-std::vector<ComponentProxy>::const_iterator FlatTree::end() const {
-  return m_proxies.end();
-}
-std::vector<ComponentProxy>::const_iterator FlatTree::cbegin() const {
-  return m_proxies.cbegin();
+FlatTree::const_iterator FlatTree::begin() const {
+  return const_iterator(*this, 0);
 }
-std::vector<ComponentProxy>::const_iterator FlatTree::cend() const {
-  return m_proxies.cend();
+FlatTree::const_iterator FlatTree::end() const {
+  return const_iterator(*this, componentSize());
 }
+FlatTree::const_iterator FlatTree::cbegin() const { return begin(); }
+FlatTree::const_iterator FlatTree::cend() const { return end(); }
 
 bool FlatTree::operator==(const FlatTree &other) const {
-  // We only need to compare the proxies.
-  return m_proxies == other.m_proxies;
+  // We only need to compare the topology. Child lists follow from parents.
+  return m_parents == other.m_parents &&
+         m_componentIds == other.m_componentIds;
 }
 
 bool FlatTree::operator!=(const FlatTree &other) const {
@@ -6,10 +6,13 @@
 #include <map>
 #include <Eigen/Core>
 #include <Eigen/Geometry>
+#include "ComponentProxy.h"
+#include "IdIndex.h"
 #include "IdType.h"
+#include "IndexType.h"
+#include "SubTree.h"
 
 class Component;
-class ComponentProxy;
 class Detector;
 class PathComponent;
 class PointSource;
@@ -17,61 +20,75 @@ class PointSample;
 
 /*
  Flattened representation of an Instrument Tree.
+
+ Components are stored in depth-first (pre-)order, so the sub-tree of any
+ component is a contiguous block of component indexes starting at that
+ component. Detector, path component and branch node indexes follow the same
+ order, which makes their sub-tree ranges contiguous too (see SubTree).
  */
 class FlatTree {
 public:
+  class const_iterator;
+
   FlatTree(std::shared_ptr<Component> componentRoot);
   /// A construction mechnanism that bypasses the old tree linked-list
   /// constructional approach
-  FlatTree(std::vector<ComponentProxy> &&proxies,
+  FlatTree(std::vector<int64_t> &&parents,
            std::vector<Eigen::Vector3d> &&positions,
            std::vector<Eigen::Quaterniond> &&rotations,
            std::vector<ComponentIdType> &&componentIds,
            std::vector<Eigen::Vector3d> &&entryPoints,
            std::vector<Eigen::Vector3d> &&exitPoints,
            std::vector<double> &&pathLengths,
-           std::vector<size_t> &&pathComponentIndexes,
-           std::vector<size_t> &&detectorComponentIndexes,
-           std::vector<size_t> &&branchNodeComponentIndexes,
+           std::vector<IndexType> &&pathComponentIndexes,
+           std::vector<IndexType> &&detectorComponentIndexes,
+           std::vector<IndexType> &&branchNodeComponentIndexes,
            std::vector<DetectorIdType> &&detectorIds, size_t sourceIndex,
            size_t sampleIndex);
 
-  const ComponentProxy &rootProxy() const;
+  ComponentProxy rootProxy() const;
 
   void fillDetectorMap(std::map<DetectorIdType, size_t> &toFill) const;
   void fillComponentMap(std::map<ComponentIdType, size_t> &toFill) const;
 
+  size_t detectorIndex(const DetectorIdType &detectorId) const;
+  size_t componentIndex(const ComponentIdType &componentId) const;
+  void detectorIndexes(const std::vector<DetectorIdType> &detectorIds,
+                       std::vector<size_t> &detectorIndexes) const;
+
   size_t nDetectors() const;
   size_t nPathComponents() const;
   size_t nBranchNodeComponents() const;
 
-  const ComponentProxy &proxyAt(size_t index) const;
+  ComponentProxy proxyAt(size_t index) const;
 
   size_t samplePathIndex() const;
   size_t sourcePathIndex() const;
   size_t sampleComponentIndex() const;
   size_t sourceComponentIndex() const;
 
-  std::vector<ComponentProxy>::const_iterator begin() const;
-  std::vector<ComponentProxy>::const_iterator end() const;
-  std::vector<ComponentProxy>::const_iterator cbegin() const;
-  std::vector<ComponentProxy>::const_iterator cend() const;
+  const_iterator begin() const;
+  const_iterator end() const;
+  const_iterator cbegin() const;
+  const_iterator cend() const;
 
   size_t componentSize() const;
   /// Enable use to determine all sub-components proxy indexes.
   std::vector<size_t> subTreeIndexes(size_t proxyIndex) const;
+  /// Index ranges of the sub-tree of a component. O(1), no allocation.
+  SubTree subTree(size_t proxyIndex) const;
   /// Enable use to determine sub-component proxy indexes only down to the next
   /// level.
   std::vector<size_t> nextLevelIndexes(size_t proxyIndex) const;
 
-  std::vector<Eigen::Vector3d> startPositions() const;
-  std::vector<Eigen::Quaterniond> startRotations() const;
-  std::vector<Eigen::Vector3d> startExitPoints() const;
-  std::vector<Eigen::Vector3d> startEntryPoints() const;
-  std::vector<double> pathLengths() const;
-  std::vector<size_t> detectorComponentIndexes() const;
-  std::vector<size_t> pathComponentIndexes() const;
-  std::vector<size_t> branchNodeComponentIndexes() const;
+  const std::vector<Eigen::Vector3d> &startPositions() const;
+  const std::vector<Eigen::Quaterniond> &startRotations() const;
+  const std::vector<Eigen::Vector3d> &startExitPoints() const;
+  const std::vector<Eigen::Vector3d> &startEntryPoints() const;
+  const std::vector<double> &pathLengths() const;
+  const std::vector<IndexType> &detectorComponentIndexes() const;
+  const std::vector<IndexType> &pathComponentIndexes() const;
+  const std::vector<IndexType> &branchNodeComponentIndexes() const;
 
   size_t detIndexToCompIndex(size_t detectorIndex) const;
   size_t pathIndexToCompIndex(size_t pathIndex) const;
@@ -94,7 +111,12 @@ private:
    component
    type independent
    */
-  std::vector<ComponentProxy> m_proxies;
+  /// Parent of each component. The root, component 0, has none and holds 0.
+  std::vector<IndexType> m_parents;
+  /// Children of component i are m_children[m_childOffsets[i],
+  /// m_childOffsets[i + 1]). See makeChildIndexes.
+  std::vector<IndexType> m_childOffsets;
+  std::vector<IndexType> m_children;
   std::vector<Eigen::Vector3d> m_positions;
   std::vector<Eigen::Quaterniond> m_rotations;
   std::vector<ComponentIdType> m_componentIds;
@@ -107,14 +129,67 @@ private:
   std::vector<Eigen::Vector3d> m_entryPoints; // For path components
   std::vector<Eigen::Vector3d> m_exitPoints;  // For path components
   std::vector<double> m_pathLengths;          // For path components
-  std::vector<size_t> m_pathComponentIndexes;
-  std::vector<size_t> m_detectorComponentIndexes;
-  std::vector<size_t> m_branchNodeComponentIndexes;
+  std::vector<IndexType> m_pathComponentIndexes;
+  std::vector<IndexType> m_detectorComponentIndexes;
+  std::vector<IndexType> m_branchNodeComponentIndexes;
   std::vector<DetectorIdType> m_detectorIds;
   std::shared_ptr<Component> m_componentRoot;
+
+  /*
+   Id lookups. Built once at construction and shared between copies.
+   */
+  void initIdIndexes();
+  std::shared_ptr<const IdIndex<DetectorIdType>> m_detectorIdIndex;
+  std::shared_ptr<const IdIndex<ComponentIdType>> m_componentIdIndex;
+
+  /// Store the parents and build the child lists from them
+  void initTopology(const std::vector<int64_t> &parents);
+
+  /*
+   Sub-tree ranges, component indexed. Built once at construction.
+   */
+  void initSubTrees();
+  std::vector<SubTree> m_subTrees;
 };
 
 using FlatTree_const_uptr = std::unique_ptr<const FlatTree>;
 using FlatTree_uptr = std::unique_ptr<const FlatTree>;
 
+/// Iterates over the components of a FlatTree, giving a ComponentProxy for each
+class FlatTree::const_iterator {
+public:
+  /// Lets it->member work although proxies are made on the fly
+  struct Arrow {
+    ComponentProxy proxy;
+    const ComponentProxy *operator->() const { return &proxy; }
+  };
+
+  const_iterator(const FlatTree &tree, size_t index)
+      : m_tree(&tree), m_index(index) {}
+
+  ComponentProxy operator*() const { return m_tree->proxyAt(m_index); }
+  Arrow operator->() const { return Arrow{m_tree->proxyAt(m_index)}; }
+
+  const_iterator &operator++() {
+    ++m_index;
+    return *this;
+  }
+  const_iterator operator++(int) {
+    const_iterator before(*this);
+    ++m_index;
+    return before;
+  }
+
+  bool operator==(const const_iterator &other) const {
+    return m_tree == other.m_tree && m_index == other.m_index;
+  }
+  bool operator!=(const const_iterator &other) const {
+    return !operator==(other);
+  }
+
+private:
+  const FlatTree *m_tree;
+  size_t m_index;
+};
+
 #endif
@@ -0,0 +1,230 @@
+#include "FlatTreeBuilder.h"
+#include <stdexcept>
+#include <utility>
+
+namespace {
+Eigen::Quaterniond identity() {
+  return Eigen::Quaterniond{Eigen::Affine3d::Identity().rotation()};
+}
+}
+
+/**
+ * Reserve space in the arrays. A hint only; exceeding it is allowed.
+ * @param nComponents : Total components, assemblies included
+ * @param nDetectors : Detectors
+ * @param nPathComponents : Path components, source and sample included
+ */
+void FlatTreeBuilder::reserve(size_t nComponents, size_t nDetectors,
+                              size_t nPathComponents) {
+  m_parents.reserve(nComponents);
+  m_positions.reserve(nComponents);
+  m_rotations.reserve(nComponents);
+  m_componentIds.reserve(nComponents);
+  m_detectorComponentIndexes.reserve(nDetectors);
+  m_detectorIds.reserve(nDetectors);
+  m_entryPoints.reserve(nPathComponents);
+  m_exitPoints.reserve(nPathComponents);
+  m_pathLengths.reserve(nPathComponents);
+  m_pathComponentIndexes.reserve(nPathComponents);
+  if (nComponents > nDetectors + nPathComponents) {
+    m_branchNodeComponentIndexes.reserve(nComponents - nDetectors -
+                                         nPathComponents);
+  }
+}
+
+/**
+ * Open an assembly, placed at the mean position of its direct children.
+ * @return the component index of the assembly
+ * @throws std::logic_error if the root has already been closed
+ */
+size_t FlatTreeBuilder::beginAssembly(const ComponentIdType &componentId) {
+  const size_t index = beginAssembly(componentId, Eigen::Vector3d::Zero(),
+                                     identity());
+  m_open.back().positionFromChildren = true;
+  return index;
+}
+
+/**
+ * Open an assembly at a given position and rotation.
+ * @return the component index of the assembly
+ * @throws std::logic_error if the root has already been closed
+ */
+size_t FlatTreeBuilder::beginAssembly(const ComponentIdType &componentId,
+                                      const Eigen::Vector3d &position,
+                                      const Eigen::Quaterniond &rotation) {
+  const size_t index = addComponent(componentId, position, rotation);
+  m_branchNodeComponentIndexes.push_back(index);
+  m_open.push_back(OpenAssembly{index, Eigen::Vector3d::Zero(), 0, false});
+  return index;
+}
+
+/**
+ * Close the innermost open assembly.
+ * @throws std::logic_error if no assembly is open
+ */
+void FlatTreeBuilder::endAssembly() {
+  if (m_open.empty()) {
+    throw std::logic_error("FlatTreeBuilder: no assembly to end");
+  }
+  const OpenAssembly assembly = m_open.back();
+  m_open.pop_back();
+  if (assembly.positionFromChildren && assembly.nChildren > 0) {
+    m_positions[assembly.componentIndex] =
+        assembly.childPositionSum / double(assembly.nChildren);
+  }
+  addToParentPosition(m_positions[assembly.componentIndex]);
+}
+
+/**
+ * Add a detector, unrotated, to the innermost open assembly.
+ * @return the component index of the detector
+ * @throws std::logic_error if no assembly is open
+ */
+size_t FlatTreeBuilder::addDetector(const ComponentIdType &componentId,
+                                    const DetectorIdType &detectorId,
+                                    const Eigen::Vector3d &position) {
+  return addDetector(componentId, detectorId, position, identity());
+}
+
+/**
+ * Add a detector to the innermost open assembly.
+ * @return the component index of the detector
+ * @throws std::logic_error if no assembly is open
+ */
+size_t FlatTreeBuilder::addDetector(const ComponentIdType &componentId,
+                                    const DetectorIdType &detectorId,
+                                    const Eigen::Vector3d &position,
+                                    const Eigen::Quaterniond &rotation) {
+  requireOpenAssembly();
+  const size_t index = addComponent(componentId, position, rotation);
+  addToParentPosition(position);
+  m_detectorComponentIndexes.push_back(index);
+  m_detectorIds.push_back(detectorId);
+  return index;
+}
+
+/**
+ * Add a path component to the innermost open assembly.
+ * @return the component index of the path component
+ * @throws std::logic_error if no assembly is open
+ */
+size_t FlatTreeBuilder::addPathComponent(const ComponentIdType &componentId,
+                                         const Eigen::Vector3d &position,
+                                         const Eigen::Quaterniond &rotation,
+                                         const Eigen::Vector3d &entryPoint,
+                                         const Eigen::Vector3d &exitPoint,
+                                         double length) {
+  requireOpenAssembly();
+  const size_t index = addComponent(componentId, position, rotation);
+  addToParentPosition(position);
+  m_pathComponentIndexes.push_back(index);
+  m_entryPoints.push_back(entryPoint);
+  m_exitPoints.push_back(exitPoint);
+  m_pathLengths.push_back(length);
+  return index;
+}
+
+/**
+ * Add a point source, as PointSource, to the innermost open assembly.
+ * @return the component index of the source
+ * @throws std::logic_error if no assembly is open or a source exists
+ */
+size_t FlatTreeBuilder::addSource(const ComponentIdType &componentId,
+                                  const Eigen::Vector3d &position) {
+  requireOpenAssembly();
+  if (m_sourceIndex >= 0) {
+    throw std::logic_error("FlatTreeBuilder: source already added");
+  }
+  const size_t pathIndex = m_pathComponentIndexes.size();
+  const size_t index = addPointPathComponent(componentId, position);
+  m_sourceIndex = pathIndex;
+  return index;
+}
+
+/**
+ * Add a point sample, as PointSample, to the innermost open assembly.
+ * @return the component index of the sample
+ * @throws std::logic_error if no assembly is open or a sample exists
+ */
+size_t FlatTreeBuilder::addSample(const ComponentIdType &componentId,
+                                  const Eigen::Vector3d &position) {
+  requireOpenAssembly();
+  if (m_sampleIndex >= 0) {
+    throw std::logic_error("FlatTreeBuilder: sample already added");
+  }
+  const size_t pathIndex = m_pathComponentIndexes.size();
+  const size_t index = addPointPathComponent(componentId, position);
+  m_sampleIndex = pathIndex;
+  return index;
+}
+
+size_t FlatTreeBuilder::componentSize() const { return m_parents.size(); }
+
+/**
+ * Hand the arrays over to a new FlatTree. The builder is left empty.
+ * @throws std::logic_error if an assembly is still open
+ * @throws std::invalid_argument if there is no source or no sample
+ */
+FlatTree FlatTreeBuilder::build() {
+  if (!m_open.empty()) {
+    throw std::logic_error("FlatTreeBuilder: assemblies left open");
+  }
+  if (m_sourceIndex < 0) {
+    throw std::invalid_argument("Instrument has no marked source");
+  }
+  if (m_sampleIndex < 0) {
+    throw std::invalid_argument("Instrument has no marked sample");
+  }
+  const size_t sourceIndex = m_sourceIndex;
+  const size_t sampleIndex = m_sampleIndex;
+  FlatTree tree(std::move(m_parents), std::move(m_positions),
+                std::move(m_rotations), std::move(m_componentIds),
+                std::move(m_entryPoints), std::move(m_exitPoints),
+                std::move(m_pathLengths), std::move(m_pathComponentIndexes),
+                std::move(m_detectorComponentIndexes),
+                std::move(m_branchNodeComponentIndexes),
+                std::move(m_detectorIds), sourceIndex, sampleIndex);
+  *this = FlatTreeBuilder();
+  return tree;
+}
+
+/// Only an assembly may be the root, so anything else needs a parent.
+void FlatTreeBuilder::requireOpenAssembly() const {
+  if (m_open.empty()) {
+    throw std::logic_error("FlatTreeBuilder: no open assembly to add to");
+  }
+}
+
+size_t FlatTreeBuilder::addComponent(const ComponentIdType &componentId,
+                                     const Eigen::Vector3d &position,
+                                     const Eigen::Quaterniond &rotation) {
+  const size_t index = m_parents.size();
+  if (m_open.empty()) {
+    if (m_hasRoot) {
+      throw std::logic_error("FlatTreeBuilder: root already closed");
+    }
+    m_parents.push_back(-1);
+    m_hasRoot = true;
+  } else {
+    auto &parent = m_open.back();
+    m_parents.push_back(parent.componentIndex);
+    ++parent.nChildren;
+  }
+  m_positions.push_back(position);
+  m_rotations.push_back(rotation);
+  m_componentIds.push_back(componentId);
+  return index;
+}
+
+void FlatTreeBuilder::addToParentPosition(const Eigen::Vector3d &position) {
+  if (!m_open.empty()) {
+    m_open.back().childPositionSum += position;
+  }
+}
+
+size_t
+FlatTreeBuilder::addPointPathComponent(const ComponentIdType &componentId,
+                                       const Eigen::Vector3d &position) {
+  return addPathComponent(componentId, position, identity(), position,
+                          position, 0);
+}
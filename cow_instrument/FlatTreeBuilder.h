@@ -0,0 +1,117 @@
+#ifndef FLATTREEBUILDER_H
+#define FLATTREEBUILDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include "FlatTree.h"
+#include "IdType.h"
+#include "IndexType.h"
+
+/**
+ * Builds a FlatTree by appending components straight into its arrays, without
+ * creating a Component hierarchy first. Building an instrument is then a
+ * linear fill, with no allocation per detector beyond the arrays themselves.
+ *
+ * Components are added depth first. beginAssembly opens an assembly, and
+ * everything added until the matching endAssembly goes below it. The first
+ * assembly opened is the root, so it must be opened before anything else is
+ * added.
+ *
+ * FlatTreeBuilder builder;
+ * builder.reserve(nComponents, nDetectors, 2);
+ * builder.beginAssembly(ComponentIdType(1)); // root
+ * builder.beginAssembly(ComponentIdType(2)); // bank
+ * builder.addDetector(ComponentIdType(3), DetectorIdType(1), position);
+ * ...
+ * builder.endAssembly();
+ * builder.addSource(ComponentIdType(4), sourcePosition);
+ * builder.addSample(ComponentIdType(5), samplePosition);
+ * builder.endAssembly();
+ * FlatTree tree = builder.build();
+ *
+ * As for CompositeComponent, an assembly is placed at the mean position of its
+ * direct children unless a position is given.
+ *
+ * The resulting FlatTree has no root Component, so cannot be serialized.
+ */
+class FlatTreeBuilder {
+public:
+  FlatTreeBuilder() = default;
+
+  void reserve(size_t nComponents, size_t nDetectors, size_t nPathComponents);
+
+  size_t beginAssembly(const ComponentIdType &componentId);
+  size_t beginAssembly(const ComponentIdType &componentId,
+                       const Eigen::Vector3d &position,
+                       const Eigen::Quaterniond &rotation);
+  void endAssembly();
+
+  size_t addDetector(const ComponentIdType &componentId,
+                     const DetectorIdType &detectorId,
+                     const Eigen::Vector3d &position);
+  size_t addDetector(const ComponentIdType &componentId,
+                     const DetectorIdType &detectorId,
+                     const Eigen::Vector3d &position,
+                     const Eigen::Quaterniond &rotation);
+
+  size_t addPathComponent(const ComponentIdType &componentId,
+                          const Eigen::Vector3d &position,
+                          const Eigen::Quaterniond &rotation,
+                          const Eigen::Vector3d &entryPoint,
+                          const Eigen::Vector3d &exitPoint, double length);
+  size_t addSource(const ComponentIdType &componentId,
+                   const Eigen::Vector3d &position);
+  size_t addSample(const ComponentIdType &componentId,
+                   const Eigen::Vector3d &position);
+
+  size_t componentSize() const;
+
+  FlatTree build();
+
+private:
+  size_t addComponent(const ComponentIdType &componentId,
+                      const Eigen::Vector3d &position,
+                      const Eigen::Quaterniond &rotation);
+  size_t addPointPathComponent(const ComponentIdType &componentId,
+                               const Eigen::Vector3d &position);
+  void requireOpenAssembly() const;
+  void addToParentPosition(const Eigen::Vector3d &position);
+
+  /// An assembly still accepting children
+  struct OpenAssembly {
+    size_t componentIndex;
+    /// Sum of the positions of the direct children so far
+    Eigen::Vector3d childPositionSum;
+    /// Direct children so far
+    size_t nChildren;
+    /// Place at the mean of the direct children when closed
+    bool positionFromChildren;
+  };
+  std::vector<OpenAssembly> m_open;
+  bool m_hasRoot = false;
+
+  /// Path index of the source, -1 until added
+  int64_t m_sourceIndex = -1;
+  /// Path index of the sample, -1 until added
+  int64_t m_sampleIndex = -1;
+
+  /*
+   Arrays handed over to FlatTree, as described there.
+   */
+  std::vector<int64_t> m_parents;
+  std::vector<Eigen::Vector3d> m_positions;
+  std::vector<Eigen::Quaterniond> m_rotations;
+  std::vector<ComponentIdType> m_componentIds;
+  std::vector<Eigen::Vector3d> m_entryPoints;
+  std::vector<Eigen::Vector3d> m_exitPoints;
+  std::vector<double> m_pathLengths;
+  std::vector<IndexType> m_pathComponentIndexes;
+  std::vector<IndexType> m_detectorComponentIndexes;
+  std::vector<IndexType> m_branchNodeComponentIndexes;
+  std::vector<DetectorIdType> m_detectorIds;
+};
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * History. Undo/redo and named snapshots over an Info type (DetectorInfo,
+ * ComponentInfo).
+ *
+ * Each recorded version is a plain copy of the Info. Info types hold their
+ * arrays in CowPtrs (and large per-detector arrays in ChunkedVectors), so a
+ * copy shares everything with the live Info, and a later edit duplicates only
+ * the arrays or pages it writes. A version therefore costs memory in
+ * proportion to the edits made since, not to the size of the instrument.
+ *
+ * Typical usage:
+ *        History<DetectorInfo<FlatTree>> history(detectorInfo);
+ *        history.checkpoint();
+ *        detectorInfo.moveDetector(...);
+ *        history.undo(); // detectorInfo as at the checkpoint
+ *
+ * Do not undo, redo or restore while an EditTransaction is open on the Info.
+ */
+template <typename Info> class History {
+public:
+  explicit History(Info &info);
+
+  void checkpoint();
+
+  bool canUndo() const;
+  bool canRedo() const;
+  void undo();
+  void redo();
+
+  void snapshot(const std::string &name);
+  void restore(const std::string &name);
+  bool hasSnapshot(const std::string &name) const;
+  void removeSnapshot(const std::string &name);
+  std::vector<std::string> snapshotNames() const;
+
+private:
+  /// The live Info, modified in place by undo, redo and restore
+  Info &m_info;
+  std::vector<Info> m_undo;
+  std::vector<Info> m_redo;
+  std::map<std::string, Info> m_snapshots;
+};
+
+template <typename Info>
+History<Info>::History(Info &info)
+    : m_info(info) {}
+
+/**
+ * Record the current state as an undo point. Clears the redo stack, as with
+ * any edit.
+ */
+template <typename Info> void History<Info>::checkpoint() {
+  m_undo.push_back(m_info);
+  m_redo.clear();
+}
+
+template <typename Info> bool History<Info>::canUndo() const {
+  return !m_undo.empty();
+}
+
+template <typename Info> bool History<Info>::canRedo() const {
+  return !m_redo.empty();
+}
+
+/// Return to the last checkpoint. The current state can be redone.
+template <typename Info> void History<Info>::undo() {
+  if (m_undo.empty()) {
+    throw std::logic_error("History: nothing to undo");
+  }
+  m_redo.push_back(m_info);
+  m_info = m_undo.back();
+  m_undo.pop_back();
+}
+
+/// Reapply the last undone state
+template <typename Info> void History<Info>::redo() {
+  if (m_redo.empty()) {
+    throw std::logic_error("History: nothing to redo");
+  }
+  m_undo.push_back(m_info);
+  m_info = m_redo.back();
+  m_redo.pop_back();
+}
+
+/// Keep the current state under name, replacing any snapshot of that name
+template <typename Info>
+void History<Info>::snapshot(const std::string &name) {
+  m_snapshots.erase(name);
+  m_snapshots.emplace(name, m_info);
+}
+
+/**
+ * Return to the snapshot called name. This is itself recorded as a checkpoint,
+ * so it can be undone.
+ */
+template <typename Info>
+void History<Info>::restore(const std::string &name) {
+  auto found = m_snapshots.find(name);
+  if (found == m_snapshots.end()) {
+    throw std::out_of_range("History: no snapshot called " + name);
+  }
+  checkpoint();
+  m_info = found->second;
+}
+
+template <typename Info>
+bool History<Info>::hasSnapshot(const std::string &name) const {
+  return m_snapshots.count(name) > 0;
+}
+
+template <typename Info>
+void History<Info>::removeSnapshot(const std::string &name) {
+  m_snapshots.erase(name);
+}
+
+template <typename Info>
+std::vector<std::string> History<Info>::snapshotNames() const {
+  std::vector<std::string> names;
+  for (const auto &snapshot : m_snapshots) {
+    names.push_back(snapshot.first);
+  }
+  return names;
+}
+
+#endif
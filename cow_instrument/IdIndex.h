@@ -0,0 +1,138 @@
+#ifndef ID_INDEX_H
+#define ID_INDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * Immutable lookup from an id (DetectorIdType, ComponentIdType) to the index
+ * at which it was given. Built once from the full list of ids.
+ *
+ * If the ids are dense, i.e. span at most a few times as many values as there
+ * are ids, lookups index a flat array directly. Otherwise an open-addressing
+ * hash table with linear probing is used. Either way a lookup is O(1) and
+ * touches one or two cache lines, unlike a std::map.
+ *
+ * Where an id occurs more than once, the first index is kept.
+ */
+template <typename IdType> class IdIndex {
+public:
+  using Key = typename IdType::StorageType;
+  static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+  IdIndex() = default;
+
+  explicit IdIndex(const std::vector<IdType> &ids) : m_size(ids.size()) {
+    if (ids.empty()) {
+      return;
+    }
+    auto range = std::minmax_element(ids.begin(), ids.end());
+    m_min = range.first->value;
+    const Key span = range.second->value - m_min;
+    if (span / 4 < ids.size()) {
+      m_direct.assign(span + 1, npos);
+      for (size_t i = ids.size(); i-- > 0;) {
+        m_direct[ids[i].value - m_min] = i;
+      }
+      return;
+    }
+
+    // Load factor at most 1/2
+    size_t capacity = 2;
+    m_shift = 63;
+    while (capacity < 2 * ids.size()) {
+      capacity *= 2;
+      --m_shift;
+    }
+    m_slots.resize(capacity);
+    for (size_t i = 0; i < ids.size(); ++i) {
+      const Key key = ids[i].value;
+      size_t slot = hash(key);
+      while (m_slots[slot].index != npos && m_slots[slot].key != key) {
+        slot = (slot + 1) & (capacity - 1);
+      }
+      if (m_slots[slot].index == npos) {
+        m_slots[slot].key = key;
+        m_slots[slot].index = i;
+      }
+    }
+  }
+
+  /// Index of id, or npos if id is unknown
+  size_t find(const IdType &id) const { return find(id.value); }
+
+  /// Index of id. Throws std::out_of_range if id is unknown.
+  size_t operator[](const IdType &id) const {
+    const size_t index = find(id.value);
+    if (index == npos) {
+      std::stringstream buffer;
+      buffer << "Id " << id.value << " is not known";
+      throw std::out_of_range(buffer.str());
+    }
+    return index;
+  }
+
+  /**
+   * Index of each id, e.g. for a stream of detector ids from events. Unknown
+   * ids map to npos rather than throwing.
+   */
+  void find(const std::vector<IdType> &ids, std::vector<size_t> &out) const {
+    out.resize(ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+      out[i] = find(ids[i].value);
+    }
+  }
+
+  /// Number of ids the index was built from, including duplicates
+  size_t size() const { return m_size; }
+
+  /// True if lookups use a flat array rather than a hash table
+  bool isDirect() const { return !m_direct.empty(); }
+
+private:
+  struct Slot {
+    Key key = 0;
+    size_t index = npos;
+  };
+
+  size_t hash(Key key) const {
+    // Fibonacci hashing. Takes the high bits of the product.
+    return size_t((uint64_t(key) * 0x9E3779B97F4A7C15ull) >> m_shift);
+  }
+
+  size_t find(Key key) const {
+    if (!m_direct.empty()) {
+      return key >= m_min && key - m_min < m_direct.size()
+                 ? m_direct[key - m_min]
+                 : npos;
+    }
+    if (m_slots.empty()) {
+      return npos;
+    }
+    const size_t mask = m_slots.size() - 1;
+    for (size_t slot = hash(key);; slot = (slot + 1) & mask) {
+      const Slot &candidate = m_slots[slot];
+      if (candidate.index == npos || candidate.key == key) {
+        return candidate.index;
+      }
+    }
+  }
+
+  size_t m_size = 0;
+  /// Smallest id. Offset of the direct array.
+  Key m_min = 0;
+  /// Index of id m_min + i at i, or npos. Only for dense ids.
+  std::vector<size_t> m_direct;
+  /// Hash table, power of two sized. Only for sparse ids.
+  std::vector<Slot> m_slots;
+  /// 64 - log2(m_slots.size())
+  int m_shift = 64;
+};
+
+template <typename IdType> constexpr size_t IdIndex<IdType>::npos;
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef INDEX_TYPE_H
+#define INDEX_TYPE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+/**
+ * Type in which bulk arrays of component, detector and path component indexes
+ * are stored: the tree topology, Path, Spectrum and the linear index map.
+ *
+ * size_t by default. Building with COMPACT_INDEXES (the CMake option of the
+ * same name) makes it 32 bit, halving the memory those arrays take, and so the
+ * cache they occupy in the L2 and spectrum loops. Instruments are then limited
+ * to 2^32 - 1 components.
+ *
+ * Only storage changes. Indexes are still passed and returned as size_t.
+ */
+#ifdef COMPACT_INDEXES
+using IndexType = uint32_t;
+#else
+using IndexType = size_t;
+#endif
+
+/// Largest index that can be stored
+constexpr size_t maxIndex = std::numeric_limits<IndexType>::max();
+
+/**
+ * Throws std::invalid_argument, naming what, if index cannot be stored as an
+ * IndexType. Compiles away unless COMPACT_INDEXES is set.
+ */
+inline void checkIndexFits(size_t index, const char *what) {
+  if (index > maxIndex) {
+    throw std::invalid_argument(std::string(what) + ": index " +
+                                std::to_string(index) +
+                                " too large for the index type");
+  }
+}
+
+#endif
@@ -1,15 +1,15 @@
 #ifndef L2S_H
 #define L2S_H
 
-#include "FixedLengthVector.h"
+#include "ChunkedVector.h"
 
 /**
- * L2 Values. Used to determine a cached L2.
+ * L2 Values. Used to determine a cached L2. Paged, so that a copy which
+ * recalculates a few L2s copies only the pages holding them.
  */
-class L2s : public FixedLengthVector<L2s, double> {
-  using FixedLengthVector<L2s, double>::FixedLengthVector;
+class L2s : public ChunkedVector<double> {
+public:
+  using ChunkedVector<double>::ChunkedVector;
 };
 
-
-
 #endif
@@ -0,0 +1,121 @@
+#ifndef LINEAR_INDEX_MAP_H
+#define LINEAR_INDEX_MAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "IndexType.h"
+
+/**
+ * Maps (detector index, time index) to the linear index of the corresponding
+ * position in DetectorInfo.
+ *
+ * Held flat rather than as one vector per detector. If every detector has the
+ * same number of scan points, detector i's entries are at i * nScans, so no
+ * offsets are stored. If in addition the linear indexes are simply
+ * i * nScans + t, as for non-scanning instruments and the usual scanning
+ * layout, nothing is stored at all. Otherwise detector i's entries start at
+ * offsets[i] (CSR layout).
+ */
+class LinearIndexMap {
+public:
+  /// One time index per detector, linear index == detector index
+  explicit LinearIndexMap(size_t nDetectors)
+      : m_nDetectors(nDetectors), m_stride(1) {}
+
+  /// timeIndexes[detectorIndex][timeIndex] is the linear index
+  /// @throws std::invalid_argument if an index does not fit IndexType
+  explicit LinearIndexMap(const std::vector<std::vector<size_t>> &timeIndexes)
+      : m_nDetectors(timeIndexes.size()) {
+
+    const size_t nScans = m_nDetectors > 0 ? timeIndexes[0].size() : 0;
+    bool uniform = nScans > 0;
+    bool strided = uniform;
+    for (size_t i = 0; i < m_nDetectors && uniform; ++i) {
+      uniform = timeIndexes[i].size() == nScans;
+      for (size_t t = 0; t < timeIndexes[i].size() && strided; ++t) {
+        strided = timeIndexes[i][t] == i * nScans + t;
+      }
+      strided = strided && uniform;
+    }
+
+    if (strided) {
+      m_stride = nScans;
+      return;
+    }
+
+    if (uniform) {
+      m_stride = nScans;
+      m_indexes.reserve(m_nDetectors * nScans);
+    } else {
+      m_offsets.reserve(m_nDetectors + 1);
+      m_offsets.push_back(0);
+    }
+    for (const auto &detectorIndexes : timeIndexes) {
+      if (!detectorIndexes.empty()) {
+        checkIndexFits(*std::max_element(detectorIndexes.begin(),
+                                         detectorIndexes.end()),
+                       "LinearIndexMap");
+      }
+      m_indexes.insert(m_indexes.end(), detectorIndexes.begin(),
+                       detectorIndexes.end());
+      if (!uniform) {
+        checkIndexFits(m_indexes.size(), "LinearIndexMap");
+        m_offsets.push_back(m_indexes.size());
+      }
+    }
+  }
+
+  /// Linear index of detectorIndex at timeIndex
+  size_t operator()(size_t detectorIndex, size_t timeIndex) const {
+    if (m_stride > 0) {
+      const size_t flatIndex = detectorIndex * m_stride + timeIndex;
+      return m_indexes.empty() ? flatIndex : m_indexes[flatIndex];
+    }
+    return m_indexes[m_offsets[detectorIndex] + timeIndex];
+  }
+
+  /// Number of detectors
+  size_t size() const { return m_nDetectors; }
+
+  /// Number of time indexes held for detectorIndex
+  size_t scanCount(size_t detectorIndex) const {
+    return m_stride > 0
+               ? m_stride
+               : m_offsets[detectorIndex + 1] - m_offsets[detectorIndex];
+  }
+
+  /// True if linear indexes are detectorIndex * stride() + timeIndex, so
+  /// that the map can be inverted by division.
+  bool isStrided() const { return m_stride > 0 && m_indexes.empty(); }
+
+  /// Time indexes per detector if all detectors have the same number, else 0
+  size_t stride() const { return m_stride; }
+
+  /// Detector index of every linear index, for nLinearIndexes positions
+  /// @throws std::invalid_argument if a detector index does not fit IndexType
+  std::vector<IndexType> detectorIndexes(size_t nLinearIndexes) const {
+    if (m_nDetectors > 0) {
+      checkIndexFits(m_nDetectors - 1, "LinearIndexMap");
+    }
+    std::vector<IndexType> detectorIndexes(nLinearIndexes);
+    for (size_t detectorIndex = 0; detectorIndex < m_nDetectors;
+         ++detectorIndex) {
+      for (size_t t = 0; t < scanCount(detectorIndex); ++t) {
+        detectorIndexes[(*this)(detectorIndex, t)] = IndexType(detectorIndex);
+      }
+    }
+    return detectorIndexes;
+  }
+
+private:
+  size_t m_nDetectors;
+  /// Entries per detector when uniform, else 0
+  size_t m_stride = 0;
+  /// Flattened linear indexes. Empty in strided mode.
+  std::vector<IndexType> m_indexes;
+  /// Start of each detector's entries in m_indexes. Only when not uniform.
+  std::vector<IndexType> m_offsets;
+};
+
+#endif
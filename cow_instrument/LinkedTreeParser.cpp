@@ -2,11 +2,15 @@
 #include "CompositeComponent.h"
 #include "Detector.h"
 #include "LinkedTreeParser.h"
+#include "Parallel.h"
 #include "PathComponent.h"
 #include <string>
 #include <algorithm>
 #include <iterator>
 
+LinkedTreeParser::LinkedTreeParser(const Slice &slice)
+    : m_inSlice(true), m_slice(slice) {}
+
 void LinkedTreeParser::registerDetector(Detector const *const comp) {
 
   const size_t newIndex = coreUpdate(comp);
@@ -36,6 +40,15 @@ LinkedTreeParser::registerComposite(CompositeComponent const *const comp) {
 
 void LinkedTreeParser::registerDetector(const Detector *const comp,
                                         size_t parentIndex) {
+  if (m_inSlice) {
+    const size_t newIndex = sliceUpdate(comp, parentIndex);
+    if (auto shared = m_slice.shared) {
+      shared->m_detectorComponentIndexes[m_slice.detector] = newIndex;
+      shared->m_detectorIds[m_slice.detector] = comp->detectorId();
+    }
+    ++m_slice.detector;
+    return;
+  }
   const size_t newIndex = coreUpdate(comp, parentIndex);
   m_detectorComponentIndexes.push_back(newIndex);
   m_detectorIds.push_back(comp->detectorId());
@@ -43,12 +56,24 @@ void LinkedTreeParser::registerDetector(const Detector *const comp,
 
 void LinkedTreeParser::registerPathComponent(const PathComponent *const comp,
                                              size_t parentIndex) {
-  const size_t nextComponentIndex = coreUpdate(comp, parentIndex);
-  const size_t nextPathIndex = m_pathComponentIndexes.size();
-  m_entryPoints.push_back(comp->entryPoint());
-  m_exitPoints.push_back(comp->exitPoint());
-  m_pathLengths.push_back(comp->length());
-  m_pathComponentIndexes.push_back(nextComponentIndex);
+  size_t nextPathIndex;
+  if (m_inSlice) {
+    const size_t nextComponentIndex = sliceUpdate(comp, parentIndex);
+    nextPathIndex = m_slice.path++;
+    if (auto shared = m_slice.shared) {
+      shared->m_entryPoints[nextPathIndex] = comp->entryPoint();
+      shared->m_exitPoints[nextPathIndex] = comp->exitPoint();
+      shared->m_pathLengths[nextPathIndex] = comp->length();
+      shared->m_pathComponentIndexes[nextPathIndex] = nextComponentIndex;
+    }
+  } else {
+    const size_t nextComponentIndex = coreUpdate(comp, parentIndex);
+    nextPathIndex = m_pathComponentIndexes.size();
+    m_entryPoints.push_back(comp->entryPoint());
+    m_exitPoints.push_back(comp->exitPoint());
+    m_pathLengths.push_back(comp->length());
+    m_pathComponentIndexes.push_back(nextComponentIndex);
+  }
   if (m_sampleIndex < 0 && comp->isSample()) {
     m_sampleIndex = nextPathIndex;
   } else if (m_sourceIndex < 0 && comp->isSource()) {
@@ -58,14 +83,208 @@ void LinkedTreeParser::registerPathComponent(const PathComponent *const comp,
 
 size_t LinkedTreeParser::registerComposite(const CompositeComponent *const comp,
                                            size_t parentIndex) {
+  if (m_inSlice) {
+    const size_t nextComponentIndex = sliceUpdate(comp, parentIndex);
+    if (auto shared = m_slice.shared) {
+      shared->m_branchNodeComponentIndexes[m_slice.branchNode] =
+          nextComponentIndex;
+    }
+    ++m_slice.branchNode;
+    return nextComponentIndex;
+  }
   const size_t nextComponentIndex = coreUpdate(comp, parentIndex);
   m_branchNodeComponentIndexes.push_back(nextComponentIndex);
   return nextComponentIndex;
 }
 
-std::vector<ComponentProxy> LinkedTreeParser::proxies() { return m_proxies; }
+namespace {
+
+/// A component registered by registerCompositeInParallel: either one above
+/// the sub-trees it parses in parallel, or the root of one of them
+struct Piece {
+  Component const *component;
+  /// Piece index of the parent, -1 for the root
+  int64_t parent;
+  /// Registered alone, with each child a piece of its own
+  bool expanded;
+};
 
-size_t LinkedTreeParser::componentSize() const { return m_proxies.size(); }
+bool hasCompositeChildren(const CompositeComponent &composite) {
+  for (size_t i = 0; i < composite.size(); ++i) {
+    if (dynamic_cast<const CompositeComponent *>(&composite.getChild(i))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Choose the composites to register alone. Breadth first from the root, each
+ * level of composites that have composites below them is expanded, until
+ * there are at least target composite sub-trees left to parse, or only banks
+ * (composites of leaves) remain.
+ */
+std::vector<const CompositeComponent *>
+chooseExpanded(const CompositeComponent &root, size_t target) {
+  std::vector<const CompositeComponent *> expanded{&root};
+  std::vector<const CompositeComponent *> level{&root};
+  size_t nSubTrees = 0;
+  while (!level.empty()) {
+    std::vector<const CompositeComponent *> next;
+    for (auto composite : level) {
+      for (size_t i = 0; i < composite->size(); ++i) {
+        if (auto child = dynamic_cast<const CompositeComponent *>(
+                &composite->getChild(i))) {
+          next.push_back(child);
+        }
+      }
+    }
+    nSubTrees += next.size();
+    if (nSubTrees >= target) {
+      break;
+    }
+    level.clear();
+    for (auto composite : next) {
+      if (hasCompositeChildren(*composite)) {
+        level.push_back(composite);
+      }
+    }
+    nSubTrees -= level.size();
+    expanded.insert(expanded.end(), level.begin(), level.end());
+  }
+  return expanded;
+}
+
+/// Append the pieces below and including component, depth first
+void addPieces(const Component &component, int64_t parent,
+               const std::vector<const CompositeComponent *> &expanded,
+               std::vector<Piece> &pieces) {
+  const bool isExpanded = std::find(expanded.begin(), expanded.end(),
+                                    &component) != expanded.end();
+  const int64_t index = pieces.size();
+  pieces.push_back(Piece{&component, parent, isExpanded});
+  if (isExpanded) {
+    const auto &composite = static_cast<const CompositeComponent &>(component);
+    for (size_t i = 0; i < composite.size(); ++i) {
+      addPieces(composite.getChild(i), index, expanded, pieces);
+    }
+  }
+}
+}
+
+/**
+ * Equivalent to root->registerContents(*this), on an empty parser, but with
+ * the sub-trees below the root parsed on tasks of their own.
+ *
+ * The composites near the root are expanded down to bank level, until there
+ * are a few sub-trees per thread (see chooseExpanded), so that one large
+ * trolley does not hold up the rest. Each sub-tree is first walked only to
+ * count its components. The arrays here are then sized once, and each
+ * sub-tree registers straight into its own slice of them, so no sub-tree
+ * holds arrays of its own. The result is identical to the serial walk.
+ */
+void LinkedTreeParser::registerCompositeInParallel(
+    CompositeComponent const *const root) {
+  const size_t nThreads = parallelThreadCount();
+  if (!m_parents.empty() || nThreads < 2) {
+    root->registerContents(*this);
+    return;
+  }
+  std::vector<Piece> pieces;
+  addPieces(*root, -1, chooseExpanded(*root, 4 * nThreads), pieces);
+  if (pieces.size() < 3) {
+    root->registerContents(*this);
+    return;
+  }
+
+  // Sizes of each piece, then where each starts, in depth-first order
+  std::vector<Slice> slices(pieces.size());
+  parallelTasks(pieces.size(), [&](size_t i) {
+    if (pieces[i].expanded) {
+      slices[i] = Slice{nullptr, 1, 0, 0, 1};
+      return;
+    }
+    LinkedTreeParser counter(Slice{nullptr, 0, 0, 0, 0});
+    pieces[i].component->registerContents(counter, 0);
+    slices[i] = counter.m_slice;
+  });
+  Slice total{this, 0, 0, 0, 0};
+  for (auto &slice : slices) {
+    const Slice size = slice;
+    slice = total;
+    total.component += size.component;
+    total.detector += size.detector;
+    total.path += size.path;
+    total.branchNode += size.branchNode;
+  }
+
+  const ComponentIdType rootId = root->componentId();
+  m_parents.resize(total.component, -1);
+  m_positions.resize(total.component);
+  m_rotations.resize(total.component);
+  m_componentIds.resize(total.component, rootId);
+  m_detectorComponentIndexes.resize(total.detector);
+  m_detectorIds.resize(total.detector, DetectorIdType(0));
+  m_entryPoints.resize(total.path);
+  m_exitPoints.resize(total.path);
+  m_pathLengths.resize(total.path);
+  m_pathComponentIndexes.resize(total.path);
+  m_branchNodeComponentIndexes.resize(total.branchNode);
+
+  std::vector<int64_t> sourceIndexes(pieces.size(), -1);
+  std::vector<int64_t> sampleIndexes(pieces.size(), -1);
+  parallelTasks(pieces.size(), [&](size_t i) {
+    const Piece &piece = pieces[i];
+    const auto &at = slices[i];
+    const int64_t parent =
+        piece.parent < 0 ? -1 : int64_t(slices[piece.parent].component);
+    if (piece.expanded) {
+      // Placed below, once its children are
+      m_parents[at.component] = parent;
+      m_rotations[at.component] = piece.component->getRotation();
+      m_componentIds[at.component] = piece.component->componentId();
+      m_branchNodeComponentIndexes[at.branchNode] = at.component;
+      return;
+    }
+    LinkedTreeParser slice(at);
+    piece.component->registerContents(slice, parent);
+    sourceIndexes[i] = slice.m_sourceIndex;
+    sampleIndexes[i] = slice.m_sampleIndex;
+  });
+
+  // Expanded composites sit at the mean of their children's positions, as
+  // CompositeComponent::getPos, summed in the same order. Deepest first, so
+  // that expanded children are placed before their parents.
+  std::vector<std::vector<size_t>> children(pieces.size());
+  for (size_t i = 1; i < pieces.size(); ++i) {
+    children[pieces[i].parent].push_back(i);
+  }
+  for (size_t i = pieces.size(); i-- > 0;) {
+    if (!pieces[i].expanded) {
+      continue;
+    }
+    Eigen::Vector3d position{0, 0, 0};
+    for (auto child : children[i]) {
+      position += m_positions[slices[child].component];
+    }
+    position /= children[i].size();
+    m_positions[slices[i].component] = position;
+  }
+
+  // The first source and sample in depth-first order
+  for (size_t i = 0; i < pieces.size(); ++i) {
+    if (m_sourceIndex < 0) {
+      m_sourceIndex = sourceIndexes[i];
+    }
+    if (m_sampleIndex < 0) {
+      m_sampleIndex = sampleIndexes[i];
+    }
+  }
+}
+
+std::vector<int64_t> LinkedTreeParser::parents() const { return m_parents; }
+
+size_t LinkedTreeParser::componentSize() const { return m_parents.size(); }
 
 size_t LinkedTreeParser::detectorSize() const {
   return m_detectorComponentIndexes.size();
@@ -75,15 +294,15 @@ size_t LinkedTreeParser::pathSize() const {
   return m_pathComponentIndexes.size();
 }
 
-std::vector<size_t> LinkedTreeParser::pathComponentIndexes() const {
+std::vector<IndexType> LinkedTreeParser::pathComponentIndexes() const {
   return m_pathComponentIndexes;
 }
 
-std::vector<size_t> LinkedTreeParser::detectorComponentIndexes() const {
+std::vector<IndexType> LinkedTreeParser::detectorComponentIndexes() const {
   return m_detectorComponentIndexes;
 }
 
-std::vector<size_t> LinkedTreeParser::branchNodeComponentIndexes() const {
+std::vector<IndexType> LinkedTreeParser::branchNodeComponentIndexes() const {
   return m_branchNodeComponentIndexes;
 }
 
@@ -101,19 +320,31 @@ std::vector<double> LinkedTreeParser::pathLengths() const {
 
 size_t LinkedTreeParser::coreUpdate(Component const *const comp,
                                     size_t previousIndex) {
-  size_t newIndex = m_proxies.size();
+  size_t newIndex = m_parents.size();
   m_componentIds.emplace_back(comp->componentId());
-  m_proxies.emplace_back(previousIndex, comp->componentId());
-  m_proxies[previousIndex].addChild(newIndex);
+  m_parents.emplace_back(previousIndex);
   m_positions.emplace_back(comp->getPos());
   m_rotations.emplace_back(comp->getRotation());
   return newIndex; // Return the last index.
 }
 
+/// Take the next component index of the slice, and fill it in if shared
+size_t LinkedTreeParser::sliceUpdate(Component const *const comp,
+                                     size_t previousIndex) {
+  const size_t newIndex = m_slice.component++;
+  if (auto shared = m_slice.shared) {
+    shared->m_componentIds[newIndex] = comp->componentId();
+    shared->m_parents[newIndex] = previousIndex;
+    shared->m_positions[newIndex] = comp->getPos();
+    shared->m_rotations[newIndex] = comp->getRotation();
+  }
+  return newIndex;
+}
+
 size_t LinkedTreeParser::coreUpdate(Component const *const comp) {
-  const size_t newIndex = m_proxies.size();
+  const size_t newIndex = m_parents.size();
   m_componentIds.emplace_back(comp->componentId());
-  m_proxies.emplace_back(comp->componentId());
+  m_parents.emplace_back(-1);
   m_positions.emplace_back(comp->getPos());
   m_rotations.emplace_back(comp->getRotation());
   return newIndex; // Return the last index.
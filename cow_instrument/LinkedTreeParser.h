@@ -3,19 +3,22 @@
 
 #include <vector>
 #include <cstddef>
+#include <cstdint>
 #include "IdType.h"
-#include "ComponentProxy.h"
+#include "IndexType.h"
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 #include <map>
 
+class Component;
 class Detector;
 class PathComponent;
 class CompositeComponent;
 
 /**
  * Converts a component tree doubly linked-list representation of an instrument
- * into a series of arrays and a flattened component-proxy representation.
+ * into a series of arrays. The tree itself is held as the parent of each
+ * component.
  */
 class LinkedTreeParser {
 public:
@@ -28,14 +31,15 @@ public:
                              size_t parentIndex);
   size_t registerComposite(CompositeComponent const *const comp,
                            size_t parentIndex);
+  void registerCompositeInParallel(CompositeComponent const *const root);
 
-  std::vector<ComponentProxy> proxies();
+  std::vector<int64_t> parents() const;
   size_t componentSize() const;
   size_t detectorSize() const;
   size_t pathSize() const;
-  std::vector<size_t> pathComponentIndexes() const;
-  std::vector<size_t> detectorComponentIndexes() const;
-  std::vector<size_t> branchNodeComponentIndexes() const;
+  std::vector<IndexType> pathComponentIndexes() const;
+  std::vector<IndexType> detectorComponentIndexes() const;
+  std::vector<IndexType> branchNodeComponentIndexes() const;
   std::vector<Eigen::Vector3d> startEntryPoints() const;
   std::vector<Eigen::Vector3d> startExitPoints() const;
   std::vector<double> pathLengths() const;
@@ -47,8 +51,24 @@ public:
   int64_t samplePathIndex() const;
 
 private:
+  /// Next index of each kind for a parser registering one sub-tree in
+  /// registerCompositeInParallel. Writes go to the shared parser, which has
+  /// already been sized. With no shared parser, only the counts are kept.
+  struct Slice {
+    LinkedTreeParser *shared;
+    size_t component;
+    size_t detector;
+    size_t path;
+    size_t branchNode;
+  };
+  explicit LinkedTreeParser(const Slice &slice);
   size_t coreUpdate(Component const *const comp);
   size_t coreUpdate(Component const *const comp, size_t previousIndex);
+  size_t sliceUpdate(Component const *const comp, size_t previousIndex);
+
+  /// True when registering into m_slice rather than the arrays here
+  bool m_inSlice = false;
+  Slice m_slice = Slice{nullptr, 0, 0, 0, 0};
 
   /// PathComponent vector index of the source
   int64_t m_sourceIndex = -1;
@@ -60,7 +80,8 @@ private:
    component
    type independent
    */
-  std::vector<ComponentProxy> m_proxies;
+  /// Parent component index, -1 for the root
+  std::vector<int64_t> m_parents;
   std::vector<Eigen::Vector3d> m_positions;
   std::vector<Eigen::Quaterniond> m_rotations;
   std::vector<ComponentIdType> m_componentIds;
@@ -73,9 +94,9 @@ private:
   std::vector<Eigen::Vector3d> m_entryPoints; // For path components
   std::vector<Eigen::Vector3d> m_exitPoints;  // For path components
   std::vector<double> m_pathLengths;          // For path components
-  std::vector<size_t> m_pathComponentIndexes;
-  std::vector<size_t> m_detectorComponentIndexes;
-  std::vector<size_t> m_branchNodeComponentIndexes;
+  std::vector<IndexType> m_pathComponentIndexes;
+  std::vector<IndexType> m_detectorComponentIndexes;
+  std::vector<IndexType> m_branchNodeComponentIndexes;
   std::vector<DetectorIdType> m_detectorIds;
 };
 
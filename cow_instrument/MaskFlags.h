@@ -1,15 +1,14 @@
 #ifndef MASKFLAGS_H
 #define MASKFLAGS_H
 
-#include "Bool.h"
-#include "FixedLengthVector.h"
+#include "BitFlags.h"
 
 /**
- * MaskFlags fixed length vector
+ * MaskFlags, one bit per detector
  */
-class MaskFlags : public FixedLengthVector<MaskFlags, Bool> {
+class MaskFlags : public BitFlags<MaskFlags> {
 public:
-  using FixedLengthVector<MaskFlags, Bool>::FixedLengthVector;
+  using BitFlags<MaskFlags>::BitFlags;
 };
 
 #endif
@@ -1,14 +1,14 @@
 #ifndef MONITORFLAGS_H
 #define MONITORFLAGS_H
 
-#include "Bool.h"
-#include "FixedLengthVector.h"
+#include "BitFlags.h"
 
 /**
- * Monitor flags fixed length vector
+ * Monitor flags, one bit per detector
  */
-class MonitorFlags : public FixedLengthVector<MonitorFlags, Bool> {
-  using FixedLengthVector<MonitorFlags, Bool>::FixedLengthVector;
+class MonitorFlags : public BitFlags<MonitorFlags> {
+public:
+  using BitFlags<MonitorFlags>::BitFlags;
 };
 
 #endif
@@ -0,0 +1,19 @@
+#include "Parallel.h"
+#include <atomic>
+
+namespace {
+std::atomic<size_t> requestedThreadCount(0);
+}
+
+void setParallelThreadCount(size_t threadCount) {
+  requestedThreadCount = threadCount;
+}
+
+size_t parallelThreadCount() {
+  const size_t requested = requestedThreadCount;
+  if (requested > 0) {
+    return requested;
+  }
+  const size_t cores = std::thread::hardware_concurrency();
+  return cores > 0 ? cores : 1;
+}
@@ -0,0 +1,129 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+/**
+ * Fork-join helper for the embarrassingly parallel loops over detectors and
+ * linear indexes. parallelFor splits [0, size) into contiguous chunks, calls
+ * function(begin, end) once per chunk from its own thread, and returns when
+ * all chunks are done. Each index is processed by the same code as in a
+ * serial loop, so results do not depend on the thread count.
+ */
+
+/// Set the number of threads used by parallelFor. 0 selects one per core.
+void setParallelThreadCount(size_t threadCount);
+
+/// Number of threads used by parallelFor
+size_t parallelThreadCount();
+
+/// Smallest chunk worth a thread. A multiple of every DistanceKernels vector
+/// width, so chunking never moves elements onto the scalar tail.
+const size_t parallelGrainSize = 1024;
+
+template <typename Function>
+void parallelFor(size_t size, Function &&function) {
+
+  const size_t nChunks = (size + parallelGrainSize - 1) / parallelGrainSize;
+  const size_t nThreads = std::min(parallelThreadCount(), nChunks);
+  if (nThreads <= 1) {
+    if (size > 0) {
+      function(size_t(0), size);
+    }
+    return;
+  }
+
+  const size_t chunkSize =
+      ((size + nThreads - 1) / nThreads + parallelGrainSize - 1) /
+      parallelGrainSize * parallelGrainSize;
+  std::vector<std::exception_ptr> errors(nThreads);
+  auto runChunk = [&](size_t chunk) {
+    const size_t begin = std::min(size, chunk * chunkSize);
+    const size_t end = std::min(size, begin + chunkSize);
+    try {
+      if (begin < end) {
+        function(begin, end);
+      }
+    } catch (...) {
+      errors[chunk] = std::current_exception();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(nThreads - 1);
+  for (size_t chunk = 1; chunk < nThreads; ++chunk) {
+    try {
+      threads.emplace_back(runChunk, chunk);
+    } catch (const std::system_error &) {
+      // Out of threads. Do the work here instead.
+      runChunk(chunk);
+    }
+  }
+  runChunk(0);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (auto &error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+/**
+ * Run function(task) once for each task in [0, nTasks), spread over up to
+ * parallelThreadCount() threads. For a few large, uneven pieces of work, such
+ * as one per bank, where parallelFor's fixed chunking does not fit. Threads
+ * take the next unstarted task as they finish.
+ */
+template <typename Function>
+void parallelTasks(size_t nTasks, Function &&function) {
+
+  const size_t nThreads = std::min(parallelThreadCount(), nTasks);
+  if (nThreads <= 1) {
+    for (size_t task = 0; task < nTasks; ++task) {
+      function(task);
+    }
+    return;
+  }
+
+  std::atomic<size_t> nextTask(0);
+  std::vector<std::exception_ptr> errors(nTasks);
+  auto runTasks = [&]() {
+    for (size_t task = nextTask++; task < nTasks; task = nextTask++) {
+      try {
+        function(task);
+      } catch (...) {
+        errors[task] = std::current_exception();
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(nThreads - 1);
+  for (size_t thread = 1; thread < nThreads; ++thread) {
+    try {
+      threads.emplace_back(runTasks);
+    } catch (const std::system_error &) {
+      // Out of threads. The remaining ones share the work.
+      break;
+    }
+  }
+  runTasks();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (auto &error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+#endif
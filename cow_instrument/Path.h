@@ -1,8 +1,12 @@
 #ifndef PATH_H
 #define PATH_H
 
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
 #include "VectorOf.h"
-#include "FixedLengthVector.h"
 
 /**
  * Path is the per-detector Flight path through PathComponents.
@@ -14,9 +18,72 @@ public:
   using VectorOf<Path>::VectorOf;
 };
 
-class Paths : public FixedLengthVector<Paths, Path> {
+/// Identifies one of the unique paths held by Paths
+using PathId = uint32_t;
+
+/**
+ * Paths for all detectors. Most detectors share their path with many others,
+ * so each distinct Path is stored once, and each detector holds only the
+ * PathId of its path. Indexing with a detector index still yields that
+ * detector's Path.
+ */
+class Paths {
 public:
-  using FixedLengthVector<Paths, Path>::FixedLengthVector;
+  Paths() = default;
+
+  /// All count detectors follow the same path
+  Paths(size_t count, const Path &path)
+      : m_uniquePaths(1, path), m_pathIds(count, PathId(0)) {}
+
+  /// One path per detector. Identical paths are stored once.
+  Paths(const std::vector<Path> &paths) : m_pathIds(paths.size()) {
+    std::map<std::vector<IndexType>, PathId> known;
+    for (size_t detectorIndex = 0; detectorIndex < paths.size();
+         ++detectorIndex) {
+      const Path &path = paths[detectorIndex];
+      auto found = known.find(path.indexes());
+      if (found == known.end()) {
+        found = known.emplace(path.indexes(), PathId(m_uniquePaths.size()))
+                    .first;
+        m_uniquePaths.push_back(path);
+      }
+      m_pathIds[detectorIndex] = found->second;
+    }
+  }
+
+  /// Unique paths, and the PathId of each detector's path
+  Paths(std::vector<Path> uniquePaths, std::vector<PathId> pathIds)
+      : m_uniquePaths(std::move(uniquePaths)), m_pathIds(std::move(pathIds)) {
+    for (auto pathId : m_pathIds) {
+      if (pathId >= m_uniquePaths.size()) {
+        throw std::out_of_range("Paths: PathId does not refer to a path");
+      }
+    }
+  }
+
+  /// Number of detectors
+  size_t size() const { return m_pathIds.size(); }
+
+  /// Path of the detector at detectorIndex
+  const Path &operator[](size_t detectorIndex) const {
+    return m_uniquePaths[m_pathIds[detectorIndex]];
+  }
+
+  /// PathId of the detector at detectorIndex
+  PathId pathId(size_t detectorIndex) const { return m_pathIds[detectorIndex]; }
+
+  /// Number of distinct paths
+  size_t uniqueSize() const { return m_uniquePaths.size(); }
+
+  const Path &uniquePath(PathId pathId) const { return m_uniquePaths[pathId]; }
+
+  const std::vector<Path> &uniquePaths() const { return m_uniquePaths; }
+
+  const std::vector<PathId> &pathIds() const { return m_pathIds; }
+
+private:
+  std::vector<Path> m_uniquePaths;
+  std::vector<PathId> m_pathIds;
 };
 
 #endif
@@ -5,6 +5,8 @@
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 #include "cow_ptr.h"
+#include "IndexType.h"
+#include "Span.h"
 
 /**
  * PathComponentInfo type. Provides meta-data an behaviour for working with a
@@ -32,6 +34,10 @@ public:
 
   const std::vector<double> &const_pathLengths() const;
 
+  Span<Eigen::Vector3d> positions() const;
+
+  Span<Eigen::Quaterniond> rotations() const;
+
   const InstTree &const_instrumentTree() const;
 
   void movePathComponent(size_t pathComponentIndex,
@@ -48,6 +54,14 @@ public:
                             const Eigen::Vector3d &axis, const double &theta,
                             const Eigen::Vector3d &center);
 
+  void movePathComponentRange(size_t begin, size_t end,
+                              const Eigen::Vector3d &offset);
+
+  void rotatePathComponentRange(size_t begin, size_t end,
+                                const Eigen::Vector3d &axis,
+                                const double &theta,
+                                const Eigen::Vector3d &center);
+
   bool operator==(const PathComponentInfo<InstTree> &other) const;
 
   bool operator!=(const PathComponentInfo<InstTree> &other) const;
@@ -55,7 +69,7 @@ public:
 private:
   /// initalization
   void init();
-  const size_t m_nPathComponents;
+  size_t m_nPathComponents;
   /// All path component entry points.
   CowPtr<std::vector<Eigen::Vector3d>> m_entryPoints;
   /// All path component exit points
@@ -67,7 +81,7 @@ private:
   /// Locally (path component) indexed rotations
   CowPtr<std::vector<Eigen::Quaterniond>> m_rotations;
   /// Path component indexes
-  std::shared_ptr<const std::vector<size_t>> m_pathComponentIndexes;
+  std::shared_ptr<const std::vector<IndexType>> m_pathComponentIndexes;
   /// Shared instrument. This is the "owner"
   std::shared_ptr<InstTree> m_instrumentTree;
 };
@@ -100,8 +114,9 @@ PathComponentInfo<InstTree>::PathComponentInfo(
           std::make_shared<std::vector<double>>(instrumentTree->pathLengths())),
       m_rotations(
           std::make_shared<std::vector<Eigen::Quaterniond>>(m_nPathComponents)),
-      m_pathComponentIndexes(std::make_shared<const std::vector<size_t>>(
-          instrumentTree->pathComponentIndexes())),
+      m_pathComponentIndexes(
+          std::make_shared<const std::vector<IndexType>>(
+              instrumentTree->pathComponentIndexes())),
       m_instrumentTree(instrumentTree) {
 
   init();
@@ -122,19 +137,17 @@ PathComponentInfo<InstTree>::PathComponentInfo(
           std::make_shared<std::vector<double>>(instrumentTree->pathLengths())),
       m_rotations(
           std::make_shared<std::vector<Eigen::Quaterniond>>(m_nPathComponents)),
-      m_pathComponentIndexes(std::make_shared<const std::vector<size_t>>(
-          instrumentTree->pathComponentIndexes())),
+      m_pathComponentIndexes(
+          std::make_shared<const std::vector<IndexType>>(
+              instrumentTree->pathComponentIndexes())),
       m_instrumentTree(std::move(instrumentTree)) {
 
   init();
 }
 
 template <typename InstTree> void PathComponentInfo<InstTree>::init() {
-  // TODO. Do this without copying everything!
-  std::vector<Eigen::Vector3d> allComponentPositions =
-      m_instrumentTree->startPositions();
-  std::vector<Eigen::Quaterniond> allComponentRotations =
-      m_instrumentTree->startRotations();
+  const auto &allComponentPositions = m_instrumentTree->startPositions();
+  const auto &allComponentRotations = m_instrumentTree->startRotations();
 
   size_t i = 0;
   for (auto &compIndex : (*m_pathComponentIndexes)) {
@@ -190,6 +203,18 @@ PathComponentInfo<InstTree>::const_pathLengths() const {
   return (*m_pathLengths);
 }
 
+/// All positions, path component indexed
+template <typename InstTree>
+Span<Eigen::Vector3d> PathComponentInfo<InstTree>::positions() const {
+  return m_positions.const_ref();
+}
+
+/// All rotations, path component indexed
+template <typename InstTree>
+Span<Eigen::Quaterniond> PathComponentInfo<InstTree>::rotations() const {
+  return m_rotations.const_ref();
+}
+
 template <typename InstTree>
 const InstTree &PathComponentInfo<InstTree>::const_instrumentTree() const {
   return *m_instrumentTree;
@@ -265,6 +290,46 @@ void PathComponentInfo<InstTree>::rotatePathComponents(
   // Would need to update detectorInfo?
 }
 
+/// Move path components [begin, end)
+template <typename InstTree>
+void PathComponentInfo<InstTree>::movePathComponentRange(
+    size_t begin, size_t end, const Eigen::Vector3d &offset) {
+
+  auto &positions = *m_positions;
+  auto &entryPoints = *m_entryPoints;
+  auto &exitPoints = *m_exitPoints;
+  for (size_t pathComponentIndex = begin; pathComponentIndex < end;
+       ++pathComponentIndex) {
+    positions[pathComponentIndex] += offset;
+    entryPoints[pathComponentIndex] += offset;
+    exitPoints[pathComponentIndex] += offset;
+  }
+}
+
+/// Rotate path components [begin, end)
+template <typename InstTree>
+void PathComponentInfo<InstTree>::rotatePathComponentRange(
+    size_t begin, size_t end, const Eigen::Vector3d &axis, const double &theta,
+    const Eigen::Vector3d &center) {
+
+  using namespace Eigen;
+  const auto transform =
+      Translation3d(center) * AngleAxisd(theta, axis) * Translation3d(-center);
+  const Quaterniond rotation(transform.rotation());
+  auto &positions = *m_positions;
+  auto &entryPoints = *m_entryPoints;
+  auto &exitPoints = *m_exitPoints;
+  auto &rotations = *m_rotations;
+  for (size_t pathComponentIndex = begin; pathComponentIndex < end;
+       ++pathComponentIndex) {
+    positions[pathComponentIndex] = transform * positions[pathComponentIndex];
+    entryPoints[pathComponentIndex] =
+        transform * entryPoints[pathComponentIndex];
+    exitPoints[pathComponentIndex] = transform * exitPoints[pathComponentIndex];
+    rotations[pathComponentIndex] = rotation * rotations[pathComponentIndex];
+  }
+}
+
 template <typename InstTree>
 bool PathComponentInfo<InstTree>::
 operator==(const PathComponentInfo<InstTree> &other) const {
@@ -0,0 +1,264 @@
+#ifndef POSITIONS_H
+#define POSITIONS_H
+
+#include <cmath>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include "DistanceKernels.h"
+
+/**
+ * Position storage types. Both provide the same interface, so that
+ * DetectorInfo can be instantiated with either layout.
+ *
+ * AoSPositions stores x, y, z interleaved per position (array of structures).
+ * SoAPositions stores all x, then all y, then all z (structure of arrays), so
+ * that each coordinate can be processed with unit-stride loads.
+ *
+ * Unlike L2s and rotations, positions are not paged (see ChunkedVector). Both
+ * layouts hand out Eigen maps over all positions (DetectorInfo::positions,
+ * scanPositions), and the distance kernels stream a single buffer.
+ */
+
+/**
+ * Array-of-structures position storage. The default layout.
+ */
+class AoSPositions {
+public:
+  /// Eigen view of all positions, one position per column
+  using ConstMap = Eigen::Map<const Eigen::Matrix3Xd>;
+  using Map = Eigen::Map<Eigen::Matrix3Xd>;
+  /// Eigen view of every step-th position
+  using ConstStridedMap =
+      Eigen::Map<const Eigen::Matrix3Xd, 0, Eigen::OuterStride<>>;
+
+  explicit AoSPositions(size_t size = 0)
+      : m_positions(size, Eigen::Vector3d::Zero()) {}
+  explicit AoSPositions(std::vector<Eigen::Vector3d> positions)
+      : m_positions(std::move(positions)) {}
+
+  size_t size() const { return m_positions.size(); }
+
+  const Eigen::Vector3d &operator[](size_t index) const {
+    return m_positions[index];
+  }
+
+  void set(size_t index, const Eigen::Vector3d &position) {
+    m_positions[index] = position;
+  }
+
+  void translate(size_t index, const Eigen::Vector3d &offset) {
+    m_positions[index] += offset;
+  }
+
+  void translate(const std::vector<size_t> &indexes,
+                 const Eigen::Vector3d &offset) {
+    for (auto index : indexes) {
+      m_positions[index] += offset;
+    }
+  }
+
+  /// Translate positions [begin, end)
+  void translateRange(size_t begin, size_t end, const Eigen::Vector3d &offset) {
+    for (size_t index = begin; index < end; ++index) {
+      m_positions[index] += offset;
+    }
+  }
+
+  template <typename Transform>
+  void transform(size_t index, const Transform &transform) {
+    m_positions[index] = transform * m_positions[index];
+  }
+
+  template <typename Transform>
+  void transform(const std::vector<size_t> &indexes,
+                 const Transform &transform) {
+    for (auto index : indexes) {
+      m_positions[index] = transform * m_positions[index];
+    }
+  }
+
+  /// Transform positions [begin, end)
+  template <typename Transform>
+  void transformRange(size_t begin, size_t end, const Transform &transform) {
+    for (size_t index = begin; index < end; ++index) {
+      m_positions[index] = transform * m_positions[index];
+    }
+  }
+
+  double distance(size_t index, const Eigen::Vector3d &point) const {
+    return (m_positions[index] - point).norm();
+  }
+
+  /// out[i - begin] = offset + distance(i, point) for positions in
+  /// [begin, end)
+  void offsetDistances(const Eigen::Vector3d &point, double offset,
+                       size_t begin, size_t end, double *out) const {
+    offsetDistancesAoS(m_positions[begin].data(), end - begin, point.data(),
+                       offset, out);
+  }
+
+  ConstMap map() const {
+    return ConstMap(m_positions.data()->data(), 3, m_positions.size());
+  }
+  Map map() { return Map(m_positions.data()->data(), 3, m_positions.size()); }
+
+  /// count positions starting at first, step positions apart
+  ConstStridedMap stridedMap(size_t first, size_t count, size_t step) const {
+    return ConstStridedMap(m_positions.data()->data() + 3 * first, 3, count,
+                           Eigen::OuterStride<>(3 * step));
+  }
+
+private:
+  std::vector<Eigen::Vector3d> m_positions;
+};
+
+/**
+ * Structure-of-arrays position storage. Coordinates are held in a single
+ * buffer as [x0..xn-1, y0..yn-1, z0..zn-1].
+ */
+class SoAPositions {
+public:
+  /// Eigen view of all positions, one position per row, one axis per column
+  using ConstMap = Eigen::Map<const Eigen::MatrixX3d>;
+  using Map = Eigen::Map<Eigen::MatrixX3d>;
+  /// Eigen view of every step-th position
+  using ConstStridedMap =
+      Eigen::Map<const Eigen::MatrixX3d, 0,
+                 Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>>;
+
+  explicit SoAPositions(size_t size = 0) : m_size(size), m_xyz(3 * size) {}
+  explicit SoAPositions(const std::vector<Eigen::Vector3d> &positions)
+      : SoAPositions(positions.size()) {
+    for (size_t i = 0; i < m_size; ++i) {
+      set(i, positions[i]);
+    }
+  }
+
+  size_t size() const { return m_size; }
+
+  Eigen::Vector3d operator[](size_t index) const {
+    return Eigen::Vector3d{x()[index], y()[index], z()[index]};
+  }
+
+  void set(size_t index, const Eigen::Vector3d &position) {
+    x()[index] = position[0];
+    y()[index] = position[1];
+    z()[index] = position[2];
+  }
+
+  void translate(size_t index, const Eigen::Vector3d &offset) {
+    x()[index] += offset[0];
+    y()[index] += offset[1];
+    z()[index] += offset[2];
+  }
+
+  void translate(const std::vector<size_t> &indexes,
+                 const Eigen::Vector3d &offset) {
+    const double dx = offset[0];
+    const double dy = offset[1];
+    const double dz = offset[2];
+    double *xs = x();
+    double *ys = y();
+    double *zs = z();
+    for (auto index : indexes) {
+      xs[index] += dx;
+      ys[index] += dy;
+      zs[index] += dz;
+    }
+  }
+
+  /// Translate positions [begin, end). Unit stride, so vectorizes.
+  void translateRange(size_t begin, size_t end, const Eigen::Vector3d &offset) {
+    const double dx = offset[0];
+    const double dy = offset[1];
+    const double dz = offset[2];
+    double *xs = x();
+    double *ys = y();
+    double *zs = z();
+    for (size_t index = begin; index < end; ++index) {
+      xs[index] += dx;
+      ys[index] += dy;
+      zs[index] += dz;
+    }
+  }
+
+  template <typename Transform>
+  void transform(size_t index, const Transform &transform) {
+    set(index, transform * (*this)[index]);
+  }
+
+  template <typename Transform>
+  void transform(const std::vector<size_t> &indexes,
+                 const Transform &transform) {
+    const Eigen::Matrix3d r = transform.linear();
+    const Eigen::Vector3d t = transform.translation();
+    double *xs = x();
+    double *ys = y();
+    double *zs = z();
+    for (auto index : indexes) {
+      const double px = xs[index];
+      const double py = ys[index];
+      const double pz = zs[index];
+      xs[index] = r(0, 0) * px + r(0, 1) * py + r(0, 2) * pz + t[0];
+      ys[index] = r(1, 0) * px + r(1, 1) * py + r(1, 2) * pz + t[1];
+      zs[index] = r(2, 0) * px + r(2, 1) * py + r(2, 2) * pz + t[2];
+    }
+  }
+
+  /// Transform positions [begin, end). Unit stride, so vectorizes.
+  template <typename Transform>
+  void transformRange(size_t begin, size_t end, const Transform &transform) {
+    const Eigen::Matrix3d r = transform.linear();
+    const Eigen::Vector3d t = transform.translation();
+    double *xs = x();
+    double *ys = y();
+    double *zs = z();
+    for (size_t index = begin; index < end; ++index) {
+      const double px = xs[index];
+      const double py = ys[index];
+      const double pz = zs[index];
+      xs[index] = r(0, 0) * px + r(0, 1) * py + r(0, 2) * pz + t[0];
+      ys[index] = r(1, 0) * px + r(1, 1) * py + r(1, 2) * pz + t[1];
+      zs[index] = r(2, 0) * px + r(2, 1) * py + r(2, 2) * pz + t[2];
+    }
+  }
+
+  double distance(size_t index, const Eigen::Vector3d &point) const {
+    const double dx = x()[index] - point[0];
+    const double dy = y()[index] - point[1];
+    const double dz = z()[index] - point[2];
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+  }
+
+  /// out[i - begin] = offset + distance(i, point) for positions in
+  /// [begin, end)
+  void offsetDistances(const Eigen::Vector3d &point, double offset,
+                       size_t begin, size_t end, double *out) const {
+    offsetDistancesSoA(x() + begin, y() + begin, z() + begin, end - begin,
+                       point.data(), offset, out);
+  }
+
+  ConstMap map() const { return ConstMap(m_xyz.data(), m_size, 3); }
+  Map map() { return Map(m_xyz.data(), m_size, 3); }
+
+  /// count positions starting at first, step positions apart
+  ConstStridedMap stridedMap(size_t first, size_t count, size_t step) const {
+    return ConstStridedMap(
+        m_xyz.data() + first, count, 3,
+        Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(m_size, step));
+  }
+
+  const double *x() const { return m_xyz.data(); }
+  const double *y() const { return m_xyz.data() + m_size; }
+  const double *z() const { return m_xyz.data() + 2 * m_size; }
+  double *x() { return m_xyz.data(); }
+  double *y() { return m_xyz.data() + m_size; }
+  double *z() { return m_xyz.data() + 2 * m_size; }
+
+private:
+  size_t m_size;
+  std::vector<double> m_xyz;
+};
+
+#endif
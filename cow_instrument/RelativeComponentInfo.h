@@ -0,0 +1,361 @@
+#ifndef RELATIVE_COMPONENT_INFO_H
+#define RELATIVE_COMPONENT_INFO_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include "cow_ptr.h"
+#include "Span.h"
+#include "SubTree.h"
+
+/**
+ * RelativeComponentInfo. Prototype of a component view that stores the
+ * position and rotation of each component relative to its parent, rather than
+ * absolutely. A move or rotate changes only the relative transform of the
+ * component written.
+ *
+ * Absolute positions and rotations are composed on demand and cached. A write
+ * marks the sub-tree it affects as stale, and the next read recomposes only
+ * the stale sub-trees. As FlatTree is stored in depth-first order, each of
+ * those is a single forward sweep over a contiguous range of components.
+ * Recomposition is serialised by a lock, so const reads may be shared between
+ * threads as with the other Info types. Once the cache is up to date a read
+ * costs a single atomic load on top of the lookup.
+ *
+ * Component indexing is as for ComponentInfo. The prototype is standalone
+ * and not used by ComponentInfo or DetectorInfo, which keep absolute
+ * positions for L1/L2 regardless. Whether it pays off in practice is yet to
+ * be measured against them.
+ */
+template <typename InstTree> class RelativeComponentInfo {
+public:
+  explicit RelativeComponentInfo(
+      std::shared_ptr<const InstTree> instrumentTree);
+  RelativeComponentInfo(const RelativeComponentInfo<InstTree> &other);
+  RelativeComponentInfo<InstTree> &
+  operator=(const RelativeComponentInfo<InstTree> &other);
+
+  Eigen::Vector3d position(size_t componentIndex) const;
+  Eigen::Quaterniond rotation(size_t componentIndex) const;
+
+  Span<Eigen::Vector3d> positions() const;
+  Span<Eigen::Quaterniond> rotations() const;
+
+  Eigen::Vector3d relativePosition(size_t componentIndex) const;
+  Eigen::Quaterniond relativeRotation(size_t componentIndex) const;
+
+  size_t componentSize() const;
+
+  const InstTree &const_instrumentTree() const;
+
+  void move(size_t componentIndex, const Eigen::Vector3d &offset);
+
+  void rotate(size_t componentIndex, const Eigen::Vector3d &axis,
+              const double &theta, const Eigen::Vector3d &center);
+
+private:
+  /// Absolute transforms composed from the relative ones
+  struct AbsoluteCache {
+    /// Component indexed. Valid outside stale sub-trees.
+    CowPtr<std::vector<Eigen::Vector3d>> positions;
+    /// Component indexed. Valid outside stale sub-trees.
+    CowPtr<std::vector<Eigen::Quaterniond>> rotations;
+    /// Roots of sub-trees whose absolute transforms need recomposing
+    std::vector<size_t> staleRoots;
+  };
+
+  /// Absolute transform of a component, composed from its ancestors.
+  void compose(size_t componentIndex, Eigen::Vector3d &position,
+               Eigen::Quaterniond &rotation) const;
+  void setAbsolute(size_t componentIndex, const Eigen::Vector3d &position,
+                   const Eigen::Quaterniond &rotation);
+  void markStale(size_t componentIndex);
+  void refresh() const;
+  void recompose(size_t begin, size_t end) const;
+  AbsoluteCache lockedAbsolute() const;
+
+  std::shared_ptr<const InstTree> m_instrumentTree;
+  /// Parent component index, -1 for the root. Shared between copies.
+  std::shared_ptr<const std::vector<int64_t>> m_parents;
+  /// Component indexed, relative to the parent component
+  CowPtr<std::vector<Eigen::Vector3d>> m_relativePositions;
+  /// Component indexed, relative to the parent component
+  CowPtr<std::vector<Eigen::Quaterniond>> m_relativeRotations;
+  /// Recomposed by const readers under m_absoluteMutex
+  mutable AbsoluteCache m_absolute;
+  mutable std::mutex m_absoluteMutex;
+  /// Whether m_absolute has stale sub-trees. Read without the lock.
+  mutable std::atomic<bool> m_isStale{false};
+};
+
+template <typename InstTree>
+RelativeComponentInfo<InstTree>::RelativeComponentInfo(
+    std::shared_ptr<const InstTree> instrumentTree)
+    : m_instrumentTree(std::move(instrumentTree)),
+      m_relativePositions(std::make_shared<std::vector<Eigen::Vector3d>>(
+          m_instrumentTree->startPositions())),
+      m_relativeRotations(std::make_shared<std::vector<Eigen::Quaterniond>>(
+          m_instrumentTree->startRotations())),
+      m_absolute{std::make_shared<std::vector<Eigen::Vector3d>>(
+                     m_instrumentTree->startPositions()),
+                 std::make_shared<std::vector<Eigen::Quaterniond>>(
+                     m_instrumentTree->startRotations()),
+                 {}} {
+
+  const size_t componentSize = m_instrumentTree->componentSize();
+  std::vector<int64_t> parents(componentSize, -1);
+  for (size_t i = 0; i < componentSize; ++i) {
+    const auto &proxy = m_instrumentTree->proxyAt(i);
+    if (proxy.hasParent()) {
+      parents[i] = proxy.parent();
+    }
+  }
+  m_parents = std::make_shared<const std::vector<int64_t>>(std::move(parents));
+
+  // Relative transform is parent^-1 * absolute
+  const auto &positions = m_absolute.positions.const_ref();
+  const auto &rotations = m_absolute.rotations.const_ref();
+  auto &relativePositions = *m_relativePositions;
+  auto &relativeRotations = *m_relativeRotations;
+  for (size_t i = 0; i < componentSize; ++i) {
+    const auto parent = (*m_parents)[i];
+    if (parent >= 0) {
+      const Eigen::Quaterniond inverse = rotations[parent].conjugate();
+      relativePositions[i] = inverse * (positions[i] - positions[parent]);
+      relativeRotations[i] = inverse * rotations[i];
+    }
+  }
+}
+
+/// Copies the cache of other as it stands, stale sub-trees included
+template <typename InstTree>
+RelativeComponentInfo<InstTree>::RelativeComponentInfo(
+    const RelativeComponentInfo<InstTree> &other)
+    : m_instrumentTree(other.m_instrumentTree), m_parents(other.m_parents),
+      m_relativePositions(other.m_relativePositions),
+      m_relativeRotations(other.m_relativeRotations),
+      m_absolute(other.lockedAbsolute()),
+      m_isStale(!m_absolute.staleRoots.empty()) {}
+
+template <typename InstTree>
+RelativeComponentInfo<InstTree> &RelativeComponentInfo<InstTree>::
+operator=(const RelativeComponentInfo<InstTree> &other) {
+  if (this != &other) {
+    m_instrumentTree = other.m_instrumentTree;
+    m_parents = other.m_parents;
+    m_relativePositions = other.m_relativePositions;
+    m_relativeRotations = other.m_relativeRotations;
+    m_absolute = other.lockedAbsolute();
+    m_isStale = !m_absolute.staleRoots.empty();
+  }
+  return *this;
+}
+
+template <typename InstTree>
+Eigen::Vector3d
+RelativeComponentInfo<InstTree>::position(size_t componentIndex) const {
+  refresh();
+  return m_absolute.positions.const_ref()[componentIndex];
+}
+
+template <typename InstTree>
+Eigen::Quaterniond
+RelativeComponentInfo<InstTree>::rotation(size_t componentIndex) const {
+  refresh();
+  return m_absolute.rotations.const_ref()[componentIndex];
+}
+
+/// All absolute positions, component indexed. Invalidated by writes.
+template <typename InstTree>
+Span<Eigen::Vector3d> RelativeComponentInfo<InstTree>::positions() const {
+  refresh();
+  return m_absolute.positions.const_ref();
+}
+
+/// All absolute rotations, component indexed. Invalidated by writes.
+template <typename InstTree>
+Span<Eigen::Quaterniond> RelativeComponentInfo<InstTree>::rotations() const {
+  refresh();
+  return m_absolute.rotations.const_ref();
+}
+
+/// Position in the frame of the parent component
+template <typename InstTree>
+Eigen::Vector3d
+RelativeComponentInfo<InstTree>::relativePosition(size_t componentIndex) const {
+  return m_relativePositions.const_ref()[componentIndex];
+}
+
+/// Rotation in the frame of the parent component
+template <typename InstTree>
+Eigen::Quaterniond
+RelativeComponentInfo<InstTree>::relativeRotation(size_t componentIndex) const {
+  return m_relativeRotations.const_ref()[componentIndex];
+}
+
+template <typename InstTree>
+size_t RelativeComponentInfo<InstTree>::componentSize() const {
+  return m_instrumentTree->componentSize();
+}
+
+template <typename InstTree>
+const InstTree &RelativeComponentInfo<InstTree>::const_instrumentTree() const {
+  return *m_instrumentTree;
+}
+
+/**
+ * Move a component, and with it everything below it. Costs O(depth) however
+ * large the sub-tree.
+ */
+template <typename InstTree>
+void RelativeComponentInfo<InstTree>::move(size_t componentIndex,
+                                           const Eigen::Vector3d &offset) {
+  Eigen::Vector3d position;
+  Eigen::Quaterniond rotation;
+  compose(componentIndex, position, rotation);
+  setAbsolute(componentIndex, position + offset, rotation);
+}
+
+/**
+ * Rotate a component, and with it everything below it. Costs O(depth) however
+ * large the sub-tree.
+ */
+template <typename InstTree>
+void RelativeComponentInfo<InstTree>::rotate(size_t componentIndex,
+                                             const Eigen::Vector3d &axis,
+                                             const double &theta,
+                                             const Eigen::Vector3d &center) {
+  using namespace Eigen;
+  const auto transform =
+      Translation3d(center) * AngleAxisd(theta, axis) * Translation3d(-center);
+  const Quaterniond rotation(transform.rotation());
+
+  Vector3d absolutePosition;
+  Quaterniond absoluteRotation;
+  compose(componentIndex, absolutePosition, absoluteRotation);
+  setAbsolute(componentIndex, transform * absolutePosition,
+              rotation * absoluteRotation);
+}
+
+/**
+ * Compose the absolute transform of componentIndex by walking up to the root.
+ * Does not use or update the cache, which may be stale.
+ */
+template <typename InstTree>
+void RelativeComponentInfo<InstTree>::compose(
+    size_t componentIndex, Eigen::Vector3d &position,
+    Eigen::Quaterniond &rotation) const {
+  const auto &parents = *m_parents;
+  const auto &relativePositions = m_relativePositions.const_ref();
+  const auto &relativeRotations = m_relativeRotations.const_ref();
+  position = relativePositions[componentIndex];
+  rotation = relativeRotations[componentIndex];
+  for (auto parent = parents[componentIndex]; parent >= 0;
+       parent = parents[parent]) {
+    position = relativePositions[parent] + relativeRotations[parent] * position;
+    rotation = relativeRotations[parent] * rotation;
+  }
+}
+
+/// Give componentIndex a new absolute transform, keeping its parent fixed
+template <typename InstTree>
+void RelativeComponentInfo<InstTree>::setAbsolute(
+    size_t componentIndex, const Eigen::Vector3d &position,
+    const Eigen::Quaterniond &rotation) {
+  const auto parent = (*m_parents)[componentIndex];
+  if (parent < 0) {
+    (*m_relativePositions)[componentIndex] = position;
+    (*m_relativeRotations)[componentIndex] = rotation;
+  } else {
+    Eigen::Vector3d parentPosition;
+    Eigen::Quaterniond parentRotation;
+    compose(parent, parentPosition, parentRotation);
+    const Eigen::Quaterniond inverse = parentRotation.conjugate();
+    (*m_relativePositions)[componentIndex] =
+        inverse * (position - parentPosition);
+    (*m_relativeRotations)[componentIndex] = inverse * rotation;
+  }
+  markStale(componentIndex);
+}
+
+template <typename InstTree>
+void RelativeComponentInfo<InstTree>::markStale(size_t componentIndex) {
+  auto &staleRoots = m_absolute.staleRoots;
+  staleRoots.push_back(componentIndex);
+  if (staleRoots.size() >= componentSize()) {
+    // Cheaper to recompose everything once.
+    staleRoots.assign(1, 0);
+  }
+  m_isStale = true;
+}
+
+/**
+ * Recompose the stale sub-trees. Callable from concurrent const readers: the
+ * first to take the lock recomposes, the others wait for it and find nothing
+ * left to do.
+ */
+template <typename InstTree>
+void RelativeComponentInfo<InstTree>::refresh() const {
+  if (!m_isStale.load(std::memory_order_acquire)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(m_absoluteMutex);
+  if (!m_isStale.load(std::memory_order_relaxed)) {
+    return;
+  }
+  // In depth-first order a sub-tree starting inside one already recomposed is
+  // contained by it.
+  auto &staleRoots = m_absolute.staleRoots;
+  std::sort(staleRoots.begin(), staleRoots.end());
+  size_t recomposedEnd = 0;
+  for (auto root : staleRoots) {
+    if (root < recomposedEnd) {
+      continue;
+    }
+    recomposedEnd = m_instrumentTree->subTree(root).components.end;
+    recompose(root, recomposedEnd);
+  }
+  std::vector<size_t>().swap(staleRoots);
+  m_isStale.store(false, std::memory_order_release);
+}
+
+/// Copy of the absolute cache, taken under the lock that refresh holds
+template <typename InstTree>
+typename RelativeComponentInfo<InstTree>::AbsoluteCache
+RelativeComponentInfo<InstTree>::lockedAbsolute() const {
+  std::lock_guard<std::mutex> lock(m_absoluteMutex);
+  return m_absolute;
+}
+
+/**
+ * Recompose absolute transforms of the sub-tree [begin, end). Parents precede
+ * their children, and the parent of begin lies outside the sub-tree and is
+ * therefore up to date.
+ */
+template <typename InstTree>
+void RelativeComponentInfo<InstTree>::recompose(size_t begin,
+                                                size_t end) const {
+  const auto &parents = *m_parents;
+  const auto &relativePositions = m_relativePositions.const_ref();
+  const auto &relativeRotations = m_relativeRotations.const_ref();
+  auto &positions = *m_absolute.positions;
+  auto &rotations = *m_absolute.rotations;
+  for (size_t i = begin; i < end; ++i) {
+    const auto parent = parents[i];
+    if (parent < 0) {
+      positions[i] = relativePositions[i];
+      rotations[i] = relativeRotations[i];
+    } else {
+      positions[i] =
+          positions[parent] + rotations[parent] * relativePositions[i];
+      rotations[i] = rotations[parent] * relativeRotations[i];
+    }
+  }
+}
+
+#endif
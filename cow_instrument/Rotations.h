@@ -0,0 +1,16 @@
+#ifndef ROTATIONS_H
+#define ROTATIONS_H
+
+#include <Eigen/Geometry>
+#include "ChunkedVector.h"
+
+/**
+ * Rotations, linearly indexed. Paged like L2s, so that a copy which rotates a
+ * few detectors copies only the pages holding them.
+ */
+class Rotations : public ChunkedVector<Eigen::Quaterniond> {
+public:
+  using ChunkedVector<Eigen::Quaterniond>::ChunkedVector;
+};
+
+#endif
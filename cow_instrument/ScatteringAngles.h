@@ -0,0 +1,114 @@
+#ifndef SCATTERING_ANGLES_H
+#define SCATTERING_ANGLES_H
+
+#include <cmath>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include "ChunkedVector.h"
+
+/**
+ * Orthonormal frame of the beam. z runs along the beam, y is the up axis made
+ * perpendicular to it and x = y cross z. With the beam along the lab z axis
+ * and y up this is the lab frame.
+ */
+struct BeamFrame {
+  BeamFrame()
+      : x(Eigen::Vector3d::UnitX()), y(Eigen::Vector3d::UnitY()),
+        z(Eigen::Vector3d::UnitZ()) {}
+
+  /**
+   * @param beam : Source to sample vector
+   * @param up : Up axis, need not be perpendicular to the beam
+   */
+  BeamFrame(const Eigen::Vector3d &beam, const Eigen::Vector3d &up)
+      : z(beam.normalized()) {
+    y = up - up.dot(z) * z;
+    if (y.squaredNorm() < 1e-24) {
+      // Beam along the up axis; any perpendicular will do.
+      y = z.unitOrthogonal();
+    }
+    y.normalize();
+    x = y.cross(z);
+  }
+
+  Eigen::Vector3d x;
+  Eigen::Vector3d y;
+  Eigen::Vector3d z;
+};
+
+/**
+ * Cached scattering angles, one entry per linear index. Held as separate
+ * paged arrays so that bulk readers (e.g. unit conversion) can stream a
+ * single quantity, and copies share all pages not written since.
+ *
+ * Two-theta is the angle between the beam (source to sample) and the
+ * scattered direction (sample to detector). The signed two-theta is negative
+ * for detectors on the -x side of the BeamFrame, i.e. beyond the plane of the
+ * beam and the up axis. Phi is the azimuth of the scattered direction about
+ * the beam, measured from x towards y of the BeamFrame.
+ */
+class ScatteringAngles {
+public:
+  explicit ScatteringAngles(size_t size)
+      : m_twoTheta(size), m_signedTwoTheta(size), m_phi(size),
+        m_sinTheta(size), m_cosTwoTheta(size) {}
+
+  static double twoTheta(const BeamFrame &frame,
+                         const Eigen::Vector3d &scattered) {
+    // atan2 rather than acos, which loses precision close to 0 and pi.
+    return std::atan2(frame.z.cross(scattered).norm(), frame.z.dot(scattered));
+  }
+
+  static double signedTwoTheta(const BeamFrame &frame,
+                               const Eigen::Vector3d &scattered) {
+    const double angle = twoTheta(frame, scattered);
+    return frame.x.dot(scattered) < 0 ? -angle : angle;
+  }
+
+  static double phi(const BeamFrame &frame, const Eigen::Vector3d &scattered) {
+    return std::atan2(frame.y.dot(scattered), frame.x.dot(scattered));
+  }
+
+  /**
+   * Calculate all angles at index.
+   * @param index : Linear index to set
+   * @param frame : Frame of the beam
+   * @param scattered : Sample to detector vector
+   */
+  void set(size_t index, const BeamFrame &frame,
+           const Eigen::Vector3d &scattered) {
+    const double angle = twoTheta(frame, scattered);
+    m_twoTheta[index] = angle;
+    m_signedTwoTheta[index] = frame.x.dot(scattered) < 0 ? -angle : angle;
+    m_phi[index] = phi(frame, scattered);
+    m_sinTheta[index] = std::sin(angle / 2);
+    m_cosTwoTheta[index] = std::cos(angle);
+  }
+
+  size_t size() const { return m_twoTheta.size(); }
+
+  double twoTheta(size_t index) const { return m_twoTheta[index]; }
+  double signedTwoTheta(size_t index) const { return m_signedTwoTheta[index]; }
+  double phi(size_t index) const { return m_phi[index]; }
+  double sinTheta(size_t index) const { return m_sinTheta[index]; }
+  double cosTwoTheta(size_t index) const { return m_cosTwoTheta[index]; }
+
+  const ChunkedVector<double> &twoThetas() const { return m_twoTheta; }
+  const ChunkedVector<double> &signedTwoThetas() const {
+    return m_signedTwoTheta;
+  }
+  const ChunkedVector<double> &phis() const { return m_phi; }
+  const ChunkedVector<double> &sinThetas() const { return m_sinTheta; }
+  const ChunkedVector<double> &cosTwoThetas() const { return m_cosTwoTheta; }
+
+  ScatteringAngles *clone() const { return new ScatteringAngles(*this); }
+
+private:
+  ChunkedVector<double> m_twoTheta;
+  ChunkedVector<double> m_signedTwoTheta;
+  ChunkedVector<double> m_phi;
+  ChunkedVector<double> m_sinTheta;
+  ChunkedVector<double> m_cosTwoTheta;
+};
+
+#endif
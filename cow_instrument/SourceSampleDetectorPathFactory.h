@@ -7,7 +7,8 @@
 
 /**
  * All Paths generated for all detectors in this PathFactory type
- * will go source->sample->detector.
+ * will go source->sample->detector. Every detector therefore shares a single
+ * stored L1 Path and a single stored L2 Path.
  */
 template <typename InstTree>
 class SourceSampleDetectorPathFactory : public PathFactory<InstTree> {
@@ -23,13 +24,7 @@ Paths *SourceSampleDetectorPathFactory<InstTree>::createL2(
     const InstTree &instrument) const {
 
   const size_t sampleIndex = instrument.samplePathIndex();
-  std::vector<Path> paths;
-  paths.reserve(instrument.nDetectors());
-
-  for (size_t i = 0; i < instrument.nDetectors(); ++i) {
-    paths.emplace_back(1, sampleIndex);
-  }
-  return new Paths(std::move(paths));
+  return new Paths(instrument.nDetectors(), Path(1, sampleIndex));
 }
 
 template <typename InstTree>
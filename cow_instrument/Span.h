@@ -0,0 +1,43 @@
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Read-only view of contiguous elements owned elsewhere. Used by the Info
+ * types to hand out their arrays for bulk reads without copying. A Span is
+ * invalidated by any write to the Info object it came from, as a write may
+ * copy (see CowPtr) or reallocate the underlying storage.
+ */
+template <typename T> class Span {
+public:
+  Span() = default;
+  Span(const T *data, size_t size) : m_data(data), m_size(size) {}
+  Span(const std::vector<T> &data) : m_data(data.data()), m_size(data.size()) {}
+
+  const T *data() const { return m_data; }
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+
+  const T &operator[](size_t index) const { return m_data[index]; }
+
+  const T *begin() const { return m_data; }
+  const T *end() const { return m_data + m_size; }
+
+  /// Element-wise comparison. Either side may be a std::vector.
+  friend bool operator==(const Span &lhs, const Span &rhs) {
+    return lhs.size() == rhs.size() &&
+           std::equal(lhs.begin(), lhs.end(), rhs.begin());
+  }
+  friend bool operator!=(const Span &lhs, const Span &rhs) {
+    return !(lhs == rhs);
+  }
+
+private:
+  const T *m_data = nullptr;
+  size_t m_size = 0;
+};
+
+#endif
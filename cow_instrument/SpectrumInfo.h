@@ -8,6 +8,8 @@
 #include "DetectorInfo.h"
 #include "FlatTree.h"
 #include "L2s.h"
+#include "Span.h"
+#include "Parallel.h"
 #include "Spectrum.h"
 
 /**
@@ -31,6 +33,8 @@ public:
 
   Spectrum spectrum(size_t index) const;
 
+  Span<Spectrum> spectra() const;
+
   double l2(size_t index) const;
 
   CowPtr<L2s> l2s() const;
@@ -101,17 +105,25 @@ SpectrumInfo<InstTree>::SpectrumInfo(const std::vector<Spectrum> &spectra,
 }
 
 template <typename InstTree> void SpectrumInfo<InstTree>::initL2() {
-  for (size_t spectrumIndex = 0; spectrumIndex < this->size();
-       ++spectrumIndex) {
-
-    double l2Temp = 0;
-    for (auto detectorIndex : m_spectra.const_ref()[spectrumIndex].indexes()) {
-      l2Temp += m_detectorInfo.l2(detectorIndex);
+  // Bring the detector L2s up to date once, then only read them.
+  const CowPtr<L2s> detectorL2s = m_detectorInfo.l2s();
+  const L2s &detectorL2 = detectorL2s.const_ref();
+  const Spectra &spectra = m_spectra.const_ref();
+  L2s &l2s = *m_l2;
+
+  parallelFor(this->size(), [&](size_t begin, size_t end) {
+    for (size_t spectrumIndex = begin; spectrumIndex < end; ++spectrumIndex) {
+
+      double l2Temp = 0;
+      for (auto detectorIndex : spectra[spectrumIndex].indexes()) {
+        detectorRangeCheck(detectorIndex, detectorL2);
+        l2Temp += detectorL2[detectorIndex];
+      }
+      // Divide through by number of detectors
+      l2Temp /= spectra[spectrumIndex].size();
+      l2s[spectrumIndex] = l2Temp;
     }
-    // Divide through by number of detectors
-    l2Temp /= m_spectra.const_ref()[spectrumIndex].size();
-    (*m_l2)[spectrumIndex] = l2Temp;
-  }
+  });
 }
 
 template <typename InstTree> size_t SpectrumInfo<InstTree>::size() const {
@@ -132,6 +144,12 @@ Spectrum SpectrumInfo<InstTree>::spectrum(size_t index) const {
   return m_spectra.const_ref()[index];
 }
 
+/// All spectra, spectrum indexed
+template <typename InstTree>
+Span<Spectrum> SpectrumInfo<InstTree>::spectra() const {
+  return m_spectra.const_ref().rawData();
+}
+
 template <typename InstTree>
 double SpectrumInfo<InstTree>::l2(size_t index) const {
   spectraRangeCheck(index, m_spectra.const_ref());
@@ -0,0 +1,41 @@
+#ifndef SUB_TREE_H
+#define SUB_TREE_H
+
+#include <cstddef>
+
+/// Half-open range of indexes [begin, end)
+struct IndexRange {
+  size_t begin;
+  size_t end;
+
+  size_t size() const { return end - begin; }
+  bool empty() const { return begin == end; }
+
+  bool operator==(const IndexRange &other) const {
+    return begin == other.begin && end == other.end;
+  }
+  bool operator!=(const IndexRange &other) const { return !(*this == other); }
+};
+
+/**
+ * Indexes covered by the sub-tree of a component, the component included.
+ *
+ * FlatTree stores components in depth-first order, and detector, path
+ * component and branch node indexes are handed out in that same order. Every
+ * sub-tree is therefore one contiguous range of each kind of index.
+ */
+struct SubTree {
+  IndexRange components;
+  IndexRange detectors;
+  IndexRange pathComponents;
+  IndexRange branchNodes;
+
+  bool operator==(const SubTree &other) const {
+    return components == other.components && detectors == other.detectors &&
+           pathComponents == other.pathComponents &&
+           branchNodes == other.branchNodes;
+  }
+  bool operator!=(const SubTree &other) const { return !(*this == other); }
+};
+
+#endif
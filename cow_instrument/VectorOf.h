@@ -1,12 +1,16 @@
 #ifndef VECTOROF_H
 #define VECTOROF_H
 #include <vector>
+#include "IndexType.h"
 
 /**
   CRTP class where T is the type to create the VectorOf type around.
 
-  VectorOf<T> uses a vector<size_t>, the vector itself does not take the type
-  parameter, the T type argument is used to ensure type incompatibility.
+  VectorOf<T> uses a vector<IndexType>, the vector itself does not take the
+  type parameter, the T type argument is used to ensure type incompatibility.
+
+  Indexes given as size_t throw std::invalid_argument if they do not fit
+  IndexType.
  */
 
 template <typename T> class VectorOf {
@@ -17,51 +21,54 @@ public:
   VectorOf(const VectorOf<T> &) = default;
   VectorOf(VectorOf<T> &&) = default;
   VectorOf(const std::vector<size_t> &indexes);
-  VectorOf(std::vector<size_t> &&indexes);
+  VectorOf(std::vector<IndexType> &&indexes);
 
   VectorOf &operator=(const VectorOf<T> &rhs) = default;
   VectorOf &operator=(VectorOf<T> &&rhs) = default;
   VectorOf &operator=(const std::vector<size_t> &rhs);
-  VectorOf &operator=(std::vector<size_t> &&rhs);
+  VectorOf &operator=(std::vector<IndexType> &&rhs);
   VectorOf &operator=(std::initializer_list<size_t> ilist);
   bool operator==(const VectorOf<T> &other) const;
   bool operator!=(const VectorOf<T> &other) const;
-  const std::vector<size_t> &indexes() const;
+  const std::vector<IndexType> &indexes() const;
 
   size_t size() const;
-  const size_t &operator[](size_t pos) const;
-  size_t &operator[](size_t pos);
+  const IndexType &operator[](size_t pos) const;
+  IndexType &operator[](size_t pos);
 
 private:
-  std::vector<size_t> m_indexes;
+  static size_t checked(size_t index);
+  template <typename Range> static const Range &checked(const Range &indexes);
+
+  std::vector<IndexType> m_indexes;
 };
 
 template <typename T> VectorOf<T>::VectorOf(size_t size) : m_indexes(size, 0) {}
 template <typename T>
 VectorOf<T>::VectorOf(size_t size, const size_t &value)
-    : m_indexes(size, value) {}
+    : m_indexes(size, IndexType(checked(value))) {}
 template <typename T>
 VectorOf<T>::VectorOf(std::initializer_list<size_t> init)
-    : m_indexes(init) {}
+    : m_indexes(checked(init).begin(), init.end()) {}
 template <typename T>
 VectorOf<T>::VectorOf(const std::vector<size_t> &indexes)
-    : m_indexes(indexes) {}
+    : m_indexes(checked(indexes).begin(), indexes.end()) {}
 template <typename T>
-VectorOf<T>::VectorOf(std::vector<size_t> &&indexes)
+VectorOf<T>::VectorOf(std::vector<IndexType> &&indexes)
     : m_indexes(std::move(indexes)) {}
 template <typename T>
 VectorOf<T> &VectorOf<T>::operator=(const std::vector<size_t> &rhs) {
-  m_indexes = rhs;
+  m_indexes.assign(checked(rhs).begin(), rhs.end());
   return *this;
 }
 template <typename T>
-VectorOf<T> &VectorOf<T>::operator=(std::vector<size_t> &&rhs) {
+VectorOf<T> &VectorOf<T>::operator=(std::vector<IndexType> &&rhs) {
   m_indexes = std::move(rhs);
   return *this;
 }
 template <typename T>
 VectorOf<T> &VectorOf<T>::operator=(std::initializer_list<size_t> ilist) {
-  m_indexes = ilist;
+  m_indexes.assign(checked(ilist).begin(), ilist.end());
   return *this;
 }
 template <typename T>
@@ -72,17 +79,32 @@ template <typename T>
 bool VectorOf<T>::operator!=(const VectorOf<T> &other) const {
   return m_indexes != other.m_indexes;
 }
-template <typename T> const std::vector<size_t> &VectorOf<T>::indexes() const {
+template <typename T>
+const std::vector<IndexType> &VectorOf<T>::indexes() const {
   return m_indexes;
 }
 template <typename T> size_t VectorOf<T>::size() const {
   return m_indexes.size();
 }
-template <typename T> const size_t &VectorOf<T>::operator[](size_t pos) const {
+template <typename T>
+const IndexType &VectorOf<T>::operator[](size_t pos) const {
   return m_indexes[pos];
 }
-template <typename T> size_t &VectorOf<T>::operator[](size_t pos) {
+template <typename T> IndexType &VectorOf<T>::operator[](size_t pos) {
   return m_indexes[pos];
 }
+template <typename T> size_t VectorOf<T>::checked(size_t index) {
+  checkIndexFits(index, "VectorOf");
+  return index;
+}
+/// indexes, after checking that each fits IndexType
+template <typename T>
+template <typename Range>
+const Range &VectorOf<T>::checked(const Range &indexes) {
+  for (const size_t index : indexes) {
+    checkIndexFits(index, "VectorOf");
+  }
+  return indexes;
+}
 
 #endif
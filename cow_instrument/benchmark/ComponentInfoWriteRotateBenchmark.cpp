@@ -1,3 +1,4 @@
+#include "RelativeComponentInfo.h"
 #include "StandardInstrument.h"
 #include <benchmark/benchmark_api.h>
 
@@ -53,6 +54,56 @@ BENCHMARK_F(ComponentInfoWriteRotateFixture,
   this->rotateOnComponent(2, true /*with read metric*/, state);
 }
 
+/*
+ Same rotations with transforms held relative to the parent component. Writes
+ touch one component, reads recompose the rotated sub-tree.
+ */
+class RelativeComponentInfoWriteRotateFixture
+    : public StandardInstrumentFixture {
+
+public:
+  RelativeComponentInfoWriteRotateFixture()
+      : m_relativeInfo(std::make_shared<const FlatTree>(m_instrument)) {}
+
+  void rotateOnComponent(size_t componentIndex, bool read,
+                         benchmark::State &state) {
+
+    Eigen::Vector3d axis{0, 0, 1};
+    auto angle = M_PI / 2;
+    Eigen::Vector3d center{0, 0, 0};
+
+    while (state.KeepRunning()) {
+      m_relativeInfo.rotate(componentIndex, axis, angle, center);
+
+      if (read) {
+        Eigen::Vector3d pos{0, 0, 0};
+        for (const auto &position : m_relativeInfo.positions()) {
+          benchmark::DoNotOptimize(pos += position);
+        }
+      }
+    }
+    state.SetItemsProcessed(state.iterations() * 1);
+  }
+
+  RelativeComponentInfo<FlatTree> m_relativeInfo;
+};
+
+BENCHMARK_F(RelativeComponentInfoWriteRotateFixture,
+            BM_rotate_root_relative)(benchmark::State &state) {
+  this->rotateOnComponent(0, false /*no read metric*/, state);
+}
+
+BENCHMARK_F(RelativeComponentInfoWriteRotateFixture,
+            BM_rotate_one_bank_relative)(benchmark::State &state) {
+  this->rotateOnComponent(2, false /*no read metric*/, state);
+}
+
+BENCHMARK_F(RelativeComponentInfoWriteRotateFixture,
+            BM_rotate_one_bank_relative_with_pos_read)
+(benchmark::State &state) {
+  this->rotateOnComponent(2, true /*with read metric*/, state);
+}
+
 // Just gets us the execution policy
 class RotationBenchmark : public StandardBenchmark<RotationBenchmark> {};
 
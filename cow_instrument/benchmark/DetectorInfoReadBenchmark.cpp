@@ -1,5 +1,7 @@
+#include "DetectorBVH.h"
 #include "StandardInstrument.h"
 #include <benchmark/benchmark_api.h>
+#include <map>
 
 namespace {
 
@@ -17,6 +19,46 @@ BENCHMARK_F(DetectorInfoReadFixture,
   state.SetItemsProcessed(state.iterations() * max);
 }
 
+BENCHMARK_F(DetectorInfoReadFixture,
+            BM_detectorinfo_detector_read_single_position_soa)(
+    benchmark::State &state) {
+  const size_t max = m_soaDetectorInfo.detectorSize(); // ndetectors
+  while (state.KeepRunning()) {
+    for (size_t i = 1; i < max; ++i) {
+      benchmark::DoNotOptimize(m_soaDetectorInfo.position(i));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * max);
+}
+
+BENCHMARK_F(DetectorInfoReadFixture,
+            BM_detectorinfo_detector_read_all_distances)(
+    benchmark::State &state) {
+  const Eigen::Vector3d samplePos{0, 0, 10};
+  const auto map = m_detectorInfo.const_positions().map();
+  Eigen::ArrayXd distances(map.cols());
+  while (state.KeepRunning()) {
+    distances = (map.colwise() - samplePos).colwise().norm().transpose();
+    benchmark::DoNotOptimize(distances.data());
+  }
+  state.SetItemsProcessed(state.iterations() * map.cols());
+}
+
+BENCHMARK_F(DetectorInfoReadFixture,
+            BM_detectorinfo_detector_read_all_distances_soa)(
+    benchmark::State &state) {
+  const Eigen::Vector3d samplePos{0, 0, 10};
+  const auto map = m_soaDetectorInfo.const_positions().map();
+  Eigen::ArrayXd distances(map.rows());
+  while (state.KeepRunning()) {
+    distances = ((map.col(0).array() - samplePos[0]).square() +
+                 (map.col(1).array() - samplePos[1]).square() +
+                 (map.col(2).array() - samplePos[2]).square()).sqrt();
+    benchmark::DoNotOptimize(distances.data());
+  }
+  state.SetItemsProcessed(state.iterations() * map.rows());
+}
+
 BENCHMARK_F(DetectorInfoReadFixture,
             BM_detectorinfo_detector_read_single_rotation)(
     benchmark::State &state) {
@@ -29,6 +71,141 @@ BENCHMARK_F(DetectorInfoReadFixture,
   state.SetItemsProcessed(state.iterations() * max);
 }
 
+BENCHMARK_F(DetectorInfoReadFixture,
+            BM_detectorinfo_detector_read_all_rotations_bulk)(
+    benchmark::State &state) {
+  const auto &rotations = m_detectorInfo.rotations();
+  while (state.KeepRunning()) {
+    for (const auto &rotation : rotations) {
+      benchmark::DoNotOptimize(rotation);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * rotations.size());
+}
+
+BENCHMARK_F(DetectorInfoReadFixture,
+            BM_detectorinfo_detector_count_masked)(benchmark::State &state) {
+  const size_t max = m_detectorInfo.detectorSize(); // ndetectors
+  while (state.KeepRunning()) {
+    size_t masked = 0;
+    for (size_t i = 0; i < max; ++i) {
+      masked += m_detectorInfo.isMasked(i);
+    }
+    benchmark::DoNotOptimize(masked);
+  }
+  state.SetItemsProcessed(state.iterations() * max);
+}
+
+BENCHMARK_F(DetectorInfoReadFixture,
+            BM_detectorinfo_detector_count_masked_bulk)(
+    benchmark::State &state) {
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(m_detectorInfo.maskedCount());
+  }
+  state.SetItemsProcessed(state.iterations() * m_detectorInfo.detectorSize());
+}
+
+BENCHMARK_F(DetectorInfoReadFixture,
+            BM_detectorinfo_detector_mask_bank)(benchmark::State &state) {
+  // Banks are 100 x 100 detectors
+  const size_t bankSize = 100 * 100;
+  while (state.KeepRunning()) {
+    for (size_t i = 0; i < bankSize; ++i) {
+      m_detectorInfo.setMasked(i);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * bankSize);
+}
+
+BENCHMARK_F(DetectorInfoReadFixture,
+            BM_detectorinfo_detector_mask_bank_range)(
+    benchmark::State &state) {
+  const size_t bankSize = 100 * 100;
+  while (state.KeepRunning()) {
+    m_detectorInfo.setMaskedRange(0, bankSize);
+  }
+  state.SetItemsProcessed(state.iterations() * bankSize);
+}
+
+std::vector<DetectorIdType> detectorIds(const FlatTree &instrument) {
+  std::map<DetectorIdType, size_t> detectorMap;
+  instrument.fillDetectorMap(detectorMap);
+  std::vector<DetectorIdType> detectorIds;
+  for (const auto &item : detectorMap) {
+    detectorIds.push_back(item.first);
+  }
+  return detectorIds;
+}
+
+BENCHMARK_F(DetectorInfoReadFixture,
+            BM_flattree_detector_id_lookup_map)(benchmark::State &state) {
+  std::map<DetectorIdType, size_t> detectorMap;
+  m_instrument.fillDetectorMap(detectorMap);
+  const auto ids = detectorIds(m_instrument);
+  while (state.KeepRunning()) {
+    size_t sum = 0;
+    for (const auto &id : ids) {
+      sum += detectorMap.find(id)->second;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * ids.size());
+}
+
+BENCHMARK_F(DetectorInfoReadFixture,
+            BM_flattree_detector_id_lookup_batch)(benchmark::State &state) {
+  const auto ids = detectorIds(m_instrument);
+  std::vector<size_t> detectorIndexes;
+  while (state.KeepRunning()) {
+    m_instrument.detectorIndexes(ids, detectorIndexes);
+    benchmark::DoNotOptimize(detectorIndexes.data());
+  }
+  state.SetItemsProcessed(state.iterations() * ids.size());
+}
+
+/// Points just off every 1000th detector, as for peak prediction
+std::vector<Eigen::Vector3d>
+queryPoints(const DetectorInfo<FlatTree> &detectorInfo) {
+  std::vector<Eigen::Vector3d> points;
+  for (size_t i = 0; i < detectorInfo.detectorSize(); i += 1000) {
+    points.push_back(detectorInfo.position(i) + Eigen::Vector3d{1e-3, 0, 0});
+  }
+  return points;
+}
+
+BENCHMARK_F(DetectorInfoReadFixture,
+            BM_nearest_detector_linear)(benchmark::State &state) {
+  const auto points = queryPoints(m_detectorInfo);
+  const size_t max = m_detectorInfo.detectorSize();
+  while (state.KeepRunning()) {
+    for (const auto &point : points) {
+      size_t nearest = 0;
+      double best = std::numeric_limits<double>::infinity();
+      for (size_t i = 0; i < max; ++i) {
+        const double d2 = (m_detectorInfo.position(i) - point).squaredNorm();
+        if (d2 < best) {
+          best = d2;
+          nearest = i;
+        }
+      }
+      benchmark::DoNotOptimize(nearest);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+
+BENCHMARK_F(DetectorInfoReadFixture,
+            BM_nearest_detector_bvh)(benchmark::State &state) {
+  const auto points = queryPoints(m_detectorInfo);
+  DetectorBVH<FlatTree> bvh(m_detectorInfo, 0.001);
+  while (state.KeepRunning()) {
+    for (const auto &point : points) {
+      benchmark::DoNotOptimize(bvh.nearest(point));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+
 } // namespace
 
 BENCHMARK_MAIN()
@@ -43,6 +43,23 @@ public:
                               m_detectorInfo.detectorSize());
     }
   }
+
+  void rotateDetectorsAsBatchSoA(benchmark::State &state) {
+
+    std::vector<size_t> detectorIndexes(m_soaDetectorInfo.detectorSize());
+    std::iota(detectorIndexes.begin(), detectorIndexes.end(), 0);
+
+    Eigen::Vector3d axis{0, 0, 1};
+    auto angle = M_PI / 2;
+    Eigen::Vector3d center{0, 0, 0};
+
+    while (state.KeepRunning()) {
+      m_soaDetectorInfo.rotateDetectors(detectorIndexes, axis, angle, center);
+
+      state.SetItemsProcessed(state.iterations() *
+                              m_soaDetectorInfo.detectorSize());
+    }
+  }
 };
 
 BENCHMARK_F(DetectorInfoWriteRotateFixture,
@@ -55,4 +72,9 @@ BENCHMARK_F(DetectorInfoWriteRotateFixture,
   this->rotateDetectorsAsBatch(state);
 }
 
+BENCHMARK_F(DetectorInfoWriteRotateFixture,
+            BM_rotate_bank_at_once_soa)(benchmark::State &state) {
+  this->rotateDetectorsAsBatchSoA(state);
+}
+
 } // namespace
@@ -1,4 +1,5 @@
 #include "StandardInstrument.h"
+#include "SourceSampleDetectorPathFactory.h"
 #include <benchmark/benchmark_api.h>
 #include <stdexcept>
 #include <numeric>
@@ -39,6 +40,21 @@ public:
                               m_detectorInfo.detectorSize());
     }
   }
+
+  void moveDetectorsAsBatchSoA(benchmark::State &state) {
+
+    std::vector<size_t> detectorIndexes(m_soaDetectorInfo.detectorSize());
+    std::iota(detectorIndexes.begin(), detectorIndexes.end(), 0);
+
+    Eigen::Vector3d offset{1, 0, 0};
+
+    while (state.KeepRunning()) {
+      m_soaDetectorInfo.moveDetectors(detectorIndexes, offset);
+
+      state.SetItemsProcessed(state.iterations() *
+                              m_soaDetectorInfo.detectorSize());
+    }
+  }
 };
 
 BENCHMARK_F(DetectorInfoWriteTranslateFixture,
@@ -51,4 +67,23 @@ BENCHMARK_F(DetectorInfoWriteTranslateFixture,
   this->moveDetectorsAsBatch(state);
 }
 
+BENCHMARK_F(DetectorInfoWriteTranslateFixture,
+            BM_translate_bank_at_once_soa)(benchmark::State &state) {
+  this->moveDetectorsAsBatchSoA(state);
+}
+
+void BM_translate_one_detector_scaling(benchmark::State &state) {
+  // Cost of moving a single detector should not depend on instrument size.
+  DetectorInfo<FlatTree> detectorInfo(
+      std::make_shared<FlatTree>(
+          std_instrument::construct_single_bank(state.range(0))),
+      SourceSampleDetectorPathFactory<FlatTree>{});
+  Eigen::Vector3d offset{1, 0, 0};
+  while (state.KeepRunning()) {
+    detectorInfo.moveDetector(0, offset);
+  }
+  state.SetItemsProcessed(state.iterations() * 1);
+}
+BENCHMARK(BM_translate_one_detector_scaling)->Range(1 << 10, 1 << 18);
+
 } // namespace
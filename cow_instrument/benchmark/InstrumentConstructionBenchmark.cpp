@@ -27,4 +27,14 @@ BENCHMARK_F(InstrumentConstructionBenchmark,
   }
   state.SetItemsProcessed(state.iterations() * 1);
 }
+
+BENCHMARK_F(InstrumentConstructionBenchmark,
+            BM_instrument_tree_builder_construction)(benchmark::State &state) {
+  size_t nDetectors = 0;
+  while (state.KeepRunning()) {
+    FlatTree instrumentTree = std_instrument::construct_flat_tree();
+    benchmark::DoNotOptimize(nDetectors += instrumentTree.nDetectors());
+  }
+  state.SetItemsProcessed(state.iterations() * 1);
+}
 }
@@ -6,9 +6,11 @@
 #include "PointSource.h"
 #include "SourceSampleDetectorPathFactory.h"
 #include "FlatTree.h"
+#include "Parallel.h"
 #include "ScanTime.h"
 #include <benchmark/benchmark_api.h>
 #include <iostream>
+#include <numeric>
 
 namespace {
 
@@ -29,7 +31,8 @@ std::unique_ptr<Component> make_tube(size_t nPixels, std::string name,
 /*
  * Analogue to D2B
  */
-DetectorInfo<FlatTree> createScanningDetectorInfo() {
+template <typename PositionStorage>
+DetectorInfo<FlatTree, PositionStorage> createScanningDetectorInfo() {
   /*
           instrument root
           |
@@ -98,26 +101,27 @@ DetectorInfo<FlatTree> createScanningDetectorInfo() {
   std::shared_ptr<FlatTree> instrument =
       std::make_shared<FlatTree>(std::move(root));
 
-  DetectorInfo<FlatTree> info(instrument, timeIndexes, scanTimes, positions,
-                              rotations);
+  DetectorInfo<FlatTree, PositionStorage> info(instrument, timeIndexes,
+                                               scanTimes, positions, rotations);
 
   return info;
 }
 
-class DetectorInfoScanningFixture
-    : public StandardBenchmark<DetectorInfoScanningFixture> {
+template <typename PositionStorage>
+class DetectorInfoScanningFixtureT
+    : public StandardBenchmark<DetectorInfoScanningFixtureT<PositionStorage>> {
 private:
-  DetectorInfo<FlatTree> m_detectorInfo;
+  DetectorInfo<FlatTree, PositionStorage> m_detectorInfo;
 
 public:
-  DetectorInfoScanningFixture()
-      : m_detectorInfo(createScanningDetectorInfo()) {}
+  DetectorInfoScanningFixtureT()
+      : m_detectorInfo(createScanningDetectorInfo<PositionStorage>()) {}
 
   void doConstruct(benchmark::State &state) {
 
     while (state.KeepRunning()) {
 
-      benchmark::DoNotOptimize(createScanningDetectorInfo());
+      benchmark::DoNotOptimize(createScanningDetectorInfo<PositionStorage>());
     }
     state.SetItemsProcessed(state.iterations() * 1);
   }
@@ -158,7 +162,42 @@ public:
     }
     state.SetItemsProcessed(state.iterations() * detectorSize * scanSize);
   }
+
+  void doRecalculateL2s(benchmark::State &state) {
+
+    // Moving the sample invalidates every L2
+    const std::vector<size_t> sample{
+        m_detectorInfo.const_instrumentTree().samplePathIndex()};
+    Eigen::Vector3d offset{0, 0, 1e-3};
+
+    while (state.KeepRunning()) {
+      m_detectorInfo.movePathComponents(sample, offset);
+      benchmark::DoNotOptimize(m_detectorInfo.l2(0, 0));
+    }
+    state.SetItemsProcessed(state.iterations() *
+                            m_detectorInfo.detectorSize() *
+                            m_detectorInfo.scanCount());
+  }
+
+  void doMoveAll(benchmark::State &state) {
+
+    // Every scan position of every detector
+    std::vector<size_t> linearIndexes(m_detectorInfo.detectorSize() *
+                                      m_detectorInfo.scanCount());
+    std::iota(linearIndexes.begin(), linearIndexes.end(), 0);
+    Eigen::Vector3d offset{1, 0, 0};
+
+    while (state.KeepRunning()) {
+      m_detectorInfo.moveDetectors(linearIndexes, offset);
+    }
+    state.SetItemsProcessed(state.iterations() * linearIndexes.size());
+  }
 };
+
+using DetectorInfoScanningFixture = DetectorInfoScanningFixtureT<AoSPositions>;
+using DetectorInfoScanningSoAFixture =
+    DetectorInfoScanningFixtureT<SoAPositions>;
+
 BENCHMARK_F(DetectorInfoScanningFixture,
             BM_detector_info_scanning_construct)(benchmark::State &state) {
 
@@ -182,4 +221,52 @@ BENCHMARK_F(DetectorInfoScanningFixture,
   // Find out how quickly we can read l2.
   doReadL2s(state);
 }
+BENCHMARK_F(DetectorInfoScanningFixture,
+            BM_detector_info_scanning_recalculate_l2s)(
+    benchmark::State &state) {
+
+  doRecalculateL2s(state);
+}
+
+BENCHMARK_F(DetectorInfoScanningFixture,
+            BM_detector_info_scanning_recalculate_l2s_single_thread)(
+    benchmark::State &state) {
+
+  // Baseline for the threaded recalculation above
+  setParallelThreadCount(1);
+  doRecalculateL2s(state);
+  setParallelThreadCount(0);
+}
+
+BENCHMARK_F(DetectorInfoScanningSoAFixture,
+            BM_detector_info_scanning_recalculate_l2s_soa)(
+    benchmark::State &state) {
+
+  doRecalculateL2s(state);
+}
+
+BENCHMARK_F(DetectorInfoScanningFixture,
+            BM_detector_info_scanning_move_all)(benchmark::State &state) {
+
+  doMoveAll(state);
+}
+
+BENCHMARK_F(DetectorInfoScanningSoAFixture,
+            BM_detector_info_scanning_read_positions_soa)(
+    benchmark::State &state) {
+
+  doReadPositions(state);
+}
+
+BENCHMARK_F(DetectorInfoScanningSoAFixture,
+            BM_detector_info_scanning_read_l2s_soa)(benchmark::State &state) {
+
+  doReadL2s(state);
+}
+
+BENCHMARK_F(DetectorInfoScanningSoAFixture,
+            BM_detector_info_scanning_move_all_soa)(benchmark::State &state) {
+
+  doMoveAll(state);
+}
 }
@@ -1,6 +1,7 @@
 #include "StandardInstrument.h"
 #include "CompositeComponent.h"
 #include "DetectorComponent.h"
+#include "FlatTreeBuilder.h"
 #include "PointSample.h"
 #include "PointSource.h"
 #include "SourceSampleDetectorPathFactory.h"
@@ -25,6 +26,19 @@ std::unique_ptr<Component> make_square_bank(size_t width, size_t height,
 
   return std::move(bank);
 }
+
+void add_square_bank(FlatTreeBuilder &builder, size_t width, size_t height) {
+  static DetectorIdType detectorId(1);
+  static ComponentIdType componentId(1);
+  builder.beginAssembly(ComponentIdType(0));
+  for (size_t i = 0; i < width; ++i) {
+    for (size_t j = 0; j < height; ++j) {
+      builder.addDetector(componentId++, detectorId++,
+                          Eigen::Vector3d{double(i), double(j), double(0)});
+    }
+  }
+  builder.endAssembly();
+}
 }
 
 namespace std_instrument {
@@ -80,6 +94,43 @@ std::shared_ptr<Component> construct_root_component() {
 
   return root;
 }
+
+/// A source, a sample and a single bank of nDetectors detectors in a row
+std::shared_ptr<Component> construct_single_bank(size_t nDetectors) {
+  auto root = std::make_shared<CompositeComponent>(ComponentIdType(0), "root");
+  root->addComponent(make_square_bank(nDetectors, 1, "Bank"));
+  root->addComponent(std::unique_ptr<PointSource>(
+      new PointSource{Eigen::Vector3d{0, 0, 0}, ComponentIdType(100)}));
+  root->addComponent(std::unique_ptr<PointSample>(
+      new PointSample{Eigen::Vector3d{0, 0, 10}, ComponentIdType(101)}));
+  return root;
+}
+
+/// As construct_root_component, but built directly with FlatTreeBuilder
+FlatTree construct_flat_tree() {
+  const size_t width = 100;
+  const size_t height = 100;
+  const size_t nBanks = 6;
+
+  FlatTreeBuilder builder;
+  builder.reserve(nBanks * (width * height + 1) + 5, nBanks * width * height,
+                  2);
+  builder.beginAssembly(ComponentIdType(0));
+  builder.beginAssembly(ComponentIdType(1)); // front_trolley
+  for (size_t bank = 0; bank < 4; ++bank) {
+    add_square_bank(builder, width, height);
+  }
+  builder.endAssembly();
+  builder.beginAssembly(ComponentIdType(2)); // rear_trolley
+  for (size_t bank = 4; bank < nBanks; ++bank) {
+    add_square_bank(builder, width, height);
+  }
+  builder.endAssembly();
+  builder.addSource(ComponentIdType(100), Eigen::Vector3d{0, 0, 0});
+  builder.addSample(ComponentIdType(101), Eigen::Vector3d{0, 0, 10});
+  builder.endAssembly();
+  return builder.build();
+}
 }
 
 StandardInstrumentFixture::StandardInstrumentFixture()
@@ -91,4 +142,7 @@ StandardInstrumentFixture::StandardInstrumentFixture()
           SourceSampleDetectorPathFactory<FlatTree>{})),
       m_detectorInfo(std::make_shared<FlatTree>(
                          std_instrument::construct_root_component()),
-                     SourceSampleDetectorPathFactory<FlatTree>{}) {}
+                     SourceSampleDetectorPathFactory<FlatTree>{}),
+      m_soaDetectorInfo(std::make_shared<FlatTree>(
+                            std_instrument::construct_root_component()),
+                        SourceSampleDetectorPathFactory<FlatTree>{}) {}
@@ -11,6 +11,8 @@
 class Node;
 namespace std_instrument {
 std::shared_ptr<Component> construct_root_component();
+std::shared_ptr<Component> construct_single_bank(size_t nDetectors);
+FlatTree construct_flat_tree();
 }
 
 /*
@@ -23,6 +25,8 @@ public:
   FlatTree m_instrument;
   ComponentInfo<FlatTree> m_componentInfo;
   DetectorInfo<FlatTree> m_detectorInfo;
+  /// Same instrument with structure-of-arrays position storage
+  DetectorInfo<FlatTree, SoAPositions> m_soaDetectorInfo;
 
   StandardInstrumentFixture();
 };
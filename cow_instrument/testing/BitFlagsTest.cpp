@@ -0,0 +1,104 @@
+#include "MaskFlags.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+TEST(bit_flags_test, test_construct) {
+  MaskFlags unset(70);
+  EXPECT_EQ(70, unset.size());
+  EXPECT_EQ(2, unset.words().size());
+  EXPECT_EQ(0, unset.count());
+
+  MaskFlags set(70, true);
+  EXPECT_EQ(70, set.count()) << "Bits past the end should not be set";
+  EXPECT_TRUE(set[69]);
+}
+
+TEST(bit_flags_test, test_pop_count) {
+  const uint64_t words[] = {0,
+                            1,
+                            0x8000000000000000ULL,
+                            0xffffffffffffffffULL,
+                            0x5555555555555555ULL,
+                            0x0123456789abcdefULL};
+  const size_t expected[] = {0, 1, 1, 64, 32, 32};
+  for (size_t i = 0; i < 6; ++i) {
+    EXPECT_EQ(expected[i], popCountPortable(words[i]));
+    EXPECT_EQ(expected[i], popCount(words[i]));
+  }
+}
+
+TEST(bit_flags_test, test_set_reset) {
+  MaskFlags flags(130);
+  flags.set(0);
+  flags.set(64);
+  flags.set(129);
+  EXPECT_TRUE(flags[0]);
+  EXPECT_FALSE(flags[1]);
+  EXPECT_TRUE(flags[64]);
+  EXPECT_TRUE(flags[129]);
+  EXPECT_EQ(3, flags.count());
+
+  flags.reset(64);
+  EXPECT_FALSE(flags[64]);
+  flags.set(0, false);
+  EXPECT_FALSE(flags[0]);
+  EXPECT_EQ(1, flags.count());
+}
+
+TEST(bit_flags_test, test_set_list) {
+  MaskFlags flags(100);
+  flags.set(std::vector<size_t>{3, 50, 99});
+  EXPECT_EQ(3, flags.count());
+  EXPECT_TRUE(flags[50]);
+  EXPECT_THROW(flags.set(std::vector<size_t>{1, 100}), std::out_of_range);
+  EXPECT_FALSE(flags[1]);
+}
+
+TEST(bit_flags_test, test_set_range) {
+  for (size_t begin : {0, 1, 63, 64, 65}) {
+    for (size_t end : {65, 127, 128, 200}) {
+      MaskFlags flags(200);
+      flags.setRange(begin, end);
+      EXPECT_EQ(end - begin, flags.count());
+      for (size_t i = 0; i < flags.size(); ++i) {
+        EXPECT_EQ(i >= begin && i < end, flags[i]);
+      }
+    }
+  }
+  MaskFlags flags(10);
+  flags.setRange(5, 5);
+  EXPECT_EQ(0, flags.count());
+  EXPECT_THROW(flags.setRange(0, 11), std::out_of_range);
+  EXPECT_THROW(flags.setRange(6, 5), std::out_of_range);
+}
+
+TEST(bit_flags_test, test_union_intersection) {
+  MaskFlags a(100);
+  MaskFlags b(100);
+  a.setRange(0, 60);
+  b.setRange(40, 100);
+
+  MaskFlags intersection = a;
+  intersection &= b;
+  EXPECT_EQ(20, intersection.count());
+  EXPECT_TRUE(intersection[40]);
+  EXPECT_FALSE(intersection[60]);
+
+  a |= b;
+  EXPECT_EQ(100, a.count());
+
+  MaskFlags wrongSize(99);
+  EXPECT_THROW(a |= wrongSize, std::invalid_argument);
+  EXPECT_THROW(a &= wrongSize, std::invalid_argument);
+}
+
+TEST(bit_flags_test, test_equality) {
+  MaskFlags a(10);
+  MaskFlags b(10);
+  EXPECT_EQ(a, b);
+  a.set(3);
+  EXPECT_NE(a, b);
+  EXPECT_NE(MaskFlags(10), MaskFlags(11));
+}
+}
@@ -0,0 +1,98 @@
+#include "ChunkedVector.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+using SmallPages = ChunkedVector<int, 4>;
+
+TEST(chunked_vector_test, test_construct) {
+  SmallPages values(10, 3);
+  EXPECT_EQ(10, values.size());
+  EXPECT_EQ(3, values.pageCount());
+  EXPECT_EQ(4, values.pageLength(0));
+  EXPECT_EQ(2, values.pageLength(2));
+  EXPECT_EQ(3, values[9]);
+
+  EXPECT_EQ(0, SmallPages().size());
+  EXPECT_EQ(0, SmallPages().pageCount());
+}
+
+TEST(chunked_vector_test, test_from_vector) {
+  std::vector<int> source(9);
+  std::iota(source.begin(), source.end(), 0);
+  SmallPages values(source);
+  EXPECT_EQ(9, values.size());
+  for (size_t i = 0; i < source.size(); ++i) {
+    EXPECT_EQ(source[i], values[i]);
+  }
+  EXPECT_EQ(source, values.toVector());
+  EXPECT_EQ(4, values.page(1)[0]);
+}
+
+TEST(chunked_vector_test, test_iterate) {
+  std::vector<int> source{1, 2, 3, 4, 5, 6};
+  SmallPages values(source);
+  EXPECT_EQ(21, std::accumulate(values.begin(), values.end(), 0));
+  EXPECT_EQ(6, std::distance(values.begin(), values.end()));
+}
+
+TEST(chunked_vector_test, test_random_access_iterator) {
+  std::vector<int> sorted(10);
+  std::iota(sorted.begin(), sorted.end(), 0);
+  const SmallPages values(sorted);
+
+  auto it = values.begin() + 5;
+  EXPECT_EQ(5, *it);
+  EXPECT_EQ(7, it[2]);
+  EXPECT_EQ(4, *(it - 1));
+  EXPECT_EQ(6, *(1 + it));
+  EXPECT_EQ(5, *it--);
+  EXPECT_EQ(3, *--it);
+  it -= 3;
+  EXPECT_TRUE(it == values.begin());
+  EXPECT_TRUE(it < values.end());
+  EXPECT_TRUE(values.end() > it);
+  EXPECT_TRUE(it <= values.begin());
+  EXPECT_TRUE(it >= values.begin());
+  EXPECT_EQ(10, std::distance(values.begin(), values.end()));
+
+  // Algorithms that need random access, across page boundaries
+  EXPECT_EQ(7, *std::lower_bound(values.begin(), values.end(), 7));
+  std::vector<int> reversed(values.size());
+  std::reverse_copy(values.begin(), values.end(), reversed.begin());
+  EXPECT_EQ(9, reversed.front());
+  EXPECT_EQ(0, reversed.back());
+}
+
+TEST(chunked_vector_test, test_write_copies_only_touched_page) {
+  SmallPages original(12, 0);
+  SmallPages copy = original;
+  for (size_t page = 0; page < copy.pageCount(); ++page) {
+    EXPECT_TRUE(copy.sharesPage(original, page));
+  }
+
+  copy[5] = 1;
+  EXPECT_EQ(1, copy[5]);
+  EXPECT_EQ(0, original[5]) << "Original should be unaffected by the write";
+  EXPECT_TRUE(copy.sharesPage(original, 0));
+  EXPECT_FALSE(copy.sharesPage(original, 1));
+  EXPECT_TRUE(copy.sharesPage(original, 2));
+
+  // Page is now unique, so further writes do not copy it again.
+  const int *page = copy.page(1);
+  copy[6] = 2;
+  EXPECT_EQ(page, copy.page(1));
+}
+
+TEST(chunked_vector_test, test_mutable_page) {
+  SmallPages original(8, 0);
+  SmallPages copy = original;
+  int *page = copy.mutablePage(1);
+  page[0] = 7;
+  EXPECT_EQ(7, copy[4]);
+  EXPECT_EQ(0, original[4]);
+  EXPECT_TRUE(copy.sharesPage(original, 0));
+}
+}
@@ -66,10 +66,10 @@ TEST(component_info_test, test_move) {
   using namespace testing;
 
   auto *instrumentTree = new testing::NiceMock<MockFlatTree>{};
-  // configure what the subTreIndexes call will do. i.e. point to the first
-  // component_id
-  EXPECT_CALL(*instrumentTree, subTreeIndexes(_))
-      .WillOnce(Return(std::vector<size_t>{0}));
+  // configure what the subTree call will do. i.e. just the first component,
+  // which is the first path component
+  EXPECT_CALL(*instrumentTree, subTree(_))
+      .WillOnce(Return(SubTree{{0, 1}, {0, 0}, {0, 1}, {0, 0}}));
 
   std::shared_ptr<NiceMockInstrumentTree> mockInstrumentTree(instrumentTree);
   auto componentInfo = ComponentInfoWithNiceMockInstrument{DetectorInfo<NiceMockInstrumentTree>(
@@ -89,15 +89,15 @@ TEST(component_info_test, test_single_rotation_around_component_origin) {
   using namespace testing;
 
   auto *instrumentTree = new NiceMockInstrumentTree{};
-  // configure what the subTreIndexes call will do. i.e. point to the first
-  // component_id
-  EXPECT_CALL(*instrumentTree, subTreeIndexes(_))
-      .WillRepeatedly(Return(std::vector<size_t>{0}));
+  // configure what the subTree call will do. i.e. just the first component,
+  // which is the first path component
+  EXPECT_CALL(*instrumentTree, subTree(_))
+      .WillRepeatedly(Return(SubTree{{0, 1}, {0, 0}, {0, 1}, {0, 0}}));
   EXPECT_CALL(*instrumentTree, startPositions())
-      .WillRepeatedly(
-          Return(std::vector<Eigen::Vector3d>{Eigen::Vector3d{0, 0, 0}}));
+      .WillRepeatedly(ReturnRefOfCopy(
+          std::vector<Eigen::Vector3d>{Eigen::Vector3d{0, 0, 0}}));
   EXPECT_CALL(*instrumentTree, startRotations())
-      .WillRepeatedly(Return(std::vector<Eigen::Quaterniond>{
+      .WillRepeatedly(ReturnRefOfCopy(std::vector<Eigen::Quaterniond>{
           Eigen::Quaterniond{Eigen::Affine3d::Identity().rotation()}}));
 
   std::shared_ptr<NiceMockInstrumentTree> mockInstrumentTree(instrumentTree);
@@ -138,14 +138,15 @@ TEST(component_info_test, test_multiple_rotation_around_component_origin) {
   const Eigen::Vector3d rotationCenter{0, 0, 0};
 
   auto *instrumentTree = new NiceMockInstrumentTree{};
-  // configure what the subTreIndexes call will do. i.e. point to the first
-  // component_id
-  EXPECT_CALL(*instrumentTree, subTreeIndexes(_))
-      .WillRepeatedly(Return(std::vector<size_t>{0}));
+  // configure what the subTree call will do. i.e. just the first component,
+  // which is the first path component
+  EXPECT_CALL(*instrumentTree, subTree(_))
+      .WillRepeatedly(Return(SubTree{{0, 1}, {0, 0}, {0, 1}, {0, 0}}));
   EXPECT_CALL(*instrumentTree, startPositions())
-      .WillRepeatedly(Return(std::vector<Eigen::Vector3d>{rotationCenter}));
+      .WillRepeatedly(
+          ReturnRefOfCopy(std::vector<Eigen::Vector3d>{rotationCenter}));
   EXPECT_CALL(*instrumentTree, startRotations())
-      .WillRepeatedly(Return(std::vector<Eigen::Quaterniond>{
+      .WillRepeatedly(ReturnRefOfCopy(std::vector<Eigen::Quaterniond>{
           Eigen::Quaterniond{Eigen::Affine3d::Identity().rotation()}}));
 
   std::shared_ptr<NiceMockInstrumentTree> mockInstrumentTree(instrumentTree);
@@ -188,14 +189,15 @@ TEST(component_info_test, test_single_rotation_around_arbitrary_center) {
   const Eigen::Vector3d componentCenter{1, 0, 0};
 
   auto *instrumentTree = new NiceMockInstrumentTree{};
-  // configure what the subTreIndexes call will do. i.e. point to the first
-  // component_id
-  EXPECT_CALL(*instrumentTree, subTreeIndexes(_))
-      .WillRepeatedly(Return(std::vector<size_t>{0}));
+  // configure what the subTree call will do. i.e. just the first component,
+  // which is the first path component
+  EXPECT_CALL(*instrumentTree, subTree(_))
+      .WillRepeatedly(Return(SubTree{{0, 1}, {0, 0}, {0, 1}, {0, 0}}));
   EXPECT_CALL(*instrumentTree, startPositions())
-      .WillRepeatedly(Return(std::vector<Eigen::Vector3d>{componentCenter}));
+      .WillRepeatedly(
+          ReturnRefOfCopy(std::vector<Eigen::Vector3d>{componentCenter}));
   EXPECT_CALL(*instrumentTree, startRotations())
-      .WillRepeatedly(Return(std::vector<Eigen::Quaterniond>{
+      .WillRepeatedly(ReturnRefOfCopy(std::vector<Eigen::Quaterniond>{
           Eigen::Quaterniond{Eigen::Affine3d::Identity().rotation()}}));
 
   std::shared_ptr<NiceMockInstrumentTree> mockInstrumentTree(instrumentTree);
@@ -229,14 +231,15 @@ TEST(component_info_test, test_multiple_rotation_arbitrary_center) {
   const Eigen::Vector3d componentCenter{1, 0, 0};
 
   auto *instrumentTree = new NiceMockInstrumentTree{};
-  // configure what the subTreIndexes call will do. i.e. point to the first
-  // component_id
-  EXPECT_CALL(*instrumentTree, subTreeIndexes(_))
-      .WillRepeatedly(Return(std::vector<size_t>{0}));
+  // configure what the subTree call will do. i.e. just the first component,
+  // which is the first path component
+  EXPECT_CALL(*instrumentTree, subTree(_))
+      .WillRepeatedly(Return(SubTree{{0, 1}, {0, 0}, {0, 1}, {0, 0}}));
   EXPECT_CALL(*instrumentTree, startPositions())
-      .WillRepeatedly(Return(std::vector<Eigen::Vector3d>{componentCenter}));
+      .WillRepeatedly(
+          ReturnRefOfCopy(std::vector<Eigen::Vector3d>{componentCenter}));
   EXPECT_CALL(*instrumentTree, startRotations())
-      .WillRepeatedly(Return(std::vector<Eigen::Quaterniond>{
+      .WillRepeatedly(ReturnRefOfCopy(std::vector<Eigen::Quaterniond>{
           Eigen::Quaterniond{Eigen::Affine3d::Identity().rotation()}}));
 
   std::shared_ptr<NiceMockInstrumentTree> mockInstrumentTree(instrumentTree);
@@ -289,4 +292,174 @@ TEST(component_info_test, test_position) {
   EXPECT_NE(posA, (posB + posC + posE + posD) / 4)
       << "Composites (posD) should not be factored in";
 }
+
+TEST(component_info_test, test_rotation_of_each_kind) {
+
+  auto detectorInfo = DetectorInfo<FlatTree>(makeInstrumentTree());
+
+  ComponentInfo<FlatTree> componentInfo(detectorInfo);
+  componentInfo.rotate(0, Eigen::Vector3d{0, 0, 1}, M_PI / 2,
+                       Eigen::Vector3d{0, 0, 0});
+
+  const Eigen::Quaterniond expected(
+      Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d{0, 0, 1}));
+  for (size_t i = 0; i < componentInfo.componentSize(); ++i) {
+    // Composites A and D, detector B, path components C and E
+    EXPECT_TRUE(componentInfo.rotation(i).isApprox(expected, 1e-14))
+        << "Rotation of component " << i;
+  }
+  EXPECT_TRUE(componentInfo.position(2).isApprox(Eigen::Vector3d(0, -1, 0),
+                                                 1e-14))
+      << "Source position";
+}
+
+TEST(component_info_test, test_move_sub_tree_only) {
+
+  auto detectorInfo = DetectorInfo<FlatTree>(makeInstrumentTree());
+
+  ComponentInfo<FlatTree> componentInfo(detectorInfo);
+  const auto before = componentInfo.position(1);
+  const auto sourceBefore = componentInfo.position(2);
+
+  const Eigen::Vector3d offset{0, 0, 1};
+  componentInfo.move(3, offset); // Composite D, containing the sample E
+
+  EXPECT_EQ(componentInfo.position(3), Eigen::Vector3d(0.1, 0, 1));
+  EXPECT_EQ(componentInfo.position(4), Eigen::Vector3d(0.1, 0, 1));
+  EXPECT_EQ(componentInfo.position(1), before) << "Detector B not below D";
+  EXPECT_EQ(componentInfo.position(2), sourceBefore) << "Source C not below D";
+  EXPECT_DOUBLE_EQ(componentInfo.detectorInfo().l2(0),
+                   (before - Eigen::Vector3d(0.1, 0, 1)).norm())
+      << "L2 should follow the moved sample";
+}
+
+TEST(component_info_test, test_edit_transaction) {
+
+  auto detectorInfo = DetectorInfo<FlatTree>(makeInstrumentTree());
+
+  ComponentInfo<FlatTree> componentInfo(detectorInfo);
+
+  const Eigen::Vector3d offset{1, 0, 0};
+  EditTransaction<ComponentInfo<FlatTree>> tx(componentInfo);
+  componentInfo.move(0, offset); // Whole instrument
+  componentInfo.rotate(3, Eigen::Vector3d{0, 0, 1}, M_PI,
+                       componentInfo.position(3)); // Composite D
+  componentInfo.move(1, offset); // Detector B
+  tx.commit();
+
+  EXPECT_EQ(Eigen::Vector3d(3, 1, 1), componentInfo.position(1));
+  EXPECT_EQ(Eigen::Vector3d(0, 0, 0), componentInfo.position(2));
+  EXPECT_TRUE(componentInfo.position(4).isApprox(Eigen::Vector3d(1.1, 0, 0),
+                                                 1e-14));
+}
+
+void expectBoundsOfLeaves(const ComponentInfo<FlatTree> &componentInfo,
+                          size_t assemblyIndex, size_t componentIndex) {
+  const auto &tree = componentInfo.const_instrumentTree();
+  const auto subTree = tree.subTree(componentIndex);
+  const auto &assemblyInfo = componentInfo.assemblyInfo();
+  const auto box = assemblyInfo.boundingBox(assemblyIndex);
+  Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+  size_t leaves = 0;
+  for (size_t i = subTree.components.begin; i < subTree.components.end; ++i) {
+    if (tree.proxyAt(i).hasChildren()) {
+      continue;
+    }
+    const auto position = componentInfo.position(i);
+    EXPECT_LT(box.exteriorDistance(position), 1e-12)
+        << "Component " << i << " outside assembly " << assemblyIndex;
+    sum += position;
+    ++leaves;
+  }
+  EXPECT_TRUE(assemblyInfo.centroid(assemblyIndex)
+                  .isApprox(sum / double(leaves), 1e-12))
+      << "Centroid of assembly " << assemblyIndex;
+}
+
+/// Instrument with a source, a sample and a flat 3 x 3 bank, pixel 4 in the
+/// middle. One pixel may be displaced from its place on the grid.
+std::shared_ptr<FlatTree> makeBankTree(size_t displacedPixel,
+                                       const Eigen::Vector3d &displacement) {
+  auto instrument = std::make_shared<CompositeComponent>(ComponentIdType(1));
+  instrument->addComponent(std::unique_ptr<PointSource>(
+      new PointSource(Eigen::Vector3d{0, 0, -10}, ComponentIdType(2))));
+  instrument->addComponent(std::unique_ptr<PointSample>(
+      new PointSample(Eigen::Vector3d{0, 0, 0}, ComponentIdType(3))));
+  auto bank = std::unique_ptr<CompositeComponent>(
+      new CompositeComponent(ComponentIdType(4)));
+  for (size_t pixel = 0; pixel < 9; ++pixel) {
+    Eigen::Vector3d position{double(pixel % 3), double(pixel / 3), 5};
+    if (pixel == displacedPixel) {
+      position += displacement;
+    }
+    bank->addComponent(std::unique_ptr<DetectorComponent>(
+        new DetectorComponent(ComponentIdType(5 + pixel),
+                              DetectorIdType(pixel), position)));
+  }
+  instrument->addComponent(std::move(bank));
+  return std::make_shared<FlatTree>(instrument);
+}
+
+/// Move one pixel, and compare against an instrument built with it moved
+void expectPixelMoveMatchesRebuild(size_t pixel,
+                                   const Eigen::Vector3d &offset) {
+  ComponentInfo<FlatTree> moved(
+      DetectorInfo<FlatTree>(makeBankTree(pixel, Eigen::Vector3d::Zero())));
+  ComponentInfo<FlatTree> rebuilt(
+      DetectorInfo<FlatTree>(makeBankTree(pixel, offset)));
+  const size_t pixelComponentIndex = 4 + pixel;
+  moved.move(pixelComponentIndex, offset);
+  ASSERT_TRUE(moved.position(pixelComponentIndex)
+                  .isApprox(rebuilt.position(pixelComponentIndex)));
+  for (size_t assemblyIndex = 0; assemblyIndex < 2; ++assemblyIndex) {
+    EXPECT_TRUE(moved.assemblyInfo()
+                    .boundingBox(assemblyIndex)
+                    .isApprox(rebuilt.assemblyInfo().boundingBox(
+                        assemblyIndex)))
+        << "Bounds of assembly " << assemblyIndex << " moving pixel " << pixel;
+    EXPECT_TRUE(moved.assemblyInfo()
+                    .centroid(assemblyIndex)
+                    .isApprox(rebuilt.assemblyInfo().centroid(assemblyIndex)))
+        << "Centroid of assembly " << assemblyIndex << " moving pixel "
+        << pixel;
+  }
+}
+
+TEST(component_info_test, test_assembly_bounds_after_pixel_move) {
+  // Bounds only grow, and are updated without a refit
+  expectPixelMoveMatchesRebuild(4, Eigen::Vector3d{0.5, -0.25, 0});
+  expectPixelMoveMatchesRebuild(4, Eigen::Vector3d{0, 3, 0});
+  expectPixelMoveMatchesRebuild(8, Eigen::Vector3d{1, 1, 0});
+  // Bounds may shrink
+  expectPixelMoveMatchesRebuild(8, Eigen::Vector3d{-1.5, -1.5, 0});
+  expectPixelMoveMatchesRebuild(0, Eigen::Vector3d{-1, 0, 2});
+  expectPixelMoveMatchesRebuild(4, Eigen::Vector3d{0, 0, 1});
+}
+
+TEST(component_info_test, test_assembly_bounds) {
+
+  auto detectorInfo = DetectorInfo<FlatTree>(makeInstrumentTree());
+
+  ComponentInfo<FlatTree> componentInfo(detectorInfo);
+  const auto &assemblyInfo = componentInfo.assemblyInfo();
+  EXPECT_TRUE(assemblyInfo.boundingBox(0).isApprox(Eigen::AlignedBox3d(
+      Eigen::Vector3d{-1, 0, 0}, Eigen::Vector3d{1, 1, 1})));
+  EXPECT_TRUE(assemblyInfo.centroid(0).isApprox(
+      Eigen::Vector3d{0.1 / 3, 1.0 / 3, 1.0 / 3}))
+      << "Mean of B, C and E, not of B, C and D";
+  expectBoundsOfLeaves(componentInfo, 1, 3);
+
+  componentInfo.move(1, Eigen::Vector3d{2, 0, 0}); // Detector B
+  EXPECT_TRUE(assemblyInfo.boundingBox(0).isApprox(Eigen::AlignedBox3d(
+      Eigen::Vector3d{-1, 0, 0}, Eigen::Vector3d{3, 1, 1})))
+      << "Root refitted about the moved detector";
+
+  componentInfo.move(3, Eigen::Vector3d{0, 0, -2}); // Composite D
+  componentInfo.rotate(3, Eigen::Vector3d{0, 1, 0}, M_PI / 3,
+                       Eigen::Vector3d{1, 1, 1});
+  componentInfo.rotate(0, Eigen::Vector3d{1, 1, 0}.normalized(), M_PI / 5,
+                       Eigen::Vector3d{0, 0, 0}); // Whole instrument
+  expectBoundsOfLeaves(componentInfo, 0, 0);
+  expectBoundsOfLeaves(componentInfo, 1, 3);
+}
 }
@@ -1,54 +1,73 @@
 #include "ComponentProxy.h"
 #include <gtest/gtest.h>
+#include <stdexcept>
+
+namespace {
+const std::vector<IndexType> noChildren;
+}
 
 TEST(component_proxy_test, test_root_construction) {
   ComponentIdType compId(1);
-  ComponentProxy proxy{compId};
+  ComponentProxy proxy{-1, noChildren, compId};
   EXPECT_FALSE(proxy.hasParent());
   EXPECT_FALSE(proxy.hasChildren());
 }
 
-TEST(component_proxy_test, test_add_leaf_constructor) {
+TEST(component_proxy_test, test_leaf_construction) {
   ComponentIdType compId(1);
-  ComponentProxy proxy{0, compId};
+  ComponentProxy proxy{0, noChildren, compId};
   EXPECT_TRUE(proxy.hasParent());
   EXPECT_FALSE(proxy.hasChildren());
   EXPECT_EQ(proxy.parent(), 0);
 }
 
-TEST(component_proxy_test, test_merge_trees_constructor) {
+TEST(component_proxy_test, test_children_view) {
   ComponentIdType compId(1);
-  ComponentProxy proxy{0, compId, std::vector<size_t>(1, 2)};
+  const std::vector<IndexType> children{2, 3};
+  ComponentProxy proxy{0, children, compId};
   EXPECT_TRUE(proxy.hasParent());
   EXPECT_TRUE(proxy.hasChildren());
-  EXPECT_EQ(std::vector<size_t>(1, 2), proxy.children());
+  EXPECT_EQ(proxy.nChildren(), 2);
+  EXPECT_EQ(proxy.child(1), 3);
+  EXPECT_EQ(children, proxy.children());
   EXPECT_EQ(proxy.parent(), 0);
 }
 
-TEST(component_proxy_test, test_add_children) {
-  ComponentIdType compId(1);
-  ComponentProxy proxy{compId};
-  proxy.addChild(1);
-  EXPECT_TRUE(proxy.hasChildren());
-  EXPECT_EQ(proxy.nChildren(), 1);
-  EXPECT_EQ(std::vector<size_t>(1, 1), proxy.children());
+TEST(component_proxy_test, test_make_child_indexes) {
+  /*
+      0
+      |
+    -----
+    |   |
+    1   3
+    |
+    2
+  */
+  std::vector<IndexType> childOffsets;
+  std::vector<IndexType> children;
+  makeChildIndexes({-1, 0, 1, 0}, childOffsets, children);
+  EXPECT_EQ((std::vector<IndexType>{0, 2, 3, 3, 3}), childOffsets);
+  EXPECT_EQ((std::vector<IndexType>{1, 3, 2}), children);
 }
 
 TEST(component_proxy_test, test_equals) {
   ComponentIdType idA(1);
   ComponentIdType idB(1);
+  const std::vector<IndexType> childrenA(2, 2);
+  const std::vector<IndexType> childrenB(2, 2);
 
-  ComponentProxy proxyA{0, idA, std::vector<size_t>(2, 2)};
-  ComponentProxy proxyB{0, idB, std::vector<size_t>(2, 2)};
+  ComponentProxy proxyA{0, childrenA, idA};
+  ComponentProxy proxyB{0, childrenB, idB};
 
-  EXPECT_EQ(proxyA, proxyB);
+  EXPECT_EQ(proxyA, proxyB) << "Children compared by value";
 }
 
 TEST(component_proxy_test, test_not_equals_when_components_not_equal) {
   ComponentIdType idA(1);
   ComponentIdType idB(2);
-  ComponentProxy proxyA{0, idA, std::vector<size_t>(2, 2)};
-  ComponentProxy proxyB{0, idB, std::vector<size_t>(2, 2)};
+  const std::vector<IndexType> children(2, 2);
+  ComponentProxy proxyA{0, children, idA};
+  ComponentProxy proxyB{0, children, idB};
 
   EXPECT_NE(proxyA, proxyB) << "Components not the same";
 }
@@ -57,9 +76,10 @@ TEST(component_proxy_test, test_not_equals_when_parents_not_equals) {
 
   ComponentIdType idA(1);
   ComponentIdType idB(1);
+  const std::vector<IndexType> children(2, 2);
 
-  ComponentProxy proxyA{10, idA, std::vector<size_t>(2, 2)};
-  ComponentProxy proxyB{0, idB, std::vector<size_t>(2, 2)};
+  ComponentProxy proxyA{10, children, idA};
+  ComponentProxy proxyB{0, children, idB};
 
   EXPECT_NE(proxyA, proxyB) << "Parent indexes not the same";
 }
@@ -67,9 +87,11 @@ TEST(component_proxy_test, test_not_equals_when_parents_not_equals) {
 TEST(component_proxy_test, test_not_equals_when_children_not_equals) {
   ComponentIdType idA(1);
   ComponentIdType idB(1);
+  const std::vector<IndexType> childrenA(2, 3);
+  const std::vector<IndexType> childrenB(2, 2);
 
-  ComponentProxy proxyA{0, idA, std::vector<size_t>(2, 3)};
-  ComponentProxy proxyB{0, idB, std::vector<size_t>(2, 2)};
+  ComponentProxy proxyA{0, childrenA, idA};
+  ComponentProxy proxyB{0, childrenB, idB};
 
   EXPECT_NE(proxyA, proxyB) << "Child indexes not the same";
 }
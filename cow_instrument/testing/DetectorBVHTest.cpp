@@ -0,0 +1,220 @@
+#include "ComponentInfo.h"
+#include "CompositeComponent.h"
+#include "DetectorBVH.h"
+#include "DetectorComponent.h"
+#include "DetectorInfo.h"
+#include "FlatTree.h"
+#include "PointSample.h"
+#include "PointSource.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <memory>
+
+namespace {
+
+const double radius = 0.05;
+
+std::unique_ptr<CompositeComponent> makeBank(size_t &nextId,
+                                             const Eigen::Vector3d &corner,
+                                             const Eigen::Vector3d &across,
+                                             const Eigen::Vector3d &up) {
+  std::unique_ptr<CompositeComponent> bank(
+      new CompositeComponent(ComponentIdType(nextId++)));
+  for (size_t i = 0; i < 10; ++i) {
+    for (size_t j = 0; j < 10; ++j) {
+      const Eigen::Vector3d position =
+          corner + 0.1 * double(i) * across + 0.1 * double(j) * up;
+      bank->addComponent(std::unique_ptr<DetectorComponent>(
+          new DetectorComponent(ComponentIdType(nextId),
+                                DetectorIdType(nextId), position)));
+      ++nextId;
+    }
+  }
+  return bank;
+}
+
+std::shared_ptr<FlatTree> makeInstrumentTree() {
+  /*
+   Root holding two 10 x 10 banks (one downstream, one to the side), a lone
+   detector, a source and a sample.
+   */
+  size_t nextId = 1;
+  auto root = std::make_shared<CompositeComponent>(ComponentIdType(nextId++));
+  root->addComponent(makeBank(nextId, Eigen::Vector3d{-0.5, -0.5, 5},
+                              Eigen::Vector3d{1, 0, 0},
+                              Eigen::Vector3d{0, 1, 0}));
+  root->addComponent(makeBank(nextId, Eigen::Vector3d{5, -0.5, -0.5},
+                              Eigen::Vector3d{0, 0, 1},
+                              Eigen::Vector3d{0, 1, 0}));
+  root->addComponent(std::unique_ptr<DetectorComponent>(
+      new DetectorComponent(ComponentIdType(nextId), DetectorIdType(nextId),
+                            Eigen::Vector3d{0, 3, 0})));
+  ++nextId;
+  root->addComponent(std::unique_ptr<PointSource>(
+      new PointSource(Eigen::Vector3d{0, 0, -10}, ComponentIdType(nextId++))));
+  root->addComponent(std::unique_ptr<PointSample>(
+      new PointSample(Eigen::Vector3d{0, 0, 0}, ComponentIdType(nextId++))));
+  return std::make_shared<FlatTree>(root);
+}
+
+size_t linearNearest(const DetectorInfo<FlatTree> &detectorInfo,
+                     const Eigen::Vector3d &point) {
+  size_t best = 0;
+  for (size_t i = 1; i < detectorInfo.detectorSize(); ++i) {
+    if ((detectorInfo.position(i) - point).norm() <
+        (detectorInfo.position(best) - point).norm()) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+std::vector<Eigen::Vector3d> samplePoints() {
+  std::vector<Eigen::Vector3d> points;
+  for (double x = -6; x <= 6; x += 1.5) {
+    for (double y = -2; y <= 4; y += 1.5) {
+      for (double z = -6; z <= 6; z += 1.5) {
+        points.emplace_back(x, y, z);
+      }
+    }
+  }
+  return points;
+}
+
+TEST(detector_bvh_test, test_nearest_matches_linear_scan) {
+  DetectorInfo<FlatTree> detectorInfo(makeInstrumentTree());
+  DetectorBVH<FlatTree> bvh(detectorInfo, radius);
+
+  EXPECT_GT(bvh.nodeCount(), 3) << "Banks should be split below the root";
+  for (const auto &point : samplePoints()) {
+    const size_t found = bvh.nearest(point);
+    const size_t expected = linearNearest(detectorInfo, point);
+    EXPECT_DOUBLE_EQ((detectorInfo.position(found) - point).norm(),
+                     (detectorInfo.position(expected) - point).norm());
+  }
+}
+
+TEST(detector_bvh_test, test_ray_hits_first_detector) {
+  DetectorInfo<FlatTree> detectorInfo(makeInstrumentTree());
+  DetectorBVH<FlatTree> bvh(detectorInfo, radius);
+
+  // From the sample to every detector, the first hit is that detector
+  const Eigen::Vector3d sample{0, 0, 0};
+  for (size_t i = 0; i < detectorInfo.detectorSize(); ++i) {
+    double distance;
+    const Eigen::Vector3d direction = detectorInfo.position(i) - sample;
+    EXPECT_EQ(i, bvh.intersect(sample, direction.normalized(), distance));
+    EXPECT_NEAR(direction.norm() - radius, distance, 1e-9);
+  }
+
+  double distance;
+  EXPECT_EQ(DetectorBVH<FlatTree>::npos,
+            bvh.intersect(sample, Eigen::Vector3d{0, -1, 0}, distance))
+      << "Nothing below the sample";
+}
+
+TEST(detector_bvh_test, test_box_and_cone_match_linear_scan) {
+  DetectorInfo<FlatTree> detectorInfo(makeInstrumentTree());
+  DetectorBVH<FlatTree> bvh(detectorInfo, radius);
+
+  const Eigen::AlignedBox3d box(Eigen::Vector3d{-0.25, -1, 4},
+                                Eigen::Vector3d{0.25, 0.15, 6});
+  const Eigen::Vector3d apex{0, 0, 0};
+  const Eigen::Vector3d axis{1, 0, 0.1};
+  const double halfAngle = 0.1;
+
+  std::vector<size_t> expectedBox;
+  std::vector<size_t> expectedCone;
+  for (size_t i = 0; i < detectorInfo.detectorSize(); ++i) {
+    const auto position = detectorInfo.position(i);
+    if (box.contains(position)) {
+      expectedBox.push_back(i);
+    }
+    if ((position - apex).normalized().dot(axis.normalized()) >=
+        std::cos(halfAngle)) {
+      expectedCone.push_back(i);
+    }
+  }
+  ASSERT_FALSE(expectedBox.empty());
+  ASSERT_FALSE(expectedCone.empty());
+
+  std::vector<size_t> inBox;
+  bvh.inBox(box, inBox);
+  std::sort(inBox.begin(), inBox.end());
+  EXPECT_EQ(expectedBox, inBox);
+
+  std::vector<size_t> inCone;
+  bvh.inCone(apex, axis, halfAngle, inCone);
+  std::sort(inCone.begin(), inCone.end());
+  EXPECT_EQ(expectedCone, inCone);
+}
+
+TEST(detector_bvh_test, test_refit_after_bank_rotation) {
+  auto instrument = makeInstrumentTree();
+  ComponentInfo<FlatTree> componentInfo{DetectorInfo<FlatTree>(instrument)};
+  DetectorBVH<FlatTree> bvh(componentInfo.detectorInfo(), radius);
+
+  // Swing the downstream bank (component 1) round to the other side
+  componentInfo.rotate(1, Eigen::Vector3d{0, 1, 0}, -M_PI / 2,
+                       Eigen::Vector3d{0, 0, 0});
+  bvh.refit(componentInfo.detectorInfo(), 1);
+
+  const auto &detectorInfo = componentInfo.detectorInfo();
+  for (const auto &point : samplePoints()) {
+    const size_t found = bvh.nearest(point);
+    const size_t expected = linearNearest(detectorInfo, point);
+    EXPECT_DOUBLE_EQ((detectorInfo.position(found) - point).norm(),
+                     (detectorInfo.position(expected) - point).norm());
+  }
+
+  // Lone detector moved on its own
+  const size_t lone = 200;
+  componentInfo.move(instrument->detIndexToCompIndex(lone),
+                     Eigen::Vector3d{0, 0, 2});
+  bvh.refit(componentInfo.detectorInfo(),
+            instrument->detIndexToCompIndex(lone));
+  EXPECT_EQ(lone, bvh.nearest(Eigen::Vector3d{0, 3, 2}));
+}
+
+TEST(detector_bvh_test, test_scanning_uses_first_time_index) {
+  // Two detectors either side of the sample, each scanning upwards
+  size_t nextId = 1;
+  auto root = std::make_shared<CompositeComponent>(ComponentIdType(nextId++));
+  for (double x : {1.0, -1.0}) {
+    root->addComponent(std::unique_ptr<DetectorComponent>(
+        new DetectorComponent(ComponentIdType(nextId), DetectorIdType(nextId),
+                              Eigen::Vector3d{x, 0, 0})));
+    ++nextId;
+  }
+  root->addComponent(std::unique_ptr<PointSource>(
+      new PointSource(Eigen::Vector3d{0, 0, -10}, ComponentIdType(nextId++))));
+  root->addComponent(std::unique_ptr<PointSample>(
+      new PointSample(Eigen::Vector3d{0, 0, 0}, ComponentIdType(nextId++))));
+
+  // Strided layout: detector i at time t is linear index i * 2 + t
+  const auto timeIndexes = std::vector<std::vector<size_t>>{{0, 1}, {2, 3}};
+  const auto scanTimes = ScanTimes{ScanTime(0, 10), ScanTime(10, 20)};
+  const std::vector<Eigen::Vector3d> positions{
+      {1, 0, 0}, {1, 0.5, 0}, {-1, 0, 0}, {-1, 0.5, 0}};
+  const std::vector<Eigen::Quaterniond> rotations(
+      4, Eigen::Quaterniond{Eigen::Affine3d::Identity().rotation()});
+  DetectorInfo<FlatTree> detectorInfo(std::make_shared<FlatTree>(root),
+                                      timeIndexes, scanTimes, positions,
+                                      rotations);
+
+  DetectorBVH<FlatTree> bvh(detectorInfo, radius);
+  EXPECT_EQ(0, bvh.nearest(Eigen::Vector3d{0.9, 0, 0}));
+  EXPECT_EQ(1, bvh.nearest(Eigen::Vector3d{-0.9, 0, 0}));
+  std::vector<size_t> found;
+  bvh.inBox(Eigen::AlignedBox3d(Eigen::Vector3d{-1.1, -0.1, -0.1},
+                                Eigen::Vector3d{-0.9, 0.1, 0.1}),
+            found);
+  EXPECT_EQ(std::vector<size_t>{1}, found);
+
+  bvh.refit(detectorInfo);
+  EXPECT_EQ(1, bvh.nearest(Eigen::Vector3d{-0.9, 0, 0})) << "After refit";
+  bvh.refit(detectorInfo, 0);
+  EXPECT_EQ(1, bvh.nearest(Eigen::Vector3d{-0.9, 0, 0}))
+      << "After refit of the root";
+}
+}
@@ -88,10 +88,9 @@ TEST(detector_component_test, test_register_contents) {
       << "Path indexes should NOT grow. These are detectors";
   EXPECT_EQ(info.detectorComponentIndexes().size(), 1)
       << "Detector indexes should grow";
-  EXPECT_EQ(info.proxies().size(), 1) << "Proxies should grow";
+  EXPECT_EQ(info.parents().size(), 1) << "Parents should grow";
 
-  EXPECT_FALSE(info.proxies()[0].hasParent());
-  EXPECT_FALSE(info.proxies()[0].hasChildren());
+  EXPECT_EQ(info.parents()[0], -1) << "Should have no parent";
   EXPECT_EQ(info.detectorComponentIndexes()[0], 0)
       << "Should be pointing to the zeroth index of proxies";
 }
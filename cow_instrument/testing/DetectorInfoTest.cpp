@@ -7,9 +7,11 @@
 #include "MockTypes.h"
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include <atomic>
 #include <map>
 #include <stdexcept>
 #include <memory>
+#include <thread>
 #include "IdType.h"
 #include "SourceSampleDetectorPathFactory.h"
 
@@ -22,7 +24,7 @@ TEST(detector_info_test, test_construct) {
   EXPECT_CALL(*pMockInstrumentTree, nDetectors())
       .WillRepeatedly(testing::Return(1));
   EXPECT_CALL(*pMockInstrumentTree, detectorComponentIndexes())
-      .WillRepeatedly(testing::Return(std::vector<size_t>(1, 0)));
+      .WillRepeatedly(testing::ReturnRefOfCopy(std::vector<IndexType>(1, 0)));
 
   std::shared_ptr<MockFlatTree> mockInstrumentTree{pMockInstrumentTree};
 
@@ -51,7 +53,7 @@ TEST(detector_info_test, test_construct_with_bad_l2_paths_throws) {
   EXPECT_CALL(*pMockInstrumentTree, nDetectors())
       .WillRepeatedly(testing::Return(nDetectors));
   EXPECT_CALL(*pMockInstrumentTree, detectorComponentIndexes())
-      .WillRepeatedly(testing::Return(std::vector<size_t>(1, 0)));
+      .WillRepeatedly(testing::ReturnRefOfCopy(std::vector<IndexType>(1, 0)));
 
   std::shared_ptr<MockFlatTree> mockInstrumentTree{pMockInstrumentTree};
 
@@ -118,6 +120,81 @@ TEST(detector_info_test, test_masking) {
   EXPECT_THROW(detectorInfo.isMasked(nDetectors), std::out_of_range);
 }
 
+TEST(detector_info_test, test_bulk_masking) {
+
+  size_t nDetectors = 100;
+
+  MockPathFactory mockPathFactory;
+  EXPECT_CALL(mockPathFactory, createL1(testing::_))
+      .WillOnce(testing::Return(new Paths(nDetectors, Path{0, 0})));
+  EXPECT_CALL(mockPathFactory, createL2(testing::_))
+      .WillOnce(testing::Return(new Paths(nDetectors, Path{0})));
+
+  DetectorInfoWithNiceMockInstrument detectorInfo(
+      std::make_shared<testing::NiceMock<MockFlatTree>>(nDetectors),
+      mockPathFactory);
+
+  detectorInfo.setMaskedRange(10, 80);
+  EXPECT_EQ(70, detectorInfo.maskedCount());
+  EXPECT_FALSE(detectorInfo.isMasked(9));
+  EXPECT_TRUE(detectorInfo.isMasked(10));
+  EXPECT_TRUE(detectorInfo.isMasked(79));
+  EXPECT_FALSE(detectorInfo.isMasked(80));
+
+  detectorInfo.setMasked(std::vector<size_t>{0, 10, 99});
+  EXPECT_EQ(72, detectorInfo.maskedCount());
+
+  EXPECT_THROW(detectorInfo.setMasked(std::vector<size_t>{1, nDetectors}),
+               std::out_of_range);
+  EXPECT_FALSE(detectorInfo.isMasked(1))
+      << "Nothing should be masked if any index is out of range";
+  EXPECT_THROW(detectorInfo.setMaskedRange(0, nDetectors + 1),
+               std::out_of_range);
+
+  MaskFlags mask(nDetectors);
+  mask.setRange(50, nDetectors);
+  auto copy = detectorInfo;
+  detectorInfo.intersectMask(mask);
+  EXPECT_EQ(31, detectorInfo.maskedCount());
+  EXPECT_EQ(72, copy.maskedCount()) << "Copies should not share writes";
+
+  detectorInfo.unionMask(mask);
+  EXPECT_EQ(50, detectorInfo.maskedCount());
+  EXPECT_THROW(detectorInfo.unionMask(MaskFlags(nDetectors + 1)),
+               std::invalid_argument);
+}
+
+TEST(detector_info_test, test_copy_shares_unwritten_pages) {
+
+  size_t nDetectors = 3 * L2s::pageSize;
+
+  MockPathFactory mockPathFactory;
+  EXPECT_CALL(mockPathFactory, createL1(testing::_))
+      .WillOnce(testing::Return(new Paths(nDetectors, Path{0, 0})));
+  EXPECT_CALL(mockPathFactory, createL2(testing::_))
+      .WillOnce(testing::Return(new Paths(nDetectors, Path{0})));
+
+  DetectorInfoWithNiceMockInstrument original(
+      std::make_shared<testing::NiceMock<MockFlatTree>>(nDetectors),
+      mockPathFactory);
+  auto copy = original;
+
+  const size_t moved = L2s::pageSize + 1;
+  copy.rotateDetector(moved, Eigen::Vector3d{0, 0, 1}, M_PI / 2,
+                      Eigen::Vector3d{1, 0, 0});
+  EXPECT_DOUBLE_EQ(0, original.l2(moved));
+  EXPECT_DOUBLE_EQ(std::sqrt(2), copy.l2(moved));
+
+  const L2s &originalL2s = original.l2s().const_ref();
+  const L2s &copyL2s = copy.l2s().const_ref();
+  EXPECT_TRUE(copyL2s.sharesPage(originalL2s, 0));
+  EXPECT_FALSE(copyL2s.sharesPage(originalL2s, 1));
+  EXPECT_TRUE(copyL2s.sharesPage(originalL2s, 2));
+
+  EXPECT_TRUE(copy.rotations().sharesPage(original.rotations(), 0));
+  EXPECT_FALSE(copy.rotations().sharesPage(original.rotations(), 1));
+}
+
 TEST(detector_info_test, test_get_l2s) {
 
   size_t nDetectors = 3;
@@ -191,16 +268,16 @@ TEST(detector_info_test, test_calculate_l2) {
     Single detector at x=40
   */
   EXPECT_CALL(*pMockInstrumentTree, pathLengths())
-      .WillRepeatedly(Return(std::vector<double>(2, 0)));
+      .WillRepeatedly(ReturnRefOfCopy(std::vector<double>(2, 0)));
   EXPECT_CALL(*pMockInstrumentTree, startPositions())
-      .WillRepeatedly(Return(
+      .WillRepeatedly(ReturnRefOfCopy(
           std::vector<Eigen::Vector3d>{{0, 0, 0}, {0, 0, 20}, {0, 0, 40}}));
   EXPECT_CALL(*pMockInstrumentTree, startEntryPoints())
       .WillRepeatedly(
-          Return(std::vector<Eigen::Vector3d>{{0, 0, 0}, {0, 0, 20}}));
+          ReturnRefOfCopy(std::vector<Eigen::Vector3d>{{0, 0, 0}, {0, 0, 20}}));
   EXPECT_CALL(*pMockInstrumentTree, startExitPoints())
       .WillRepeatedly(
-          Return(std::vector<Eigen::Vector3d>{{0, 0, 0}, {0, 0, 20}}));
+          ReturnRefOfCopy(std::vector<Eigen::Vector3d>{{0, 0, 0}, {0, 0, 20}}));
   EXPECT_CALL(*pMockInstrumentTree, sourcePathIndex())
       .WillRepeatedly(Return(0));
   EXPECT_CALL(*pMockInstrumentTree, samplePathIndex())
@@ -229,9 +306,14 @@ TEST(detector_info_test, test_calculate_l1) {
     Source at x=0
     Sample at x = 20
   */
-  EXPECT_CALL(*pMockInstrumentTree, pathLengths()).WillRepeatedly(Return(std::vector<double>(2,0)));
-  EXPECT_CALL(*pMockInstrumentTree, startEntryPoints()).WillRepeatedly(Return(std::vector<Eigen::Vector3d>{{0,0,3}, {0,0,5}}));
-  EXPECT_CALL(*pMockInstrumentTree, startExitPoints()).WillRepeatedly(Return(std::vector<Eigen::Vector3d>{{0,0,3}, {0,0,5}}));
+  EXPECT_CALL(*pMockInstrumentTree, pathLengths())
+      .WillRepeatedly(ReturnRefOfCopy(std::vector<double>(2, 0)));
+  EXPECT_CALL(*pMockInstrumentTree, startEntryPoints())
+      .WillRepeatedly(ReturnRefOfCopy(
+          std::vector<Eigen::Vector3d>{{0, 0, 3}, {0, 0, 5}}));
+  EXPECT_CALL(*pMockInstrumentTree, startExitPoints())
+      .WillRepeatedly(ReturnRefOfCopy(
+          std::vector<Eigen::Vector3d>{{0, 0, 3}, {0, 0, 5}}));
   EXPECT_CALL(*pMockInstrumentTree, sourcePathIndex())
       .WillRepeatedly(testing::Return(0));
   EXPECT_CALL(*pMockInstrumentTree, samplePathIndex())
@@ -252,7 +334,7 @@ TEST(detector_info_test, test_copy) {
   EXPECT_CALL(*pMockInstrumentTree, nDetectors())
       .WillRepeatedly(testing::Return(2));
   EXPECT_CALL(*pMockInstrumentTree, detectorComponentIndexes())
-      .WillRepeatedly(testing::Return(std::vector<size_t>{1, 2}));
+      .WillRepeatedly(testing::ReturnRefOfCopy(std::vector<IndexType>{1, 2}));
 
   DetectorInfoWithMockInstrument original{
       std::shared_ptr<MockFlatTree>(pMockInstrumentTree),
@@ -430,4 +512,524 @@ TEST(detector_info_test, test_move_scan_position) {
   Eigen::Vector3d actual = detectorInfo.position(1, 1);
   EXPECT_EQ(actual, expected);
 }
+
+TEST(detector_info_test, test_move_detector_updates_only_its_l2) {
+
+  // Source at -1, 0, 0
+  // Sample at 0.1, 0, 0
+  // Detectors B and C both at 1, 1, 1
+  DetectorInfo<FlatTree> detectorInfo(
+      makeInstrumentTree(), SourceSampleDetectorPathFactory<FlatTree>{});
+
+  const double l2Before = detectorInfo.l2(1);
+
+  Eigen::Vector3d offset{1, 0, 0};
+  detectorInfo.moveDetector(0, offset);
+
+  const Eigen::Vector3d samplePos{0.1, 0, 0};
+  EXPECT_DOUBLE_EQ((detectorInfo.position(0) - samplePos).norm(),
+                   detectorInfo.l2(0))
+      << "L2 of moved detector should be updated";
+  EXPECT_EQ(l2Before, detectorInfo.l2(1))
+      << "L2 of detector not moved should be unchanged";
+
+  detectorInfo.rotateDetector(1, Eigen::Vector3d{0, 0, 1}, M_PI / 2,
+                              Eigen::Vector3d{0, 0, 0});
+  EXPECT_DOUBLE_EQ((detectorInfo.position(1) - samplePos).norm(),
+                   detectorInfo.l2(1))
+      << "L2 of rotated detector should be updated";
+}
+
+TEST(detector_info_test, test_move_scan_position_updates_l2) {
+
+  auto scanTimes = ScanTimes{ScanTime(0, 10), ScanTime(10, 20)}; // 2 scan times
+
+  auto timeIndexes = std::vector<std::vector<size_t>>{{0, 2}, {1, 3}};
+
+  auto positions = std::vector<Eigen::Vector3d>(4);
+  positions[0] = Eigen::Vector3d{1, 0, 0}; // Detector B time 0
+  positions[1] = Eigen::Vector3d{2, 0, 0}; // Detector C time 0
+  positions[2] = Eigen::Vector3d{3, 0, 0}; // Detector B time 1
+  positions[3] = Eigen::Vector3d{4, 0, 0}; // Detector C time 1
+
+  auto rotations = std::vector<Eigen::Quaterniond>(
+      4, Eigen::Quaterniond{Eigen::Affine3d::Identity().rotation()});
+
+  // Sample at 0.1, 0, 0
+  DetectorInfo<FlatTree> detectorInfo(makeInstrumentTree(), timeIndexes,
+                                      scanTimes, positions, rotations);
+
+  detectorInfo.moveDetector(1, 1, Eigen::Vector3d{1, 0, 0});
+
+  EXPECT_DOUBLE_EQ(4.9, detectorInfo.l2(1, 1)) << "Moved scan point";
+  EXPECT_DOUBLE_EQ(1.9, detectorInfo.l2(1, 0)) << "Other scan point unchanged";
+  EXPECT_DOUBLE_EQ(0.9, detectorInfo.l2(0, 0)) << "Other detector unchanged";
+  EXPECT_DOUBLE_EQ(2.9, detectorInfo.l2(0, 1)) << "Other detector unchanged";
+}
+
+TEST(detector_info_test, test_edit_transaction_recalculates_at_commit) {
+
+  // Source at -1, 0, 0
+  // Sample at 0.1, 0, 0
+  // Detectors B and C both at 1, 1, 1
+  DetectorInfo<FlatTree> detectorInfo(
+      makeInstrumentTree(), SourceSampleDetectorPathFactory<FlatTree>{});
+  const auto &pathInfo = detectorInfo.pathComponentInfo();
+  const size_t sampleIndex =
+      detectorInfo.const_instrumentTree().samplePathIndex();
+
+  EditTransaction<DetectorInfo<FlatTree>> tx(detectorInfo);
+  EXPECT_TRUE(tx.isOpen());
+  detectorInfo.moveDetector(0, Eigen::Vector3d{1, 0, 0});
+  detectorInfo.movePathComponents({sampleIndex}, Eigen::Vector3d{-0.1, 0, 0});
+  detectorInfo.moveDetector(1, Eigen::Vector3d{0, 1, 0});
+  tx.commit();
+  EXPECT_FALSE(tx.isOpen());
+
+  const Eigen::Vector3d samplePos = pathInfo.position(sampleIndex);
+  EXPECT_EQ(Eigen::Vector3d(0, 0, 0), samplePos);
+  EXPECT_DOUBLE_EQ(1, detectorInfo.l1(0));
+  EXPECT_DOUBLE_EQ((detectorInfo.position(0) - samplePos).norm(),
+                   detectorInfo.l2(0));
+  EXPECT_DOUBLE_EQ((detectorInfo.position(1) - samplePos).norm(),
+                   detectorInfo.l2(1));
+}
+
+TEST(detector_info_test, test_reads_in_transaction_follow_sample_move) {
+
+  // Source at -1, 0, 0
+  // Sample at 0.1, 0, 0, moved to 0.1, 1, 1 in line with detector B
+  // Detector B at 1, 1, 1
+  const Eigen::Vector3d beam{1.1, 1, 1};
+  const Eigen::Vector3d scattered{0.9, 0, 0};
+  const double twoTheta =
+      std::acos(beam.normalized().dot(scattered.normalized()));
+  for (bool cacheAngles : {false, true}) {
+    SCOPED_TRACE(cacheAngles ? "Cached angles" : "Uncached angles");
+    DetectorInfo<FlatTree> detectorInfo(
+        makeInstrumentTree(), SourceSampleDetectorPathFactory<FlatTree>{});
+    if (cacheAngles) {
+      detectorInfo.cacheScatteringAngles();
+    }
+    const size_t sampleIndex =
+        detectorInfo.const_instrumentTree().samplePathIndex();
+
+    EditTransaction<DetectorInfo<FlatTree>> tx(detectorInfo);
+    detectorInfo.movePathComponents({sampleIndex}, Eigen::Vector3d{0, 1, 1});
+    EXPECT_NEAR(twoTheta, detectorInfo.twoTheta(0), 1e-12)
+        << "Beam frame and scattering point follow the sample";
+    EXPECT_DOUBLE_EQ(scattered.norm(), detectorInfo.l2(0));
+    EXPECT_DOUBLE_EQ(beam.norm(), detectorInfo.l1(0));
+    tx.commit();
+
+    EXPECT_NEAR(twoTheta, detectorInfo.twoTheta(0), 1e-12);
+    EXPECT_DOUBLE_EQ(scattered.norm(), detectorInfo.l2(0));
+  }
+}
+
+TEST(detector_info_test, test_l1_l2_current_after_edits) {
+
+  DetectorInfo<FlatTree> detectorInfo(
+      makeInstrumentTree(), SourceSampleDetectorPathFactory<FlatTree>{});
+  const auto &pathInfo = detectorInfo.pathComponentInfo();
+  const size_t sampleIndex =
+      detectorInfo.const_instrumentTree().samplePathIndex();
+
+  // No transaction, values recalculated by the next read
+  detectorInfo.moveDetector(0, Eigen::Vector3d{1, 0, 0});
+  detectorInfo.moveDetector(0, Eigen::Vector3d{1, 0, 0});
+  Eigen::Vector3d samplePos = pathInfo.position(sampleIndex);
+  EXPECT_DOUBLE_EQ((detectorInfo.position(0) - samplePos).norm(),
+                   detectorInfo.l2(0));
+
+  detectorInfo.movePathComponents({sampleIndex}, Eigen::Vector3d{-0.1, 0, 0});
+  samplePos = pathInfo.position(sampleIndex);
+  EXPECT_DOUBLE_EQ(1, detectorInfo.l1(0));
+  auto l2s = detectorInfo.l2s();
+  EXPECT_DOUBLE_EQ((detectorInfo.position(0) - samplePos).norm(), (*l2s)[0]);
+  EXPECT_DOUBLE_EQ((detectorInfo.position(1) - samplePos).norm(), (*l2s)[1]);
+
+  // A copy is independent of the original
+  const double oldL2 = (*l2s)[1];
+  detectorInfo.moveDetector(1, Eigen::Vector3d{0, 1, 0});
+  const DetectorInfo<FlatTree> copy(detectorInfo);
+  EXPECT_DOUBLE_EQ((copy.position(1) - samplePos).norm(), copy.l2(1));
+  EXPECT_DOUBLE_EQ((detectorInfo.position(1) - samplePos).norm(),
+                   detectorInfo.l2(1));
+  // Previously returned L2s are unaffected
+  EXPECT_DOUBLE_EQ(oldL2, (*l2s)[1]);
+}
+
+namespace {
+/// AoSPositions counting the detector distances evaluated for L2
+class CountingPositions : public AoSPositions {
+public:
+  using AoSPositions::AoSPositions;
+  double distance(size_t index, const Eigen::Vector3d &point) const {
+    ++evaluations;
+    return AoSPositions::distance(index, point);
+  }
+  void offsetDistances(const Eigen::Vector3d &point, double offset,
+                       size_t begin, size_t end, double *out) const {
+    evaluations += end - begin;
+    AoSPositions::offsetDistances(point, offset, begin, end, out);
+  }
+  static std::atomic<size_t> evaluations;
+};
+std::atomic<size_t> CountingPositions::evaluations{0};
+}
+
+TEST(detector_info_test, test_writes_defer_l2_to_the_next_read) {
+
+  DetectorInfo<FlatTree, CountingPositions> detectorInfo(
+      makeInstrumentTree(), SourceSampleDetectorPathFactory<FlatTree>{});
+  const Eigen::Vector3d samplePos{0.1, 0, 0};
+
+  CountingPositions::evaluations = 0;
+  const size_t nWrites = 1000;
+  for (size_t i = 0; i < nWrites; ++i) {
+    detectorInfo.moveDetector(0, Eigen::Vector3d{0.001, 0, 0});
+  }
+  EXPECT_EQ(0u, CountingPositions::evaluations) << "Writes recalculate nothing";
+
+  // Concurrent first reads, only one of which recalculates
+  std::vector<double> l2s(4);
+  std::vector<std::thread> readers;
+  for (size_t i = 0; i < l2s.size(); ++i) {
+    readers.emplace_back([&, i]() { l2s[i] = detectorInfo.l2(0); });
+  }
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  const double expected = (detectorInfo.position(0) - samplePos).norm();
+  for (auto l2 : l2s) {
+    EXPECT_DOUBLE_EQ(expected, l2);
+  }
+  const size_t evaluations = CountingPositions::evaluations;
+  EXPECT_GE(evaluations, 1u);
+  EXPECT_LE(evaluations, detectorInfo.detectorSize())
+      << "At most one pass over the detectors for all writes and reads";
+
+  detectorInfo.l2(1);
+  detectorInfo.l2s();
+  EXPECT_EQ(evaluations, CountingPositions::evaluations)
+      << "Clean reads recalculate nothing";
+}
+
+TEST(detector_info_test, test_edit_transaction_commits_on_destruction) {
+
+  DetectorInfo<FlatTree> detectorInfo(
+      makeInstrumentTree(), SourceSampleDetectorPathFactory<FlatTree>{});
+  {
+    EditTransaction<DetectorInfo<FlatTree>> outer(detectorInfo);
+    {
+      // Nested transactions defer to the outermost one
+      EditTransaction<DetectorInfo<FlatTree>> inner(detectorInfo);
+      detectorInfo.moveDetector(0, Eigen::Vector3d{1, 0, 0});
+    }
+    detectorInfo.moveDetector(0, Eigen::Vector3d{1, 0, 0});
+  }
+  const Eigen::Vector3d samplePos{0.1, 0, 0};
+  EXPECT_EQ(Eigen::Vector3d(3, 1, 1), detectorInfo.position(0));
+  EXPECT_DOUBLE_EQ((detectorInfo.position(0) - samplePos).norm(),
+                   detectorInfo.l2(0));
+}
+
+namespace {
+/// Info whose commit always fails
+struct FailingCommitInfo {
+  void openEdit() { ++depth; }
+  void commitEdit() {
+    --depth;
+    throw std::runtime_error("commit failed");
+  }
+  int depth = 0;
+};
+}
+
+TEST(detector_info_test, test_edit_transaction_commit_failure) {
+
+  FailingCommitInfo info;
+  {
+    EditTransaction<FailingCommitInfo> tx(info);
+    EXPECT_EQ(1, info.depth);
+    EXPECT_THROW(tx.commit(), std::runtime_error);
+    EXPECT_FALSE(tx.isOpen()) << "Edit closed despite the failure";
+  }
+  EXPECT_EQ(0, info.depth);
+  EXPECT_NO_THROW({ EditTransaction<FailingCommitInfo> tx(info); })
+      << "Uncommitted transaction must not throw from its destructor";
+  EXPECT_EQ(0, info.depth);
+}
+
+TEST(detector_info_test, test_soa_positions_match_aos) {
+
+  DetectorInfo<FlatTree> aos(makeInstrumentTree(),
+                             SourceSampleDetectorPathFactory<FlatTree>{});
+  DetectorInfo<FlatTree, SoAPositions> soa(
+      makeInstrumentTree(), SourceSampleDetectorPathFactory<FlatTree>{});
+
+  const Eigen::Vector3d axis{0, 0, 1};
+  const Eigen::Vector3d center{0, 0, 0};
+  aos.moveDetectors({0, 1}, Eigen::Vector3d{1, 0, 0});
+  soa.moveDetectors({0, 1}, Eigen::Vector3d{1, 0, 0});
+  aos.rotateDetectors({1}, axis, M_PI / 2, center);
+  soa.rotateDetectors({1}, axis, M_PI / 2, center);
+
+  for (size_t i = 0; i < aos.detectorSize(); ++i) {
+    EXPECT_TRUE(aos.position(i).isApprox(soa.position(i), 1e-12));
+    EXPECT_DOUBLE_EQ(aos.l2(i), soa.l2(i));
+    EXPECT_DOUBLE_EQ(aos.l1(i), soa.l1(i));
+  }
+  EXPECT_EQ(Eigen::Vector3d(2, 1, 1),
+            Eigen::Vector3d(soa.const_positions().map().row(0)));
+}
+
+TEST(detector_info_test, test_threaded_l1_l2_match_serial) {
+
+  // Enough scan points for the linear indexes to be split across threads
+  const size_t scanCount = 5 * parallelGrainSize + 3;
+  auto scanTimes = ScanTimes(scanCount);
+  auto timeIndexes = std::vector<std::vector<size_t>>(2);
+  auto positions = std::vector<Eigen::Vector3d>(2 * scanCount);
+  for (size_t i = 0; i < positions.size(); ++i) {
+    timeIndexes[i % 2].push_back(i);
+    positions[i] = Eigen::Vector3d{1 + 0.001 * double(i), 0.5, -0.25};
+  }
+  auto rotations = std::vector<Eigen::Quaterniond>(
+      positions.size(),
+      Eigen::Quaterniond{Eigen::Affine3d::Identity().rotation()});
+
+  setParallelThreadCount(1);
+  DetectorInfo<FlatTree> serial(makeInstrumentTree(), timeIndexes, scanTimes,
+                                positions, rotations);
+  setParallelThreadCount(4);
+  DetectorInfo<FlatTree> threaded(makeInstrumentTree(), timeIndexes,
+                                  scanTimes, positions, rotations);
+  setParallelThreadCount(0);
+
+  // Bit-identical, not just close
+  for (size_t detectorIndex = 0; detectorIndex < 2; ++detectorIndex) {
+    EXPECT_EQ(serial.l1(detectorIndex), threaded.l1(detectorIndex));
+    for (size_t timeIndex = 0; timeIndex < scanCount; ++timeIndex) {
+      EXPECT_EQ(serial.l2(detectorIndex, timeIndex),
+                threaded.l2(detectorIndex, timeIndex));
+    }
+  }
+}
+
+/// Gives detector 1 an L2 path that doubles back through the source
+struct DistinctL2PathFactory {
+  Paths *createL2(const FlatTree &instrument) const {
+    const size_t source = instrument.sourcePathIndex();
+    const size_t sample = instrument.samplePathIndex();
+    return new Paths(std::vector<Path>{Path{sample}, Path{source, sample}});
+  }
+  Paths *createL1(const FlatTree &instrument) const {
+    return SourceSampleDetectorPathFactory<FlatTree>{}.createL1(instrument);
+  }
+};
+
+TEST(detector_info_test, test_l2_with_distinct_paths) {
+
+  DetectorInfo<FlatTree> detectorInfo(makeInstrumentTree(),
+                                      DistinctL2PathFactory{});
+
+  // Source at -1, 0, 0. Sample at 0.1, 0, 0. Both detectors at 1, 1, 1.
+  const double sampleToDetector =
+      (Eigen::Vector3d{1, 1, 1} - Eigen::Vector3d{0.1, 0, 0}).norm();
+  EXPECT_DOUBLE_EQ(sampleToDetector, detectorInfo.l2(0));
+  EXPECT_DOUBLE_EQ(1.1 + sampleToDetector, detectorInfo.l2(1));
+
+  // Single-detector updates use the cached path lengths
+  detectorInfo.moveDetector(1, Eigen::Vector3d{-0.9, -1, -1});
+  EXPECT_DOUBLE_EQ(1.1, detectorInfo.l2(1));
+}
+
+/// Gives detector 1 an L1 path that passes the sample twice
+struct DistinctL1PathFactory {
+  Paths *createL2(const FlatTree &instrument) const {
+    return SourceSampleDetectorPathFactory<FlatTree>{}.createL2(instrument);
+  }
+  Paths *createL1(const FlatTree &instrument) const {
+    const size_t source = instrument.sourcePathIndex();
+    const size_t sample = instrument.samplePathIndex();
+    return new Paths(std::vector<Path>{Path{source, sample},
+                                       Path{source, sample, source, sample}});
+  }
+};
+
+TEST(detector_info_test, test_l1_with_distinct_paths) {
+
+  auto instrument = makeInstrumentTree();
+  DetectorInfo<FlatTree> detectorInfo(instrument, DistinctL1PathFactory{});
+
+  // Source at -1, 0, 0. Sample at 0.1, 0, 0.
+  EXPECT_DOUBLE_EQ(1.1, detectorInfo.l1(0));
+  EXPECT_DOUBLE_EQ(3.3, detectorInfo.l1(1));
+
+  // Moving the source re-evaluates both unique paths
+  detectorInfo.movePathComponents({instrument->sourcePathIndex()},
+                                  Eigen::Vector3d{-1, 0, 0});
+  EXPECT_DOUBLE_EQ(2.1, detectorInfo.l1(0));
+  EXPECT_DOUBLE_EQ(6.3, detectorInfo.l1(1));
+  EXPECT_THROW(detectorInfo.l1(2), std::out_of_range);
+}
+
+TEST(detector_info_test, test_bulk_views) {
+
+  DetectorInfo<FlatTree> detectorInfo(
+      makeInstrumentTree(), SourceSampleDetectorPathFactory<FlatTree>{});
+  detectorInfo.setMasked(1);
+  detectorInfo.moveDetector(0, Eigen::Vector3d{1, 0, 0});
+
+  const auto positions = detectorInfo.positions();
+  EXPECT_EQ(2, positions.cols());
+  EXPECT_EQ(detectorInfo.position(0), Eigen::Vector3d(positions.col(0)));
+  EXPECT_EQ(detectorInfo.position(1), Eigen::Vector3d(positions.col(1)));
+
+  const auto &rotations = detectorInfo.rotations();
+  EXPECT_EQ(2, rotations.size());
+  EXPECT_TRUE(rotations[1].isApprox(detectorInfo.rotation(1)));
+
+  const auto &maskFlags = detectorInfo.maskFlags();
+  EXPECT_FALSE(maskFlags[0]);
+  EXPECT_TRUE(maskFlags[1]);
+  EXPECT_EQ(2, detectorInfo.monitorFlags().size());
+
+  const auto l1s = detectorInfo.l1s();
+  const auto l1PathIds = detectorInfo.l1PathIds();
+  EXPECT_EQ(2, l1PathIds.size());
+  for (size_t i = 0; i < l1PathIds.size(); ++i) {
+    EXPECT_EQ(detectorInfo.l1(i), l1s[l1PathIds[i]]);
+  }
+}
+
+TEST(detector_info_test, test_scan_positions) {
+
+  auto scanTimes = ScanTimes{ScanTime(0, 10), ScanTime(10, 20)};
+  auto timeIndexes = std::vector<std::vector<size_t>>{{0, 1}, {2, 3}};
+  auto positions = std::vector<Eigen::Vector3d>{
+      {1, 0, 0}, {2, 0, 0}, {3, 0, 0}, {4, 0, 0}};
+  auto rotations = std::vector<Eigen::Quaterniond>(
+      4, Eigen::Quaterniond{Eigen::Affine3d::Identity().rotation()});
+
+  DetectorInfo<FlatTree> aos(makeInstrumentTree(), timeIndexes, scanTimes,
+                             positions, rotations);
+  DetectorInfo<FlatTree, SoAPositions> soa(makeInstrumentTree(), timeIndexes,
+                                           scanTimes, positions, rotations);
+
+  const auto aosAtTime1 = aos.scanPositions(1);
+  EXPECT_EQ(2, aosAtTime1.cols());
+  EXPECT_EQ(Eigen::Vector3d(2, 0, 0), Eigen::Vector3d(aosAtTime1.col(0)));
+  EXPECT_EQ(Eigen::Vector3d(4, 0, 0), Eigen::Vector3d(aosAtTime1.col(1)));
+
+  const auto soaAtTime1 = soa.scanPositions(1);
+  EXPECT_EQ(2, soaAtTime1.rows());
+  EXPECT_EQ(Eigen::Vector3d(2, 0, 0),
+            Eigen::Vector3d(soaAtTime1.row(0).transpose()));
+  EXPECT_EQ(Eigen::Vector3d(4, 0, 0),
+            Eigen::Vector3d(soaAtTime1.row(1).transpose()));
+
+  EXPECT_THROW(aos.scanPositions(2), std::out_of_range);
+
+  // Not evenly spaced
+  DetectorInfo<FlatTree> unevenlySpaced(
+      makeInstrumentTree(), std::vector<std::vector<size_t>>{{0, 2}, {1, 3}},
+      scanTimes, positions, rotations);
+  EXPECT_THROW(unevenlySpaced.scanPositions(0), std::logic_error);
+}
+
+void expectScatteringAngles(bool cacheAngles) {
+
+  // Source at -1, 0, 0
+  // Sample at 0.1, 0, 0
+  // Detectors B and C both at 1, 1, 1
+  DetectorInfo<FlatTree> detectorInfo(
+      makeInstrumentTree(), SourceSampleDetectorPathFactory<FlatTree>{});
+  if (cacheAngles) {
+    detectorInfo.cacheScatteringAngles();
+  }
+  EXPECT_EQ(cacheAngles, detectorInfo.cachesScatteringAngles());
+
+  const Eigen::Vector3d beam{1, 0, 0};
+  const Eigen::Vector3d scattered{0.9, 1, 1};
+  const double expected =
+      std::acos(beam.dot(scattered) / scattered.norm());
+  EXPECT_DOUBLE_EQ(expected, detectorInfo.twoTheta(0));
+  EXPECT_DOUBLE_EQ(expected, detectorInfo.twoTheta(1));
+  // Beam along x with y up, so phi is measured from -z towards y.
+  EXPECT_DOUBLE_EQ(3 * M_PI / 4, detectorInfo.phi(0));
+
+  auto angles = detectorInfo.scatteringAngles();
+  EXPECT_DOUBLE_EQ(std::sin(expected / 2), angles->sinTheta(0));
+  EXPECT_DOUBLE_EQ(std::cos(expected), angles->cosTwoTheta(0));
+
+  // Mirror detector B through the plane of the beam and the up axis.
+  detectorInfo.moveDetector(0, Eigen::Vector3d{0, 0, -2});
+  EXPECT_DOUBLE_EQ(expected, detectorInfo.twoTheta(0));
+  EXPECT_DOUBLE_EQ(-detectorInfo.signedTwoTheta(1),
+                   detectorInfo.signedTwoTheta(0));
+
+  // Rotate detector C about the beam, to 1, -1, 1. Two-theta is unchanged.
+  const double phiBefore = detectorInfo.phi(1);
+  detectorInfo.rotateDetector(1, beam, M_PI / 2, Eigen::Vector3d{0.1, 0, 0});
+  EXPECT_NEAR(expected, detectorInfo.twoTheta(1), 1e-12);
+  EXPECT_NEAR(-phiBefore, detectorInfo.phi(1), 1e-12);
+
+  // Moving the sample along the beam past the detectors changes all angles.
+  const size_t sampleIndex =
+      detectorInfo.const_instrumentTree().samplePathIndex();
+  detectorInfo.movePathComponents({sampleIndex}, Eigen::Vector3d{2.9, 0, 0});
+  EXPECT_DOUBLE_EQ(std::acos(-2 / std::sqrt(6)), detectorInfo.twoTheta(0));
+  EXPECT_DOUBLE_EQ(angles->twoTheta(0), expected)
+      << "Earlier copy of the angles should be unaffected";
+  EXPECT_DOUBLE_EQ(detectorInfo.scatteringAngles()->phi(1),
+                   detectorInfo.phi(1));
+}
+
+TEST(detector_info_test, test_scattering_angles) {
+  expectScatteringAngles(false);
+}
+
+TEST(detector_info_test, test_cached_scattering_angles) {
+  expectScatteringAngles(true);
+}
+
+TEST(detector_info_test, test_scanning_scattering_angles) {
+
+  auto scanTimes = ScanTimes{ScanTime(0, 10), ScanTime(10, 20)}; // 2 scan times
+
+  auto timeIndexes = std::vector<std::vector<size_t>>{{0, 2}, {1, 3}};
+
+  auto positions = std::vector<Eigen::Vector3d>(4);
+  positions[0] = Eigen::Vector3d{1.1, 1, 0};  // Detector B time 0
+  positions[1] = Eigen::Vector3d{0.1, 1, 0};  // Detector C time 0
+  positions[2] = Eigen::Vector3d{-0.9, 1, 0}; // Detector B time 1
+  positions[3] = Eigen::Vector3d{1, 0, 0};    // Detector C time 1
+
+  auto rotations = std::vector<Eigen::Quaterniond>(
+      4, Eigen::Quaterniond{Eigen::Affine3d::Identity().rotation()});
+
+  // Beam along x, sample at 0.1, 0, 0
+  DetectorInfo<FlatTree> detectorInfo(makeInstrumentTree(), timeIndexes,
+                                      scanTimes, positions, rotations);
+
+  EXPECT_DOUBLE_EQ(M_PI / 4, detectorInfo.twoTheta(0, 0));
+  EXPECT_DOUBLE_EQ(3 * M_PI / 4, detectorInfo.twoTheta(0, 1));
+  EXPECT_DOUBLE_EQ(M_PI / 2, detectorInfo.twoTheta(1, 0));
+  EXPECT_DOUBLE_EQ(0, detectorInfo.twoTheta(1, 1));
+  EXPECT_DOUBLE_EQ(M_PI / 2, detectorInfo.phi(1, 0));
+
+  detectorInfo.moveDetector(1, 1, Eigen::Vector3d{0, 0, 0.9});
+  EXPECT_DOUBLE_EQ(M_PI / 4, detectorInfo.twoTheta(1, 1));
+  EXPECT_DOUBLE_EQ(M_PI / 2, detectorInfo.twoTheta(1, 0))
+      << "Other scan point unchanged";
+
+  detectorInfo.cacheScatteringAngles();
+  detectorInfo.moveDetector(0, 1, Eigen::Vector3d{1, 0, 0});
+  EXPECT_DOUBLE_EQ(M_PI / 2, detectorInfo.twoTheta(0, 1));
+  EXPECT_DOUBLE_EQ(M_PI / 4, detectorInfo.twoTheta(1, 1));
+  EXPECT_DOUBLE_EQ(M_PI / 2, detectorInfo.phi(1, 0));
+}
 }
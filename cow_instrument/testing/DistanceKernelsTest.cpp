@@ -0,0 +1,55 @@
+#include "DistanceKernels.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// Not a multiple of any vector width, so the scalar tail is exercised too
+const size_t count = 19;
+const double point[3] = {0.5, -1, 10};
+const double offset = 2.5;
+
+double expected(double x, double y, double z) {
+  const double dx = x - point[0];
+  const double dy = y - point[1];
+  const double dz = z - point[2];
+  return offset + std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+TEST(distance_kernels_test, test_soa) {
+  std::vector<double> x(count), y(count), z(count);
+  for (size_t i = 0; i < count; ++i) {
+    x[i] = double(i);
+    y[i] = 0.25 * double(i);
+    z[i] = -double(i * i);
+  }
+  std::vector<double> out(count);
+  offsetDistancesSoA(x.data(), y.data(), z.data(), count, point, offset,
+                     out.data());
+  for (size_t i = 0; i < count; ++i) {
+    EXPECT_DOUBLE_EQ(expected(x[i], y[i], z[i]), out[i]);
+  }
+}
+
+TEST(distance_kernels_test, test_aos) {
+  std::vector<double> xyz(3 * count);
+  for (size_t i = 0; i < count; ++i) {
+    xyz[3 * i] = double(i);
+    xyz[3 * i + 1] = 0.25 * double(i);
+    xyz[3 * i + 2] = -double(i * i);
+  }
+  std::vector<double> out(count);
+  offsetDistancesAoS(xyz.data(), count, point, offset, out.data());
+  for (size_t i = 0; i < count; ++i) {
+    EXPECT_DOUBLE_EQ(expected(xyz[3 * i], xyz[3 * i + 1], xyz[3 * i + 2]),
+                     out[i]);
+  }
+}
+
+TEST(distance_kernels_test, test_empty) {
+  // Nothing read or written
+  offsetDistancesSoA(nullptr, nullptr, nullptr, 0, point, offset, nullptr);
+  offsetDistancesAoS(nullptr, 0, point, offset, nullptr);
+}
+}
@@ -0,0 +1,119 @@
+#include "ComponentProxy.h"
+#include "CompositeComponent.h"
+#include "DetectorComponent.h"
+#include "FlatTree.h"
+#include "FlatTreeBuilder.h"
+#include "PointSample.h"
+#include "PointSource.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+
+/*
+
+      A
+      |
+ ------------------------------
+ |                |           |
+ B (bank)         E (source)  F (sample)
+ |
+ -------
+ |     |
+ C     D (detectors)
+
+*/
+
+std::shared_ptr<CompositeComponent> makeComponentTree() {
+  auto bank = std::unique_ptr<CompositeComponent>(
+      new CompositeComponent(ComponentIdType(2)));
+  bank->addComponent(std::unique_ptr<DetectorComponent>(new DetectorComponent(
+      ComponentIdType(3), DetectorIdType(10), Eigen::Vector3d{1, 1, 5})));
+  bank->addComponent(std::unique_ptr<DetectorComponent>(new DetectorComponent(
+      ComponentIdType(4), DetectorIdType(11), Eigen::Vector3d{-1, 1, 5})));
+
+  auto a = std::make_shared<CompositeComponent>(ComponentIdType(1));
+  a->addComponent(std::move(bank));
+  a->addComponent(std::unique_ptr<PointSource>(
+      new PointSource(Eigen::Vector3d{0, 0, -10}, ComponentIdType(5))));
+  a->addComponent(std::unique_ptr<PointSample>(
+      new PointSample(Eigen::Vector3d{0, 0, 0}, ComponentIdType(6))));
+  return a;
+}
+
+FlatTree buildTree() {
+  FlatTreeBuilder builder;
+  builder.reserve(6, 2, 2);
+  builder.beginAssembly(ComponentIdType(1));
+  builder.beginAssembly(ComponentIdType(2));
+  builder.addDetector(ComponentIdType(3), DetectorIdType(10),
+                      Eigen::Vector3d{1, 1, 5});
+  builder.addDetector(ComponentIdType(4), DetectorIdType(11),
+                      Eigen::Vector3d{-1, 1, 5});
+  builder.endAssembly();
+  builder.addSource(ComponentIdType(5), Eigen::Vector3d{0, 0, -10});
+  builder.addSample(ComponentIdType(6), Eigen::Vector3d{0, 0, 0});
+  builder.endAssembly();
+  return builder.build();
+}
+
+TEST(flat_tree_builder_test, test_matches_component_tree) {
+  const FlatTree expected(makeComponentTree());
+  const FlatTree built = buildTree();
+
+  EXPECT_EQ(expected, built) << "Proxies differ";
+  EXPECT_EQ(expected.startPositions(), built.startPositions());
+  EXPECT_EQ(expected.startRotations().size(), built.startRotations().size());
+  EXPECT_EQ(expected.startEntryPoints(), built.startEntryPoints());
+  EXPECT_EQ(expected.startExitPoints(), built.startExitPoints());
+  EXPECT_EQ(expected.pathLengths(), built.pathLengths());
+  EXPECT_EQ(expected.detectorComponentIndexes(),
+            built.detectorComponentIndexes());
+  EXPECT_EQ(expected.pathComponentIndexes(), built.pathComponentIndexes());
+  EXPECT_EQ(expected.branchNodeComponentIndexes(),
+            built.branchNodeComponentIndexes());
+  EXPECT_EQ(expected.sourcePathIndex(), built.sourcePathIndex());
+  EXPECT_EQ(expected.samplePathIndex(), built.samplePathIndex());
+  EXPECT_EQ(expected.subTree(1), built.subTree(1));
+  EXPECT_EQ(1, built.detectorIndex(DetectorIdType(11)));
+  EXPECT_EQ(4, built.componentIndex(ComponentIdType(5)));
+}
+
+TEST(flat_tree_builder_test, test_explicit_assembly_position) {
+  FlatTreeBuilder builder;
+  const Eigen::Vector3d rootPosition{0, 0, 1};
+  builder.beginAssembly(ComponentIdType(1), rootPosition,
+                        Eigen::Quaterniond::Identity());
+  builder.addSource(ComponentIdType(2), Eigen::Vector3d{0, 0, -10});
+  builder.addSample(ComponentIdType(3), Eigen::Vector3d{0, 0, 0});
+  builder.endAssembly();
+  const auto tree = builder.build();
+
+  EXPECT_EQ(rootPosition, tree.startPositions()[0]);
+  EXPECT_EQ(0, builder.componentSize()) << "Builder emptied by build";
+}
+
+TEST(flat_tree_builder_test, test_misuse_throws) {
+  FlatTreeBuilder builder;
+  EXPECT_THROW(builder.endAssembly(), std::logic_error);
+  EXPECT_THROW(builder.addDetector(ComponentIdType(1), DetectorIdType(1),
+                                   Eigen::Vector3d{0, 0, 1}),
+               std::logic_error)
+      << "Root must be an assembly";
+  EXPECT_EQ(builder.componentSize(), 0);
+
+  builder.beginAssembly(ComponentIdType(1));
+  builder.addSource(ComponentIdType(2), Eigen::Vector3d{0, 0, -10});
+  EXPECT_THROW(builder.addSource(ComponentIdType(3), Eigen::Vector3d{0, 0, 1}),
+               std::logic_error);
+  EXPECT_THROW(builder.build(), std::logic_error) << "Root still open";
+
+  builder.endAssembly();
+  EXPECT_THROW(builder.addDetector(ComponentIdType(4), DetectorIdType(1),
+                                   Eigen::Vector3d{0, 0, 1}),
+               std::logic_error)
+      << "Only one root";
+  EXPECT_THROW(builder.build(), std::invalid_argument) << "No sample";
+}
+}
@@ -156,7 +156,7 @@ TEST(instrument_tree_test, test_both_constructors) {
 
   LinkedTreeParser intermediate;
   source->registerContents(intermediate);
-  auto proxies = intermediate.proxies();
+  auto parents = intermediate.parents();
   auto positions = intermediate.startPositions();
   auto rotations = intermediate.startRotations();
   auto componentIds = intermediate.componentIds();
@@ -169,7 +169,7 @@ TEST(instrument_tree_test, test_both_constructors) {
   auto detectorIds = intermediate.detectorIds();
 
   FlatTree treeB(
-      std::move(proxies), std::move(positions), std::move(rotations),
+      std::move(parents), std::move(positions), std::move(rotations),
       std::move(componentIds), std::move(entryPoints), std::move(exitPoints),
       std::move(pathLengths), std::move(pathComponentIndexes),
       std::move(detectorComponentIndexes),
@@ -196,7 +196,7 @@ TEST(instrument_tree_test, test_fetching_root_component_failure) {
 
   LinkedTreeParser intermediate;
   source->registerContents(intermediate);
-  auto proxies = intermediate.proxies();
+  auto parents = intermediate.parents();
   auto positions = intermediate.startPositions();
   auto rotations = intermediate.startRotations();
   auto componentIds = intermediate.componentIds();
@@ -208,7 +208,7 @@ TEST(instrument_tree_test, test_fetching_root_component_failure) {
   auto branchNodeComponentIndexes = intermediate.branchNodeComponentIndexes();
   auto detectorIds = intermediate.detectorIds();
 
-  FlatTree tree(std::move(proxies), std::move(positions), std::move(rotations),
+  FlatTree tree(std::move(parents), std::move(positions), std::move(rotations),
                 std::move(componentIds), std::move(entryPoints),
                 std::move(exitPoints), std::move(pathLengths),
                 std::move(pathComponentIndexes),
@@ -264,6 +264,44 @@ TEST(instrument_tree_test, test_fill_detector_map) {
   EXPECT_EQ(container.size(), 2) << "Two detectors expected";
 }
 
+TEST(instrument_tree_test, test_id_lookup) {
+
+  const ComponentIdType idForSource(10);
+  const ComponentIdType idForSample(20);
+  const ComponentIdType idForDetector(30);
+
+  auto instrument =
+      make_very_basic_tree(idForSource, idForSample, idForDetector);
+
+  std::map<ComponentIdType, size_t> componentIdMap;
+  instrument.fillComponentMap(componentIdMap);
+  for (const auto &item : componentIdMap) {
+    EXPECT_EQ(item.second, instrument.componentIndex(item.first));
+  }
+  EXPECT_THROW(instrument.componentIndex(ComponentIdType(11)),
+               std::out_of_range);
+
+  auto copy = instrument;
+  EXPECT_EQ(instrument.componentIndex(idForSample),
+            copy.componentIndex(idForSample));
+}
+
+TEST(instrument_tree_test, test_detector_id_lookup) {
+
+  auto instrument = make_simple_tree(DetectorIdType(1), DetectorIdType(2));
+  EXPECT_EQ(0, instrument.detectorIndex(DetectorIdType(1)));
+  EXPECT_EQ(1, instrument.detectorIndex(DetectorIdType(2)));
+  EXPECT_THROW(instrument.detectorIndex(DetectorIdType(3)), std::out_of_range);
+
+  std::vector<size_t> detectorIndexes;
+  instrument.detectorIndexes(
+      {DetectorIdType(2), DetectorIdType(3), DetectorIdType(1)},
+      detectorIndexes);
+  EXPECT_EQ(
+      (std::vector<size_t>{1, IdIndex<DetectorIdType>::npos, 0}),
+      detectorIndexes);
+}
+
 TEST(instrument_tree_test,
      test_get_detector_and_path_from_mixed_component_instrument) {
 
@@ -322,7 +360,7 @@ TEST(instrument_tree_test, test_component_proxies) {
   EXPECT_FALSE(it->hasParent());
   EXPECT_TRUE(it->hasChildren());
   EXPECT_EQ(it->nChildren(), 3);
-  EXPECT_EQ(it->children(), (std::vector<size_t>{1, 2, 3}));
+  EXPECT_EQ(it->children(), (std::vector<IndexType>{1, 2, 3}));
   // Move on to B
   ++it;
   EXPECT_EQ(it->componentId(), ComponentIdType(2));
@@ -341,7 +379,7 @@ TEST(instrument_tree_test, test_component_proxies) {
   EXPECT_TRUE(it->hasParent());
   EXPECT_TRUE(it->hasChildren());
   EXPECT_EQ(it->parent(), 0);
-  EXPECT_EQ(it->children(), (std::vector<size_t>{4}));
+  EXPECT_EQ(it->children(), (std::vector<IndexType>{4}));
   // Move on to E
   ++it;
   EXPECT_EQ(it->componentId(), ComponentIdType(5));
@@ -450,6 +488,52 @@ TEST(instrument_tree_test, test_subtree_unreachable_throws) {
                std::invalid_argument);
 }
 
+TEST(instrument_tree_test, test_sub_tree_ranges) {
+
+  FlatTree instrument = make_simple_tree(DetectorIdType(1), DetectorIdType(2));
+
+  // Components in depth-first order: A, B, B's detector, C, D, E
+  EXPECT_EQ(instrument.subTree(0),
+            (SubTree{{0, 6}, {0, 2}, {0, 2}, {0, 2}}))
+      << "Root sub-tree covers everything";
+  EXPECT_EQ(instrument.subTree(1), (SubTree{{1, 3}, {0, 1}, {0, 0}, {1, 2}}))
+      << "B covers itself and its detector";
+  EXPECT_EQ(instrument.subTree(3), (SubTree{{3, 4}, {1, 2}, {0, 0}, {2, 2}}))
+      << "C is a lone detector";
+  EXPECT_EQ(instrument.subTree(5), (SubTree{{5, 6}, {2, 2}, {1, 2}, {2, 2}}))
+      << "E is a lone path component";
+
+  EXPECT_EQ(instrument.subTreeIndexes(1), (std::vector<size_t>{1, 2}));
+  EXPECT_THROW(instrument.subTree(instrument.componentSize()),
+               std::invalid_argument);
+}
+
+TEST(instrument_tree_test, test_proxies_must_be_depth_first) {
+
+  auto makeTree = [](std::vector<int64_t> &&parents) {
+    const size_t n = parents.size();
+    std::vector<ComponentIdType> componentIds;
+    for (size_t i = 0; i < n; ++i) {
+      componentIds.emplace_back(i);
+    }
+    return FlatTree(
+        std::move(parents), std::vector<Eigen::Vector3d>(n),
+        std::vector<Eigen::Quaterniond>(n, Eigen::Quaterniond::Identity()),
+        std::move(componentIds), std::vector<Eigen::Vector3d>(2),
+        std::vector<Eigen::Vector3d>(2), std::vector<double>(2, 0), {1, 2},
+        {}, {0}, {}, 0, 1);
+  };
+
+  EXPECT_NO_THROW(makeTree({-1, 0, 0}));
+  EXPECT_NO_THROW(makeTree({-1, 0, 1, 0}));
+  EXPECT_THROW(makeTree({-1, 2, 0}), std::invalid_argument)
+      << "Parent after child";
+  EXPECT_THROW(makeTree({-1, 0, -1}), std::invalid_argument)
+      << "Component 2 is not below the root";
+  EXPECT_THROW(makeTree({-1, 0, 0, 1}), std::invalid_argument)
+      << "Sub-tree of component 1 is split";
+}
+
 TEST(instrument_tree_test, test_nextlevel_unreachable_throws) {
 
   FlatTree instrument = makeInstrumentTree();
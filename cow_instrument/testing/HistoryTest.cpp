@@ -0,0 +1,146 @@
+#include "History.h"
+#include "ComponentInfo.h"
+#include "CompositeComponent.h"
+#include "DetectorComponent.h"
+#include "DetectorInfo.h"
+#include "FlatTree.h"
+#include "PointSample.h"
+#include "PointSource.h"
+#include <gtest/gtest.h>
+#include <memory>
+
+namespace {
+
+std::shared_ptr<FlatTree> makeInstrumentTree() {
+  /*
+
+        A
+        |
+ ------------------------------
+ |                |           |
+ B                C           D
+                              |
+                              E
+
+  */
+
+  auto a = std::make_shared<CompositeComponent>(ComponentIdType(1));
+  a->addComponent(std::unique_ptr<DetectorComponent>(new DetectorComponent(
+      ComponentIdType(2), DetectorIdType(1), Eigen::Vector3d{1, 1, 1})));
+  a->addComponent(std::unique_ptr<PointSource>(
+      new PointSource(Eigen::Vector3d{-1, 0, 0}, ComponentIdType(3))));
+
+  auto d = std::unique_ptr<CompositeComponent>(
+      new CompositeComponent(ComponentIdType(4)));
+  d->addComponent(std::unique_ptr<PointSample>(
+      new PointSample(Eigen::Vector3d{0.1, 0, 0}, ComponentIdType(5))));
+
+  a->addComponent(std::move(d));
+
+  return std::make_shared<FlatTree>(a);
+}
+
+TEST(history_test, test_undo_redo) {
+  DetectorInfo<FlatTree> detectorInfo(makeInstrumentTree());
+  History<DetectorInfo<FlatTree>> history(detectorInfo);
+  EXPECT_FALSE(history.canUndo());
+  EXPECT_THROW(history.undo(), std::logic_error);
+
+  const Eigen::Vector3d start = detectorInfo.position(0);
+  const double startL2 = detectorInfo.l2(0);
+  const Eigen::Vector3d offset{1, 0, 0};
+
+  history.checkpoint();
+  detectorInfo.moveDetector(0, offset);
+  history.checkpoint();
+  detectorInfo.moveDetector(0, offset);
+  EXPECT_EQ(start + 2 * offset, detectorInfo.position(0));
+
+  history.undo();
+  EXPECT_EQ(start + offset, detectorInfo.position(0));
+  history.undo();
+  EXPECT_EQ(start, detectorInfo.position(0));
+  EXPECT_EQ(startL2, detectorInfo.l2(0)) << "Derived values follow";
+  EXPECT_FALSE(history.canUndo());
+
+  EXPECT_TRUE(history.canRedo());
+  history.redo();
+  history.redo();
+  EXPECT_EQ(start + 2 * offset, detectorInfo.position(0));
+  EXPECT_FALSE(history.canRedo());
+  EXPECT_THROW(history.redo(), std::logic_error);
+
+  history.undo();
+  history.checkpoint();
+  EXPECT_FALSE(history.canRedo()) << "New checkpoint discards redo";
+}
+
+TEST(history_test, test_snapshots) {
+  DetectorInfo<FlatTree> detectorInfo(makeInstrumentTree());
+  History<DetectorInfo<FlatTree>> history(detectorInfo);
+  const Eigen::Vector3d start = detectorInfo.position(0);
+
+  history.snapshot("start");
+  detectorInfo.moveDetector(0, Eigen::Vector3d{0, 1, 0});
+  history.snapshot("moved");
+  EXPECT_TRUE(history.hasSnapshot("moved"));
+  EXPECT_EQ((std::vector<std::string>{"moved", "start"}),
+            history.snapshotNames());
+
+  history.restore("start");
+  EXPECT_EQ(start, detectorInfo.position(0));
+  history.undo();
+  EXPECT_EQ(start + Eigen::Vector3d(0, 1, 0), detectorInfo.position(0))
+      << "Restore should be undoable";
+
+  history.removeSnapshot("start");
+  EXPECT_FALSE(history.hasSnapshot("start"));
+  EXPECT_THROW(history.restore("start"), std::out_of_range);
+}
+
+TEST(history_test, test_versions_share_unchanged_data) {
+  DetectorInfo<FlatTree> detectorInfo(makeInstrumentTree());
+  History<DetectorInfo<FlatTree>> history(detectorInfo);
+
+  history.snapshot("start");
+  const auto *positions = &detectorInfo.const_positions();
+  detectorInfo.setMasked(0);
+  EXPECT_EQ(positions, &detectorInfo.const_positions())
+      << "Positions should still be shared with the snapshot";
+
+  detectorInfo.moveDetector(0, Eigen::Vector3d{1, 0, 0});
+  EXPECT_NE(positions, &detectorInfo.const_positions())
+      << "Positions should be copied once written";
+  history.restore("start");
+  EXPECT_EQ(positions, &detectorInfo.const_positions());
+  EXPECT_FALSE(detectorInfo.isMasked(0));
+}
+
+TEST(history_test, test_component_info) {
+  ComponentInfo<FlatTree> componentInfo{
+      DetectorInfo<FlatTree>(makeInstrumentTree())};
+  History<ComponentInfo<FlatTree>> history(componentInfo);
+
+  const size_t sampleIndex =
+      componentInfo.const_instrumentTree().samplePathIndex();
+  const auto samplePosition = [&]() {
+    return componentInfo.detectorInfo().pathComponentInfo().position(
+        sampleIndex);
+  };
+  const Eigen::Vector3d start = samplePosition();
+  const Eigen::Vector3d rootStart = componentInfo.position(0);
+  const Eigen::Vector3d offset{1, 0, 0};
+
+  // Move everything, from the root down
+  history.checkpoint();
+  componentInfo.move(0, offset);
+  EXPECT_EQ(start + offset, samplePosition());
+  EXPECT_EQ(rootStart + offset, componentInfo.position(0));
+
+  history.undo();
+  EXPECT_EQ(start, samplePosition());
+  EXPECT_EQ(rootStart, componentInfo.position(0));
+  history.redo();
+  EXPECT_EQ(start + offset, samplePosition());
+}
+}
@@ -0,0 +1,69 @@
+#include "IdIndex.h"
+#include "IdType.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+std::vector<DetectorIdType> makeIds(const std::vector<size_t> &values) {
+  std::vector<DetectorIdType> ids;
+  for (auto value : values) {
+    ids.emplace_back(value);
+  }
+  return ids;
+}
+
+TEST(id_index_test, test_empty) {
+  IdIndex<DetectorIdType> index(makeIds({}));
+  EXPECT_EQ(0, index.size());
+  EXPECT_EQ(IdIndex<DetectorIdType>::npos, index.find(DetectorIdType(0)));
+  EXPECT_THROW(index[DetectorIdType(0)], std::out_of_range);
+}
+
+TEST(id_index_test, test_dense_ids) {
+  IdIndex<DetectorIdType> index(makeIds({12, 10, 11, 14}));
+  EXPECT_TRUE(index.isDirect());
+  EXPECT_EQ(4, index.size());
+  EXPECT_EQ(0, index[DetectorIdType(12)]);
+  EXPECT_EQ(1, index[DetectorIdType(10)]);
+  EXPECT_EQ(2, index[DetectorIdType(11)]);
+  EXPECT_EQ(3, index[DetectorIdType(14)]);
+  EXPECT_EQ(IdIndex<DetectorIdType>::npos, index.find(DetectorIdType(13)));
+  EXPECT_EQ(IdIndex<DetectorIdType>::npos, index.find(DetectorIdType(9)));
+  EXPECT_EQ(IdIndex<DetectorIdType>::npos, index.find(DetectorIdType(15)));
+  EXPECT_THROW(index[DetectorIdType(13)], std::out_of_range);
+}
+
+TEST(id_index_test, test_sparse_ids) {
+  std::vector<size_t> values;
+  for (size_t i = 0; i < 1000; ++i) {
+    values.push_back(i * 1000003 + 7);
+  }
+  IdIndex<DetectorIdType> index(makeIds(values));
+  EXPECT_FALSE(index.isDirect());
+  for (size_t i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(i, index[DetectorIdType(values[i])]);
+  }
+  EXPECT_EQ(IdIndex<DetectorIdType>::npos, index.find(DetectorIdType(8)));
+  EXPECT_THROW(index[DetectorIdType(0)], std::out_of_range);
+}
+
+TEST(id_index_test, test_duplicates_keep_first_index) {
+  IdIndex<DetectorIdType> dense(makeIds({1, 2, 1}));
+  EXPECT_EQ(0, dense[DetectorIdType(1)]);
+  IdIndex<DetectorIdType> sparse(makeIds({1, 1000000, 1}));
+  EXPECT_FALSE(sparse.isDirect());
+  EXPECT_EQ(0, sparse[DetectorIdType(1)]);
+  EXPECT_EQ(1, sparse[DetectorIdType(1000000)]);
+}
+
+TEST(id_index_test, test_batch_find) {
+  for (auto values : {std::vector<size_t>{5, 6, 7},
+                      std::vector<size_t>{5, 600000, 7}}) {
+    IdIndex<DetectorIdType> index(makeIds(values));
+    std::vector<size_t> out;
+    index.find(makeIds({7, 5, 100, values[1]}), out);
+    EXPECT_EQ(
+        (std::vector<size_t>{2, 0, IdIndex<DetectorIdType>::npos, 1}), out);
+  }
+}
+}
@@ -0,0 +1,69 @@
+#include "LinearIndexMap.h"
+#include <gtest/gtest.h>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+TEST(linear_index_map_test, test_default_is_identity) {
+  LinearIndexMap map(3);
+  EXPECT_EQ(3, map.size());
+  EXPECT_TRUE(map.isStrided());
+  EXPECT_EQ(1, map.stride());
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_EQ(i, map(i, 0));
+    EXPECT_EQ(1, map.scanCount(i));
+  }
+}
+
+TEST(linear_index_map_test, test_strided) {
+  LinearIndexMap map(
+      std::vector<std::vector<size_t>>{{0, 1, 2}, {3, 4, 5}});
+  EXPECT_TRUE(map.isStrided());
+  EXPECT_EQ(3, map.stride());
+  EXPECT_EQ(2, map.size());
+  EXPECT_EQ(3, map.scanCount(1));
+  EXPECT_EQ(4, map(1, 1));
+  EXPECT_EQ(2, map(0, 2));
+}
+
+TEST(linear_index_map_test, test_uniform_scan_count) {
+  LinearIndexMap map(std::vector<std::vector<size_t>>{{0, 2}, {1, 3}});
+  EXPECT_FALSE(map.isStrided());
+  EXPECT_EQ(2, map.stride());
+  EXPECT_EQ(0, map(0, 0));
+  EXPECT_EQ(2, map(0, 1));
+  EXPECT_EQ(1, map(1, 0));
+  EXPECT_EQ(3, map(1, 1));
+}
+
+TEST(linear_index_map_test, test_varying_scan_count) {
+  LinearIndexMap map(std::vector<std::vector<size_t>>{{0, 1, 2}, {3}, {4, 5}});
+  EXPECT_FALSE(map.isStrided());
+  EXPECT_EQ(0, map.stride());
+  EXPECT_EQ(3, map.scanCount(0));
+  EXPECT_EQ(1, map.scanCount(1));
+  EXPECT_EQ(2, map.scanCount(2));
+  EXPECT_EQ(2, map(0, 2));
+  EXPECT_EQ(3, map(1, 0));
+  EXPECT_EQ(5, map(2, 1));
+}
+
+TEST(linear_index_map_test, test_detector_indexes) {
+  LinearIndexMap map(std::vector<std::vector<size_t>>{{0, 3}, {1}, {2}});
+  EXPECT_EQ((std::vector<IndexType>{0, 1, 2, 0}), map.detectorIndexes(4));
+}
+
+TEST(linear_index_map_test, test_indexes_beyond_index_type_throw) {
+  if (maxIndex == std::numeric_limits<size_t>::max()) {
+    return; // Only COMPACT_INDEXES can overflow
+  }
+  const size_t tooLarge = maxIndex + 1;
+  EXPECT_THROW(LinearIndexMap(std::vector<std::vector<size_t>>{{0, tooLarge}}),
+               std::invalid_argument)
+      << "Linear index";
+  EXPECT_THROW(LinearIndexMap(tooLarge + 1).detectorIndexes(0),
+               std::invalid_argument)
+      << "Detector index";
+}
+}
@@ -4,6 +4,7 @@
 #include "CompositeComponent.h"
 #include "DetectorComponent.h"
 #include "LinkedTreeParser.h"
+#include "Parallel.h"
 #include "PointSample.h"
 #include "PointSource.h"
 
@@ -123,4 +124,131 @@ TEST(linked_tree_parser_test, test_indexing) {
   EXPECT_EQ(detectorIndexes[0], 3);
   EXPECT_EQ(pathIndexes[1], 4);
 }
+
+std::shared_ptr<CompositeComponent> makeBankedTree() {
+  /*
+   Root holding a trolley of two banks, a lone detector, a bank, the source and
+   the sample.
+   */
+  size_t nextId = 1;
+  auto makeBank = [&nextId](double z) {
+    std::unique_ptr<CompositeComponent> bank(
+        new CompositeComponent(ComponentIdType(nextId++)));
+    for (size_t i = 0; i < 5; ++i) {
+      bank->addComponent(std::unique_ptr<DetectorComponent>(
+          new DetectorComponent(ComponentIdType(nextId), DetectorIdType(nextId),
+                                Eigen::Vector3d{double(i), 0.5, z})));
+      ++nextId;
+    }
+    return bank;
+  };
+  auto root = std::make_shared<CompositeComponent>(ComponentIdType(nextId++));
+  std::unique_ptr<CompositeComponent> trolley(
+      new CompositeComponent(ComponentIdType(nextId++)));
+  trolley->addComponent(makeBank(1));
+  trolley->addComponent(makeBank(2));
+  root->addComponent(std::move(trolley));
+  root->addComponent(std::unique_ptr<DetectorComponent>(
+      new DetectorComponent(ComponentIdType(nextId), DetectorIdType(nextId),
+                            Eigen::Vector3d{0, 3, 0})));
+  ++nextId;
+  root->addComponent(makeBank(3));
+  root->addComponent(std::unique_ptr<PointSource>(
+      new PointSource(Eigen::Vector3d{0, 0, -10}, ComponentIdType(nextId++))));
+  root->addComponent(std::unique_ptr<PointSample>(
+      new PointSample(Eigen::Vector3d{0, 0, 0}, ComponentIdType(nextId++))));
+  return root;
+}
+
+void expectSameRegistration(const LinkedTreeParser &serial,
+                            const LinkedTreeParser &parallel) {
+  EXPECT_EQ(serial.parents(), parallel.parents());
+  EXPECT_EQ(serial.startPositions(), parallel.startPositions());
+  EXPECT_EQ(serial.componentIds(), parallel.componentIds());
+  EXPECT_EQ(serial.startEntryPoints(), parallel.startEntryPoints());
+  EXPECT_EQ(serial.startExitPoints(), parallel.startExitPoints());
+  EXPECT_EQ(serial.pathLengths(), parallel.pathLengths());
+  EXPECT_EQ(serial.detectorComponentIndexes(),
+            parallel.detectorComponentIndexes());
+  EXPECT_EQ(serial.detectorIds(), parallel.detectorIds());
+  EXPECT_EQ(serial.pathComponentIndexes(), parallel.pathComponentIndexes());
+  EXPECT_EQ(serial.branchNodeComponentIndexes(),
+            parallel.branchNodeComponentIndexes());
+  EXPECT_EQ(serial.sourcePathIndex(), parallel.sourcePathIndex());
+  EXPECT_EQ(serial.samplePathIndex(), parallel.samplePathIndex());
+  const auto serialRotations = serial.startRotations();
+  const auto parallelRotations = parallel.startRotations();
+  ASSERT_EQ(serialRotations.size(), parallelRotations.size());
+  for (size_t i = 0; i < serialRotations.size(); ++i) {
+    EXPECT_EQ(serialRotations[i].coeffs(), parallelRotations[i].coeffs());
+  }
+}
+
+TEST(linked_tree_parser_test, test_parallel_registration_matches_serial) {
+  auto root = makeBankedTree();
+  LinkedTreeParser serial;
+  root->registerContents(serial);
+
+  setParallelThreadCount(4);
+  LinkedTreeParser parallel;
+  parallel.registerCompositeInParallel(root.get());
+  setParallelThreadCount(0);
+
+  expectSameRegistration(serial, parallel);
+}
+
+std::shared_ptr<CompositeComponent> makeDeepTree() {
+  /*
+   Root holding the source, two trolleys of five banks of four tubes of three
+   pixels, and the sample last.
+   */
+  size_t nextId = 1;
+  auto makeComposite = [&nextId]() {
+    return std::unique_ptr<CompositeComponent>(
+        new CompositeComponent(ComponentIdType(nextId++)));
+  };
+  auto root = std::make_shared<CompositeComponent>(ComponentIdType(nextId++));
+  root->addComponent(std::unique_ptr<PointSource>(
+      new PointSource(Eigen::Vector3d{0, 0, -10}, ComponentIdType(nextId++))));
+  for (size_t trolleyIndex = 0; trolleyIndex < 2; ++trolleyIndex) {
+    auto trolley = makeComposite();
+    for (size_t bankIndex = 0; bankIndex < 5; ++bankIndex) {
+      auto bank = makeComposite();
+      for (size_t tubeIndex = 0; tubeIndex < 4; ++tubeIndex) {
+        auto tube = makeComposite();
+        for (size_t pixel = 0; pixel < 3; ++pixel) {
+          tube->addComponent(std::unique_ptr<DetectorComponent>(
+              new DetectorComponent(
+                  ComponentIdType(nextId), DetectorIdType(nextId),
+                  Eigen::Vector3d{0.1 * double(pixel), double(tubeIndex),
+                                  double(5 * trolleyIndex + bankIndex)})));
+          ++nextId;
+        }
+        bank->addComponent(std::move(tube));
+      }
+      trolley->addComponent(std::move(bank));
+    }
+    root->addComponent(std::move(trolley));
+  }
+  root->addComponent(std::unique_ptr<PointSample>(
+      new PointSample(Eigen::Vector3d{0, 0, 0}, ComponentIdType(nextId++))));
+  return root;
+}
+
+TEST(linked_tree_parser_test,
+     test_parallel_registration_matches_serial_at_any_depth) {
+  auto root = makeDeepTree();
+  LinkedTreeParser serial;
+  root->registerContents(serial);
+
+  // Parsed by bank with 2 threads, and by tube with 4 or more
+  for (size_t threadCount : {2, 4, 16}) {
+    setParallelThreadCount(threadCount);
+    LinkedTreeParser parallel;
+    parallel.registerCompositeInParallel(root.get());
+    setParallelThreadCount(0);
+    SCOPED_TRACE(threadCount);
+    expectSameRegistration(serial, parallel);
+  }
+}
 }
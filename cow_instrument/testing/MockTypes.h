@@ -80,18 +80,19 @@ public:
   virtual size_t samplePathIndex() const = 0;
   virtual size_t sourcePathIndex() const = 0;
   virtual size_t componentSize() const = 0;
-  virtual std::vector<Eigen::Vector3d> startPositions() const = 0;
-  virtual std::vector<Eigen::Quaterniond> startRotations() const = 0;
+  virtual const std::vector<Eigen::Vector3d> &startPositions() const = 0;
+  virtual const std::vector<Eigen::Quaterniond> &startRotations() const = 0;
   virtual std::vector<size_t> subTreeIndexes(size_t proxyIndex) const = 0;
   virtual std::vector<size_t> nextLevelIndexes(size_t proxyIndex) const = 0;
+  virtual SubTree subTree(size_t proxyIndex) const = 0;
   virtual size_t detIndexToCompIndex(size_t detectorIndex) const = 0;
   virtual size_t pathIndexToCompIndex(size_t pathIndex) const = 0;
-  virtual std::vector<Eigen::Vector3d> startEntryPoints() const = 0;
-  virtual std::vector<Eigen::Vector3d> startExitPoints() const = 0;
-  virtual std::vector<double> pathLengths() const = 0;
-  virtual std::vector<size_t> detectorComponentIndexes() const = 0;
-  virtual std::vector<size_t> pathComponentIndexes() const = 0;
-  virtual std::vector<size_t> branchNodeComponentIndexes() const = 0;
+  virtual const std::vector<Eigen::Vector3d> &startEntryPoints() const = 0;
+  virtual const std::vector<Eigen::Vector3d> &startExitPoints() const = 0;
+  virtual const std::vector<double> &pathLengths() const = 0;
+  virtual const std::vector<IndexType> &detectorComponentIndexes() const = 0;
+  virtual const std::vector<IndexType> &pathComponentIndexes() const = 0;
+  virtual const std::vector<IndexType> &branchNodeComponentIndexes() const = 0;
   virtual ~PolymorphicFlatTree() {}
 };
 
@@ -101,27 +102,32 @@ public:
     ON_CALL(*this, nDetectors()).WillByDefault(testing::Return(0));
     ON_CALL(*this, nPathComponents()).WillByDefault(testing::Return(1));
     ON_CALL(*this, detectorComponentIndexes())
-        .WillByDefault(testing::Return(std::vector<size_t>(0, 0)));
+        .WillByDefault(testing::ReturnRefOfCopy(std::vector<IndexType>(0, 0)));
     ON_CALL(*this, pathComponentIndexes())
-        .WillByDefault(testing::Return(std::vector<size_t>(1, 0)));
+        .WillByDefault(testing::ReturnRefOfCopy(std::vector<IndexType>(1, 0)));
+    ON_CALL(*this, branchNodeComponentIndexes())
+        .WillByDefault(testing::ReturnRefOfCopy(std::vector<IndexType>()));
     ON_CALL(*this, samplePathIndex()).WillByDefault(testing::Return(size_t(0)));
     ON_CALL(*this, sourcePathIndex()).WillByDefault(testing::Return(size_t(0)));
     ON_CALL(*this, componentSize()).WillByDefault(testing::Return(1));
+    ON_CALL(*this, subTree(testing::_))
+        .WillByDefault(
+            testing::Return(SubTree{{0, 1}, {0, 0}, {0, 1}, {0, 0}}));
     ON_CALL(*this, startPositions())
-        .WillByDefault(testing::Return(
+        .WillByDefault(testing::ReturnRefOfCopy(
             std::vector<Eigen::Vector3d>(1 /*componentSize()*/, {0, 0, 0})));
     ON_CALL(*this, startRotations())
-        .WillByDefault(testing::Return(std::vector<Eigen::Quaterniond>(
+        .WillByDefault(testing::ReturnRefOfCopy(std::vector<Eigen::Quaterniond>(
             1 /*componentSize()*/,
             Eigen::Quaterniond(Eigen::Affine3d::Identity().rotation()))));
     ON_CALL(*this, startEntryPoints())
-        .WillByDefault(testing::Return(
+        .WillByDefault(testing::ReturnRefOfCopy(
             std::vector<Eigen::Vector3d>(1 /*componentSize()*/, {0, 0, 0})));
     ON_CALL(*this, startExitPoints())
-        .WillByDefault(testing::Return(
+        .WillByDefault(testing::ReturnRefOfCopy(
             std::vector<Eigen::Vector3d>(1 /*componentSize()*/, {0, 0, 0})));
     ON_CALL(*this, pathLengths())
-        .WillByDefault(testing::Return(
+        .WillByDefault(testing::ReturnRefOfCopy(
             std::vector<double>(1 /*componentSize()*/, 0)));
   }
 
@@ -129,33 +135,39 @@ public:
     ON_CALL(*this, nDetectors()).WillByDefault(testing::Return(nDetectors));
     ON_CALL(*this, nPathComponents()).WillByDefault(testing::Return(1));
     ON_CALL(*this, detectorComponentIndexes())
-        .WillByDefault(testing::Return(std::vector<size_t>(nDetectors, 0)));
+        .WillByDefault(
+            testing::ReturnRefOfCopy(std::vector<IndexType>(nDetectors, 0)));
 
-    std::vector<size_t> pathComponentIndexesData(1);
+    std::vector<IndexType> pathComponentIndexesData(1);
     std::iota(pathComponentIndexesData.begin(), pathComponentIndexesData.end(),
               nDetectors);
     ON_CALL(*this, pathComponentIndexes())
-        .WillByDefault(testing::Return(pathComponentIndexesData));
+        .WillByDefault(testing::ReturnRefOfCopy(pathComponentIndexesData));
 
+    ON_CALL(*this, branchNodeComponentIndexes())
+        .WillByDefault(testing::ReturnRefOfCopy(std::vector<IndexType>()));
     ON_CALL(*this, samplePathIndex()).WillByDefault(testing::Return(size_t(0)));
     ON_CALL(*this, sourcePathIndex()).WillByDefault(testing::Return(size_t(0)));
     ON_CALL(*this, componentSize())
         .WillByDefault(testing::Return(nDetectors + 1));
+    ON_CALL(*this, subTree(testing::_))
+        .WillByDefault(testing::Return(SubTree{
+            {0, nDetectors + 1}, {0, nDetectors}, {0, 1}, {0, 0}}));
     ON_CALL(*this, startPositions())
-        .WillByDefault(testing::Return(
+        .WillByDefault(testing::ReturnRefOfCopy(
             std::vector<Eigen::Vector3d>(1 /*componentSize()*/, {0, 0, 0})));
     ON_CALL(*this, startRotations())
-        .WillByDefault(testing::Return(std::vector<Eigen::Quaterniond>(
+        .WillByDefault(testing::ReturnRefOfCopy(std::vector<Eigen::Quaterniond>(
             1 /*componentSize()*/,
             Eigen::Quaterniond(Eigen::Affine3d::Identity().rotation()))));
     ON_CALL(*this, startEntryPoints())
-        .WillByDefault(testing::Return(
+        .WillByDefault(testing::ReturnRefOfCopy(
             std::vector<Eigen::Vector3d>(1 /*componentSize()*/, {0, 0, 0})));
     ON_CALL(*this, startExitPoints())
-        .WillByDefault(testing::Return(
+        .WillByDefault(testing::ReturnRefOfCopy(
             std::vector<Eigen::Vector3d>(1 /*componentSize()*/, {0, 0, 0})));
     ON_CALL(*this, pathLengths())
-        .WillByDefault(testing::Return(
+        .WillByDefault(testing::ReturnRefOfCopy(
             std::vector<double>(1 /*componentSize()*/, 0)));
   }
   MOCK_CONST_METHOD0(nDetectors, size_t());
@@ -164,18 +176,22 @@ public:
   MOCK_CONST_METHOD0(samplePathIndex, size_t());
   MOCK_CONST_METHOD0(sourcePathIndex, size_t());
   MOCK_CONST_METHOD0(componentSize, size_t());
-  MOCK_CONST_METHOD0(startPositions, std::vector<Eigen::Vector3d>());
-  MOCK_CONST_METHOD0(startRotations, std::vector<Eigen::Quaterniond>());
+  MOCK_CONST_METHOD0(startPositions, const std::vector<Eigen::Vector3d> &());
+  MOCK_CONST_METHOD0(startRotations, const std::vector<Eigen::Quaterniond> &());
   MOCK_CONST_METHOD1(subTreeIndexes, std::vector<size_t>(size_t));
   MOCK_CONST_METHOD1(nextLevelIndexes, std::vector<size_t>(size_t));
+  MOCK_CONST_METHOD1(subTree, SubTree(size_t));
   MOCK_CONST_METHOD1(detIndexToCompIndex, size_t(size_t));
   MOCK_CONST_METHOD1(pathIndexToCompIndex, size_t(size_t));
-  MOCK_CONST_METHOD0(startEntryPoints, std::vector<Eigen::Vector3d>());
-  MOCK_CONST_METHOD0(startExitPoints, std::vector<Eigen::Vector3d>());
-  MOCK_CONST_METHOD0(pathLengths, std::vector<double>());
-  MOCK_CONST_METHOD0(detectorComponentIndexes, std::vector<size_t>());
-  MOCK_CONST_METHOD0(pathComponentIndexes, std::vector<size_t>());
-  MOCK_CONST_METHOD0(branchNodeComponentIndexes, std::vector<size_t>());
+  MOCK_CONST_METHOD0(startEntryPoints, const std::vector<Eigen::Vector3d> &());
+  MOCK_CONST_METHOD0(startExitPoints, const std::vector<Eigen::Vector3d> &());
+  MOCK_CONST_METHOD0(pathLengths, const std::vector<double> &());
+  MOCK_CONST_METHOD0(detectorComponentIndexes,
+                     const std::vector<IndexType> &());
+  MOCK_CONST_METHOD0(pathComponentIndexes,
+                     const std::vector<IndexType> &());
+  MOCK_CONST_METHOD0(branchNodeComponentIndexes,
+                     const std::vector<IndexType> &());
 
   virtual ~MockFlatTree() {}
 };
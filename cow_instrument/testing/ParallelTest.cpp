@@ -0,0 +1,86 @@
+#include "Parallel.h"
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+/// Restores the default thread count when a test ends
+struct ThreadCountGuard {
+  explicit ThreadCountGuard(size_t threadCount) {
+    setParallelThreadCount(threadCount);
+  }
+  ~ThreadCountGuard() { setParallelThreadCount(0); }
+};
+
+TEST(parallel_test, test_default_thread_count) {
+  setParallelThreadCount(0);
+  EXPECT_GE(parallelThreadCount(), 1);
+}
+
+TEST(parallel_test, test_set_thread_count) {
+  ThreadCountGuard guard(3);
+  EXPECT_EQ(3, parallelThreadCount());
+}
+
+TEST(parallel_test, test_visits_every_index_once) {
+  ThreadCountGuard guard(4);
+  // Not a multiple of the grain size
+  const size_t size = 10 * parallelGrainSize + 7;
+  std::vector<int> visits(size, 0);
+  parallelFor(size, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      ++visits[i];
+    }
+  });
+  for (size_t i = 0; i < size; ++i) {
+    EXPECT_EQ(1, visits[i]) << "Index " << i;
+  }
+}
+
+TEST(parallel_test, test_chunks_start_on_grain_boundaries) {
+  ThreadCountGuard guard(4);
+  const size_t size = 10 * parallelGrainSize + 7;
+  std::vector<size_t> begins(size, size);
+  parallelFor(size, [&](size_t begin, size_t) { begins[begin] = begin; });
+  for (size_t i = 0; i < size; ++i) {
+    if (begins[i] != size) {
+      EXPECT_EQ(0, i % parallelGrainSize);
+    }
+  }
+}
+
+TEST(parallel_test, test_empty_range) {
+  ThreadCountGuard guard(4);
+  bool called = false;
+  parallelFor(0, [&](size_t, size_t) { called = true; });
+  EXPECT_FALSE(called);
+}
+
+TEST(parallel_test, test_exceptions_propagate) {
+  ThreadCountGuard guard(4);
+  const size_t size = 8 * parallelGrainSize;
+  EXPECT_THROW(parallelFor(size,
+                           [&](size_t, size_t end) {
+                             if (end == size) {
+                               throw std::logic_error("Last chunk failed");
+                             }
+                           }),
+               std::logic_error);
+}
+
+TEST(parallel_test, test_tasks_run_once_and_propagate_exceptions) {
+  ThreadCountGuard guard(4);
+  std::vector<int> runs(7, 0);
+  parallelTasks(runs.size(), [&](size_t task) { ++runs[task]; });
+  EXPECT_EQ(std::vector<int>(7, 1), runs);
+
+  EXPECT_THROW(parallelTasks(runs.size(),
+                             [](size_t task) {
+                               if (task == 3) {
+                                 throw std::logic_error("Task failed");
+                               }
+                             }),
+               std::logic_error);
+}
+}
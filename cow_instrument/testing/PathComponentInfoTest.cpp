@@ -17,19 +17,19 @@ TEST(path_info_test, test_construct_simple) {
   EXPECT_CALL(*pMockInstrumentTree, nPathComponents())
       .WillRepeatedly(testing::Return(1));
   EXPECT_CALL(*pMockInstrumentTree, startPositions())
-      .WillRepeatedly(
-          testing::Return(std::vector<Eigen::Vector3d>(1, {0.5, 0, 0})));
+      .WillRepeatedly(testing::ReturnRefOfCopy(
+          std::vector<Eigen::Vector3d>(1, {0.5, 0, 0})));
   EXPECT_CALL(*pMockInstrumentTree, startRotations())
-      .WillRepeatedly(testing::Return(std::vector<Eigen::Quaterniond>(
+      .WillRepeatedly(testing::ReturnRefOfCopy(std::vector<Eigen::Quaterniond>(
           1, Eigen::Quaterniond(Eigen::Affine3d::Identity().rotation()))));
   EXPECT_CALL(*pMockInstrumentTree, startEntryPoints())
       .WillRepeatedly(
-          testing::Return(std::vector<Eigen::Vector3d>(1, {0, 0, 0})));
+          testing::ReturnRefOfCopy(std::vector<Eigen::Vector3d>(1, {0, 0, 0})));
   EXPECT_CALL(*pMockInstrumentTree, startExitPoints())
       .WillRepeatedly(
-          testing::Return(std::vector<Eigen::Vector3d>(1, {1, 0, 0})));
+          testing::ReturnRefOfCopy(std::vector<Eigen::Vector3d>(1, {1, 0, 0})));
   EXPECT_CALL(*pMockInstrumentTree, pathComponentIndexes())
-      .WillRepeatedly(testing::Return(std::vector<size_t>(1, 0)));
+      .WillRepeatedly(testing::ReturnRefOfCopy(std::vector<IndexType>(1, 0)));
 
   std::shared_ptr<MockFlatTree> mockInstrumentTree{pMockInstrumentTree};
   PathComponentInfo<MockFlatTree> pathComponentInfo(mockInstrumentTree);
@@ -37,6 +37,9 @@ TEST(path_info_test, test_construct_simple) {
   EXPECT_EQ(pathComponentInfo.position(0), (Eigen::Vector3d{0.5, 0, 0}));
   EXPECT_EQ(pathComponentInfo.entryPoint(0), (Eigen::Vector3d{0, 0, 0}));
   EXPECT_EQ(pathComponentInfo.exitPoint(0), (Eigen::Vector3d{1, 0, 0}));
+  EXPECT_EQ(1, pathComponentInfo.positions().size());
+  EXPECT_EQ(pathComponentInfo.positions()[0], (Eigen::Vector3d{0.5, 0, 0}));
+  EXPECT_EQ(1, pathComponentInfo.rotations().size());
 
   EXPECT_TRUE(testing::Mock::VerifyAndClear(pMockInstrumentTree))
       << "InstrumentTree used incorrectly";
@@ -58,19 +61,19 @@ TEST(path_info_test, test_construct_more_complex) {
   positions.push_back({4, 0, 0});
 
   EXPECT_CALL(*pMockInstrumentTree, startPositions())
-      .WillRepeatedly(testing::Return(positions));
+      .WillRepeatedly(testing::ReturnRefOfCopy(positions));
   EXPECT_CALL(*pMockInstrumentTree, startRotations())
-      .WillRepeatedly(testing::Return(std::vector<Eigen::Quaterniond>(
+      .WillRepeatedly(testing::ReturnRefOfCopy(std::vector<Eigen::Quaterniond>(
           4, Eigen::Quaterniond(Eigen::Affine3d::Identity().rotation()))));
   EXPECT_CALL(*pMockInstrumentTree, startEntryPoints())
       .WillRepeatedly(
-          testing::Return(std::vector<Eigen::Vector3d>(4, {0, 0, 0})));
+          testing::ReturnRefOfCopy(std::vector<Eigen::Vector3d>(4, {0, 0, 0})));
   EXPECT_CALL(*pMockInstrumentTree, startExitPoints())
       .WillRepeatedly(
-          testing::Return(std::vector<Eigen::Vector3d>(4, {0, 0, 0})));
+          testing::ReturnRefOfCopy(std::vector<Eigen::Vector3d>(4, {0, 0, 0})));
   // Only index 2 and 3 of components are path components
   EXPECT_CALL(*pMockInstrumentTree, pathComponentIndexes())
-      .WillRepeatedly(testing::Return(std::vector<size_t>({2, 3})));
+      .WillRepeatedly(testing::ReturnRefOfCopy(std::vector<IndexType>({2, 3})));
 
   std::shared_ptr<MockFlatTree> mockInstrumentTree{pMockInstrumentTree};
   PathComponentInfo<MockFlatTree> pathComponentInfo(mockInstrumentTree);
@@ -116,18 +119,18 @@ void do_test_rotation(bool rotateAsSingleItem) {
       .WillRepeatedly(testing::Return(1));
   EXPECT_CALL(*pMockInstrumentTree, startPositions())
       .WillRepeatedly(
-          testing::Return(std::vector<Eigen::Vector3d>(1, {1, 0, 0})));
+          testing::ReturnRefOfCopy(std::vector<Eigen::Vector3d>(1, {1, 0, 0})));
   EXPECT_CALL(*pMockInstrumentTree, startRotations())
-      .WillRepeatedly(testing::Return(std::vector<Eigen::Quaterniond>(
+      .WillRepeatedly(testing::ReturnRefOfCopy(std::vector<Eigen::Quaterniond>(
           1, Eigen::Quaterniond(Eigen::Affine3d::Identity().rotation()))));
   EXPECT_CALL(*pMockInstrumentTree, startEntryPoints())
-      .WillRepeatedly(
-          testing::Return(std::vector<Eigen::Vector3d>(1, {-1, 0, 0})));
+      .WillRepeatedly(testing::ReturnRefOfCopy(
+          std::vector<Eigen::Vector3d>(1, {-1, 0, 0})));
   EXPECT_CALL(*pMockInstrumentTree, startExitPoints())
       .WillRepeatedly(
-          testing::Return(std::vector<Eigen::Vector3d>(1, {2, 0, 0})));
+          testing::ReturnRefOfCopy(std::vector<Eigen::Vector3d>(1, {2, 0, 0})));
   EXPECT_CALL(*pMockInstrumentTree, pathComponentIndexes())
-      .WillRepeatedly(testing::Return(std::vector<size_t>(1, 0)));
+      .WillRepeatedly(testing::ReturnRefOfCopy(std::vector<IndexType>(1, 0)));
 
   std::shared_ptr<MockFlatTree> mockInstrumentTree{pMockInstrumentTree};
   PathComponentInfo<MockFlatTree> pathComponentInfo(mockInstrumentTree);
@@ -179,18 +182,18 @@ void do_test_position(bool moveAsSingleItem) {
       .WillRepeatedly(testing::Return(1));
   EXPECT_CALL(*pMockInstrumentTree, startPositions())
       .WillRepeatedly(
-          testing::Return(std::vector<Eigen::Vector3d>(1, {1, 0, 0})));
+          testing::ReturnRefOfCopy(std::vector<Eigen::Vector3d>(1, {1, 0, 0})));
   EXPECT_CALL(*pMockInstrumentTree, startRotations())
-      .WillRepeatedly(testing::Return(std::vector<Eigen::Quaterniond>(
+      .WillRepeatedly(testing::ReturnRefOfCopy(std::vector<Eigen::Quaterniond>(
           1, Eigen::Quaterniond(Eigen::Affine3d::Identity().rotation()))));
   EXPECT_CALL(*pMockInstrumentTree, startEntryPoints())
       .WillRepeatedly(
-          testing::Return(std::vector<Eigen::Vector3d>(1, {2, 0, 0})));
+          testing::ReturnRefOfCopy(std::vector<Eigen::Vector3d>(1, {2, 0, 0})));
   EXPECT_CALL(*pMockInstrumentTree, startExitPoints())
       .WillRepeatedly(
-          testing::Return(std::vector<Eigen::Vector3d>(1, {3, 0, 0})));
+          testing::ReturnRefOfCopy(std::vector<Eigen::Vector3d>(1, {3, 0, 0})));
   EXPECT_CALL(*pMockInstrumentTree, pathComponentIndexes())
-      .WillRepeatedly(testing::Return(std::vector<size_t>(1, 0)));
+      .WillRepeatedly(testing::ReturnRefOfCopy(std::vector<IndexType>(1, 0)));
 
   std::shared_ptr<MockFlatTree> mockInstrumentTree{pMockInstrumentTree};
   PathComponentInfo<MockFlatTree> pathComponentInfo(mockInstrumentTree);
@@ -0,0 +1,40 @@
+#include "Path.h"
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+namespace {
+
+TEST(paths_test, test_construct_shared_path) {
+  Paths paths(3, Path{4, 5});
+  EXPECT_EQ(3, paths.size());
+  EXPECT_EQ(1, paths.uniqueSize());
+  for (size_t i = 0; i < paths.size(); ++i) {
+    EXPECT_EQ(0, paths.pathId(i));
+    EXPECT_EQ(Path({4, 5}), paths[i]);
+  }
+}
+
+TEST(paths_test, test_construct_stores_unique_paths_once) {
+  Paths paths(std::vector<Path>{Path{0, 1}, Path{2}, Path{0, 1}, Path{2}});
+  EXPECT_EQ(4, paths.size());
+  EXPECT_EQ(2, paths.uniqueSize());
+  EXPECT_EQ(paths.pathId(0), paths.pathId(2));
+  EXPECT_EQ(paths.pathId(1), paths.pathId(3));
+  EXPECT_NE(paths.pathId(0), paths.pathId(1));
+  EXPECT_EQ(Path({0, 1}), paths[2]);
+  EXPECT_EQ(Path({2}), paths[3]);
+}
+
+TEST(paths_test, test_construct_from_ids) {
+  Paths paths(std::vector<Path>{Path{0, 1}, Path{2}},
+              std::vector<PathId>{1, 1, 0});
+  EXPECT_EQ(3, paths.size());
+  EXPECT_EQ(Path({2}), paths[0]);
+  EXPECT_EQ(Path({0, 1}), paths[2]);
+}
+
+TEST(paths_test, test_construct_from_bad_ids_throws) {
+  EXPECT_THROW(Paths(std::vector<Path>{Path{0}}, std::vector<PathId>{0, 1}),
+               std::out_of_range);
+}
+}
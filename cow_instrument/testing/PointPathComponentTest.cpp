@@ -61,10 +61,9 @@ TEST(point_path_component_test, test_register_contents) {
   EXPECT_EQ(info.pathSize(), 1);
   EXPECT_EQ(info.pathComponentIndexes().size(), 1);
   EXPECT_EQ(info.detectorComponentIndexes().size(), 0);
-  EXPECT_EQ(info.proxies().size(), 1) << "Proxies should grow";
+  EXPECT_EQ(info.parents().size(), 1) << "Parents should grow";
 
-  EXPECT_FALSE(info.proxies()[0].hasParent());
-  EXPECT_FALSE(info.proxies()[0].hasChildren());
+  EXPECT_EQ(info.parents()[0], -1) << "Should have no parent";
   EXPECT_EQ(info.pathComponentIndexes()[0], 0)
       << "Should be pointing to the zeroth index of proxies";
 }
@@ -0,0 +1,77 @@
+#include "Positions.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+template <typename T> class PositionsTest : public ::testing::Test {};
+
+typedef ::testing::Types<AoSPositions, SoAPositions> PositionsTypes;
+TYPED_TEST_CASE(PositionsTest, PositionsTypes);
+
+std::vector<Eigen::Vector3d> makePositions() {
+  return {Eigen::Vector3d{1, 2, 3}, Eigen::Vector3d{4, 5, 6},
+          Eigen::Vector3d{7, 8, 9}};
+}
+
+TYPED_TEST(PositionsTest, test_construct_from_vector) {
+  TypeParam positions(makePositions());
+  EXPECT_EQ(3, positions.size());
+  EXPECT_EQ(Eigen::Vector3d(4, 5, 6), Eigen::Vector3d(positions[1]));
+}
+
+TYPED_TEST(PositionsTest, test_set) {
+  TypeParam positions(size_t(2));
+  positions.set(1, Eigen::Vector3d{1, 2, 3});
+  EXPECT_EQ(Eigen::Vector3d(0, 0, 0), Eigen::Vector3d(positions[0]));
+  EXPECT_EQ(Eigen::Vector3d(1, 2, 3), Eigen::Vector3d(positions[1]));
+}
+
+TYPED_TEST(PositionsTest, test_translate) {
+  TypeParam positions(makePositions());
+  positions.translate(0, Eigen::Vector3d{1, 0, 0});
+  positions.translate(std::vector<size_t>{1, 2}, Eigen::Vector3d{0, 0, -1});
+  EXPECT_EQ(Eigen::Vector3d(2, 2, 3), Eigen::Vector3d(positions[0]));
+  EXPECT_EQ(Eigen::Vector3d(4, 5, 5), Eigen::Vector3d(positions[1]));
+  EXPECT_EQ(Eigen::Vector3d(7, 8, 8), Eigen::Vector3d(positions[2]));
+}
+
+TYPED_TEST(PositionsTest, test_transform) {
+  using namespace Eigen;
+  TypeParam positions(makePositions());
+  const auto original = makePositions();
+  const Vector3d center{1, 1, 1};
+  const auto transform = Translation3d(center) *
+                         AngleAxisd(M_PI / 2, Vector3d::UnitZ()) *
+                         Translation3d(-center);
+  positions.transform(0, transform);
+  positions.transform(std::vector<size_t>{1, 2}, transform);
+  for (size_t i = 0; i < original.size(); ++i) {
+    EXPECT_TRUE((transform * original[i]).isApprox(positions[i], 1e-12));
+  }
+}
+
+TYPED_TEST(PositionsTest, test_distance) {
+  TypeParam positions(makePositions());
+  EXPECT_DOUBLE_EQ(std::sqrt(27.0),
+                   positions.distance(1, Eigen::Vector3d{1, 2, 3}));
+}
+
+TEST(positions_test, test_aos_map_is_per_column) {
+  AoSPositions positions(makePositions());
+  auto map = positions.map();
+  EXPECT_EQ(3, map.rows());
+  EXPECT_EQ(3, map.cols());
+  EXPECT_EQ(Eigen::Vector3d(4, 5, 6), Eigen::Vector3d(map.col(1)));
+}
+
+TEST(positions_test, test_soa_map_is_per_row) {
+  SoAPositions positions(makePositions());
+  auto map = positions.map();
+  EXPECT_EQ(3, map.rows());
+  EXPECT_EQ(3, map.cols());
+  EXPECT_EQ(Eigen::Vector3d(4, 5, 6), Eigen::Vector3d(map.row(1)));
+  // Each axis is contiguous
+  EXPECT_EQ(positions.y(), map.col(1).data());
+  EXPECT_EQ(1, map.col(1).innerStride());
+}
+}
@@ -0,0 +1,145 @@
+#include "ComponentInfo.h"
+#include "CompositeComponent.h"
+#include "DetectorComponent.h"
+#include "DetectorInfo.h"
+#include "FlatTree.h"
+#include "PointSample.h"
+#include "PointSource.h"
+#include "RelativeComponentInfo.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::shared_ptr<FlatTree> makeInstrumentTree() {
+  /*
+
+        A
+        |
+ ------------------------------
+ |                |           |
+ T (trolley)      C (source)  D (sample)
+ |
+ B (bank)
+ |
+ -------
+ |     |
+ E     F (detectors)
+
+  */
+
+  auto bank = std::unique_ptr<CompositeComponent>(
+      new CompositeComponent(ComponentIdType(3)));
+  bank->addComponent(std::unique_ptr<DetectorComponent>(new DetectorComponent(
+      ComponentIdType(4), DetectorIdType(1), Eigen::Vector3d{1, 1, 5})));
+  bank->addComponent(std::unique_ptr<DetectorComponent>(new DetectorComponent(
+      ComponentIdType(5), DetectorIdType(2), Eigen::Vector3d{-1, 1, 5})));
+
+  auto trolley = std::unique_ptr<CompositeComponent>(
+      new CompositeComponent(ComponentIdType(2)));
+  trolley->addComponent(std::move(bank));
+
+  auto a = std::make_shared<CompositeComponent>(ComponentIdType(1));
+  a->addComponent(std::move(trolley));
+  a->addComponent(std::unique_ptr<PointSource>(
+      new PointSource(Eigen::Vector3d{0, 0, -10}, ComponentIdType(6))));
+  a->addComponent(std::unique_ptr<PointSample>(
+      new PointSample(Eigen::Vector3d{0, 0, 0}, ComponentIdType(7))));
+
+  return std::make_shared<FlatTree>(a);
+}
+
+void expectSameTransforms(const ComponentInfo<FlatTree> &absolute,
+                          const RelativeComponentInfo<FlatTree> &relative) {
+  ASSERT_EQ(absolute.componentSize(), relative.componentSize());
+  for (size_t i = 0; i < absolute.componentSize(); ++i) {
+    EXPECT_TRUE(absolute.position(i).isApprox(relative.position(i), 1e-12))
+        << "Position of component " << i;
+    EXPECT_TRUE(absolute.rotation(i).isApprox(relative.rotation(i), 1e-12))
+        << "Rotation of component " << i;
+  }
+}
+
+TEST(relative_component_info_test, test_construct) {
+  auto instrument = makeInstrumentTree();
+  ComponentInfo<FlatTree> absolute{DetectorInfo<FlatTree>(instrument)};
+  RelativeComponentInfo<FlatTree> relative(instrument);
+
+  expectSameTransforms(absolute, relative);
+  EXPECT_TRUE(relative.relativePosition(0).isApprox(absolute.position(0)))
+      << "Root is relative to the origin";
+}
+
+TEST(relative_component_info_test, test_edits_match_component_info) {
+  auto instrument = makeInstrumentTree();
+  ComponentInfo<FlatTree> absolute{DetectorInfo<FlatTree>(instrument)};
+  RelativeComponentInfo<FlatTree> relative(instrument);
+
+  const Eigen::Vector3d up{0, 1, 0};
+  const Eigen::Vector3d beam{0, 0, 1};
+  const Eigen::Vector3d origin{0, 0, 0};
+  relative.rotate(1, up, M_PI / 3, origin);     // Trolley about the sample
+  relative.move(2, Eigen::Vector3d{0, 0.5, 0}); // Bank
+  relative.rotate(0, beam, M_PI / 7, origin);   // Whole instrument
+  relative.rotate(3, up, M_PI / 2, relative.position(3)); // One detector
+  absolute.rotate(1, up, M_PI / 3, origin);
+  absolute.move(2, Eigen::Vector3d{0, 0.5, 0});
+  absolute.rotate(0, beam, M_PI / 7, origin);
+  absolute.rotate(3, up, M_PI / 2, absolute.position(3));
+
+  expectSameTransforms(absolute, relative);
+}
+
+TEST(relative_component_info_test, test_rotate_writes_only_the_component) {
+  auto instrument = makeInstrumentTree();
+  RelativeComponentInfo<FlatTree> relative(instrument);
+  const auto bankRelative = relative.relativePosition(2);
+  const auto detectorRelative = relative.relativePosition(3);
+
+  relative.rotate(1, Eigen::Vector3d{0, 1, 0}, M_PI / 2,
+                  Eigen::Vector3d{0, 0, 0});
+
+  EXPECT_EQ(bankRelative, relative.relativePosition(2));
+  EXPECT_EQ(detectorRelative, relative.relativePosition(3));
+  EXPECT_TRUE(relative.position(3).isApprox(Eigen::Vector3d{5, 1, -1}, 1e-12))
+      << "Absolute position composed through the rotated trolley";
+  EXPECT_TRUE(relative.position(5).isApprox(Eigen::Vector3d{0, 0, -10}))
+      << "Source is not below the trolley";
+}
+
+TEST(relative_component_info_test, test_copy_is_independent) {
+  auto instrument = makeInstrumentTree();
+  RelativeComponentInfo<FlatTree> original(instrument);
+  const auto before = original.position(3);
+
+  auto copy = original;
+  copy.move(0, Eigen::Vector3d{1, 0, 0});
+
+  EXPECT_EQ(before, original.position(3));
+  EXPECT_TRUE(copy.position(3).isApprox(before + Eigen::Vector3d{1, 0, 0}));
+}
+
+TEST(relative_component_info_test, test_concurrent_reads_after_write) {
+  auto instrument = makeInstrumentTree();
+  RelativeComponentInfo<FlatTree> relative(instrument);
+  relative.rotate(0, Eigen::Vector3d{0, 1, 0}, M_PI / 2,
+                  Eigen::Vector3d{0, 0, 0});
+  const auto shared = relative; // Shares the stale cache
+  relative.position(0);         // Recompose the original only
+
+  // Readers race to recompose the copy
+  std::vector<Eigen::Vector3d> read(8);
+  std::vector<std::thread> readers;
+  for (size_t i = 0; i < read.size(); ++i) {
+    readers.emplace_back([&, i]() { read[i] = shared.position(3); });
+  }
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  for (const auto &position : read) {
+    EXPECT_TRUE(position.isApprox(relative.position(3), 1e-12));
+  }
+}
+}
@@ -0,0 +1,83 @@
+#include "ScatteringAngles.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+const BeamFrame frame(Eigen::Vector3d{0, 0, 1}, Eigen::Vector3d::UnitY());
+
+TEST(scattering_angles_test, test_forward_scattering) {
+  ScatteringAngles angles(1);
+  angles.set(0, frame, Eigen::Vector3d{0, 0, 2});
+  EXPECT_EQ(0, angles.twoTheta(0));
+  EXPECT_EQ(0, angles.signedTwoTheta(0));
+  EXPECT_EQ(0, angles.sinTheta(0));
+  EXPECT_EQ(1, angles.cosTwoTheta(0));
+}
+
+TEST(scattering_angles_test, test_right_angle) {
+  ScatteringAngles angles(2);
+  angles.set(0, frame, Eigen::Vector3d{1, 0, 0});
+  angles.set(1, frame, Eigen::Vector3d{-1, 0, 0});
+
+  EXPECT_DOUBLE_EQ(M_PI / 2, angles.twoTheta(0));
+  EXPECT_DOUBLE_EQ(M_PI / 2, angles.twoTheta(1));
+  EXPECT_DOUBLE_EQ(std::sin(M_PI / 4), angles.sinTheta(0));
+  EXPECT_NEAR(0, angles.cosTwoTheta(0), 1e-15);
+  EXPECT_DOUBLE_EQ(0, angles.phi(0));
+  EXPECT_DOUBLE_EQ(M_PI, angles.phi(1));
+  EXPECT_DOUBLE_EQ(M_PI / 2, angles.signedTwoTheta(0));
+  EXPECT_DOUBLE_EQ(-M_PI / 2, angles.signedTwoTheta(1))
+      << "Opposite sides of the beam should have opposite signs";
+}
+
+TEST(scattering_angles_test, test_back_scattering) {
+  ScatteringAngles angles(1);
+  angles.set(0, frame, Eigen::Vector3d{0, 0, -1});
+  EXPECT_DOUBLE_EQ(M_PI, angles.twoTheta(0));
+  EXPECT_DOUBLE_EQ(1, angles.sinTheta(0));
+  EXPECT_DOUBLE_EQ(-1, angles.cosTwoTheta(0));
+}
+
+TEST(scattering_angles_test, test_bulk_arrays) {
+  ScatteringAngles angles(3);
+  angles.set(1, frame, Eigen::Vector3d{0, 1, 0});
+  EXPECT_EQ(3, angles.size());
+  EXPECT_EQ(3, angles.twoThetas().size());
+  EXPECT_DOUBLE_EQ(M_PI / 2, angles.twoThetas()[1]);
+  EXPECT_DOUBLE_EQ(M_PI / 2, angles.phis()[1]);
+  EXPECT_EQ(angles.sinTheta(1), angles.sinThetas()[1]);
+  EXPECT_EQ(angles.cosTwoTheta(1), angles.cosTwoThetas()[1]);
+  EXPECT_EQ(angles.signedTwoTheta(1), angles.signedTwoThetas()[1]);
+}
+
+TEST(scattering_angles_test, test_beam_frame_is_orthonormal) {
+  const BeamFrame tilted(Eigen::Vector3d{2, 1, 0}, Eigen::Vector3d::UnitY());
+  const BeamFrame vertical(Eigen::Vector3d{0, 3, 0}, Eigen::Vector3d::UnitY());
+  for (const auto &f : {tilted, vertical}) {
+    EXPECT_NEAR(1, f.x.norm(), 1e-15);
+    EXPECT_NEAR(1, f.y.norm(), 1e-15);
+    EXPECT_NEAR(0, f.x.dot(f.y), 1e-15);
+    EXPECT_TRUE(f.x.cross(f.y).isApprox(f.z)) << "Right handed";
+  }
+  EXPECT_TRUE(tilted.z.isApprox(Eigen::Vector3d{2, 1, 0}.normalized()));
+  EXPECT_GT(tilted.y.dot(Eigen::Vector3d::UnitY()), 0) << "y points up";
+}
+
+TEST(scattering_angles_test, test_phi_about_beam_along_x) {
+  // Beam along x, y up: the frame has x = -z, z = x in the lab.
+  const BeamFrame alongX(Eigen::Vector3d{1, 0, 0}, Eigen::Vector3d::UnitY());
+  ScatteringAngles angles(3);
+  angles.set(0, alongX, Eigen::Vector3d{0, 0, -1});
+  angles.set(1, alongX, Eigen::Vector3d{0, 1, 0});
+  angles.set(2, alongX, Eigen::Vector3d{5, 0, 1});
+
+  EXPECT_DOUBLE_EQ(0, angles.phi(0));
+  EXPECT_DOUBLE_EQ(M_PI / 2, angles.phi(1));
+  EXPECT_DOUBLE_EQ(M_PI, angles.phi(2))
+      << "Phi must not depend on the component along the beam";
+  EXPECT_DOUBLE_EQ(M_PI / 2, angles.signedTwoTheta(0));
+  EXPECT_DOUBLE_EQ(-std::atan2(1, 5), angles.signedTwoTheta(2));
+  EXPECT_EQ(angles.phi(2),
+            ScatteringAngles::phi(alongX, Eigen::Vector3d{5, 0, 1}));
+}
+}
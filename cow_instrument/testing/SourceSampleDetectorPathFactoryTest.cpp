@@ -51,6 +51,7 @@ TEST(source_sample_detector_path_factory_test, test_l1_paths) {
   EXPECT_EQ((*paths)[0][0], instrument.sourcePathIndex());
   EXPECT_EQ((*paths)[0][1], instrument.samplePathIndex());
   EXPECT_EQ((*paths)[0].size(), 2) << "Should have only 2 path entries for L1";
+  EXPECT_EQ(paths->uniqueSize(), 1) << "All detectors should share one path";
 }
 
 TEST(source_sample_detector_path_factory_test, test_l2_paths) {
@@ -63,4 +64,5 @@ TEST(source_sample_detector_path_factory_test, test_l2_paths) {
   EXPECT_EQ((*paths)[0][0], instrument.samplePathIndex());
   EXPECT_EQ((*paths)[0].size(), 1) << "Should have only 1 path entries for L2. "
                                       "Detector indexes are not counted";
+  EXPECT_EQ(paths->uniqueSize(), 1) << "All detectors should share one path";
 }
@@ -70,9 +70,10 @@ TEST(spectrum_info_test, test_l2) {
       std::make_shared<testing::NiceMock<MockFlatTree>>(nDetectors);
 
   EXPECT_CALL(*instrument.get(), startPositions())
-      .WillRepeatedly(Return(std::vector<Eigen::Vector3d>{{0, 0, 40}}));
+      .WillRepeatedly(
+          ReturnRefOfCopy(std::vector<Eigen::Vector3d>{{0, 0, 40}}));
   EXPECT_CALL(*instrument.get(), detectorComponentIndexes())
-      .WillRepeatedly(testing::Return(std::vector<size_t>(1, 0)));
+      .WillRepeatedly(testing::ReturnRefOfCopy(std::vector<IndexType>(1, 0)));
 
   // Create a DetectorInfo around the Instrument
   DetectorInfoWithMockInstrument detectorInfo{
@@ -104,10 +105,10 @@ TEST(spectrum_info_test, test_l2_mapped) {
       std::make_shared<testing::NiceMock<MockFlatTree>>(nDetectors);
 
   EXPECT_CALL(*instrument.get(), startPositions())
-      .WillRepeatedly(
-          Return(std::vector<Eigen::Vector3d>{{0, 0, 40}, {0, 0, 30}}));
+      .WillRepeatedly(ReturnRefOfCopy(
+          std::vector<Eigen::Vector3d>{{0, 0, 40}, {0, 0, 30}}));
   EXPECT_CALL(*instrument.get(), detectorComponentIndexes())
-      .WillRepeatedly(testing::Return(std::vector<size_t>{0, 1}));
+      .WillRepeatedly(testing::ReturnRefOfCopy(std::vector<IndexType>{0, 1}));
 
   // Create a DetectorInfo around the Instrument
   DetectorInfoWithMockInstrument detectorInfo{
@@ -1,5 +1,7 @@
 #include "gtest/gtest.h"
 #include "Spectrum.h"
+#include <limits>
+#include <stdexcept>
 
 TEST(spectrum_test, test_move_construct_from_vector) {
 
@@ -63,3 +65,18 @@ TEST(spectrum_test, allow_duplicate_detector_ids) {
   // Im adding this to characterise the existing behaviour.
   Spectrum invalidSpectrum{1, 1};
 }
+
+TEST(spectrum_test, test_indexes_beyond_index_type_throw) {
+  if (maxIndex == std::numeric_limits<size_t>::max()) {
+    return; // Only COMPACT_INDEXES can overflow
+  }
+  const size_t tooLarge = maxIndex + 1;
+  EXPECT_THROW(Spectrum(std::vector<size_t>{1, tooLarge}),
+               std::invalid_argument);
+  EXPECT_THROW((Spectrum{1, tooLarge}), std::invalid_argument);
+  EXPECT_THROW(Spectrum(2, tooLarge), std::invalid_argument);
+  Spectrum spectrum{1};
+  EXPECT_THROW(spectrum = std::vector<size_t>{tooLarge},
+               std::invalid_argument);
+  EXPECT_EQ(spectrum, Spectrum{1}) << "Unchanged on failure";
+}